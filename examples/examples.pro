@@ -1,5 +1,5 @@
 TEMPLATE=subdirs
-SUBDIRS += qwidget-compositor qwindow-compositor
+SUBDIRS += qwidget-compositor qwindow-compositor selection-benchmark
 
 contains(QT_CONFIG, quick) {
     SUBDIRS += qml-compositor
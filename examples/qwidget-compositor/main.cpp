@@ -48,14 +48,12 @@
 #include <QTimer>
 #include <QPainter>
 #include <QMouseEvent>
-#include <QtCore/QLinkedList>
 
 #ifdef QT_COMPOSITOR_WAYLAND_GL
 #include <QOpenGLContext>
 #include <QGLWidget>
 #include <QtGui/private/qopengltexturecache_p.h>
 #include "textureblitter.h"
-#include <QOpenGLFunctions>
 #endif
 
 #include <QDebug>
@@ -71,7 +69,6 @@ public:
     QWidgetCompositor()
         : WaylandCompositor(windowHandle())
 #ifdef QT_COMPOSITOR_WAYLAND_GL
-        , m_surfaceCompositorFbo(0)
         , m_textureBlitter(0)
         , m_textureCache(0)
 #endif
@@ -130,83 +127,16 @@ protected:
         connect(surface, SIGNAL(destroyed(QObject *)), this, SLOT(surfaceDestroyed(QObject *)));
         connect(surface, SIGNAL(mapped()), this, SLOT(surfaceMapped()));
         connect(surface, SIGNAL(damaged(const QRect &)), this, SLOT(surfaceDamaged(const QRect &)));
+        connect(surface, SIGNAL(subSurfacesChanged()), this, SLOT(update()));
+        connect(surface, SIGNAL(posChanged()), this, SLOT(update()));
         update();
     }
 
 #ifdef QT_COMPOSITOR_WAYLAND_GL
-    GLuint composeSurface(WaylandSurface *surface) {
-        GLuint texture = 0;
-        QOpenGLFunctions *functions = QOpenGLContext::currentContext()->functions();
-
-        if (!m_surfaceCompositorFbo)
-            functions->glGenFramebuffers(1,&m_surfaceCompositorFbo);
-
-        functions->glBindFramebuffer(GL_FRAMEBUFFER, m_surfaceCompositorFbo);
-
-        if (surface->type() == WaylandSurface::Shm) {
-            texture = m_textureCache->bindTexture(context()->contextHandle(), surface->image());
-        } else {
-            texture = surface->texture(QOpenGLContext::currentContext());
-        }
-
-        functions->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                                           GL_TEXTURE_2D, texture, 0);
-        paintChildren(surface,surface);
-        functions->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                                           GL_TEXTURE_2D, 0, 0);
-
-        functions->glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        return texture;
-    }
-
-    void paintChildren(WaylandSurface *surface, WaylandSurface *window) {
-
-        if (surface->subSurfaces().size() == 0)
-            return;
-
-        QLinkedListIterator<WaylandSurface *> i(surface->subSurfaces());
-        while (i.hasNext()) {
-            WaylandSurface *subSurface = i.next();
-            QPointF p = subSurface->mapTo(window,QPoint(0,0));
-            QSize size = subSurface->size();
-            if (size.isValid()) {
-                GLuint texture = 0;
-                if (subSurface->type() == WaylandSurface::Texture) {
-                    texture = subSurface->texture(QOpenGLContext::currentContext());
-                } else if (surface->type() == WaylandSurface::Shm ) {
-                    texture = m_textureCache->bindTexture(context()->contextHandle(), surface->image());
-                }
-                m_textureBlitter->drawTexture(texture,QRect(p.toPoint(),size),window->size(),0,window->isYInverted(),subSurface->isYInverted());
-            }
-            paintChildren(subSurface,window);
-        }
-    }
-#else //hmmm, this is actually untested :(
-    QImage composeSurface(WaylandSurface *surface)
-    {
-        Q_ASSER(surface->type() == WaylandSurface::Shm);
-        QImage img = surface->image();
-        QPainter p(&img);
-        paintChildren(surface,p,surface);
-
-        return img;
-    }
-
-    void paintChildren(WaylandSurface *surface, QPainter *painter, WaylandSurface *window) {
-        if (surface->subSurfaces().size() == 0)
-            return;
-
-        QLinkedListIterator<WaylandSurface *> i(surface->subSurfaces());
-        while (i.hasNext()) {
-            WaylandSurface *subSurface = i.next();
-            QPoint p = subSurface->mapTo(window,QPoint(0,0));
-            QRect geo = subSurface->geometry();
-            geo.moveTo(p);
-            if (geo.isValid()) {
-                painter->drawImage(p,subSurface->image());
-            }
-            paintChildren(subSurface,painter,window);
-        }
+    GLuint textureForSurface(WaylandSurface *surface) {
+        if (surface->type() == WaylandSurface::Shm)
+            return m_textureCache->bindTexture(context()->contextHandle(), surface->image());
+        return surface->texture(QOpenGLContext::currentContext());
     }
 #endif //QT_COMPOSITOR_WAYLAND_GL
 
@@ -227,16 +157,21 @@ protected:
         }
         m_textureBlitter->bind();
 #endif
+        // Sub surfaces are drawn straight into the window, right after their parent
         for (int i = 0; i < m_surfaces.size(); ++i) {
+            WaylandSurface *window = m_surfaces.at(i);
+            const QList<WaylandSurface::RenderItem> items = window->renderList();
+            foreach (const WaylandSurface::RenderItem &item, items) {
+                if (!item.surface->size().isValid())
+                    continue;
+                QPoint pos = (window->pos() + item.pos).toPoint();
 #ifdef QT_COMPOSITOR_WAYLAND_GL
-            GLuint texture = composeSurface(m_surfaces.at(i));
-            WaylandSurface *surface = m_surfaces.at(i);
-            QRect geo(surface->pos().toPoint(),surface->size());
-            m_textureBlitter->drawTexture(texture,geo,size(),0,false,m_surfaces.at(i)->isYInverted());
+                QRect geo(pos,item.surface->size());
+                m_textureBlitter->drawTexture(textureForSurface(item.surface),geo,size(),0,false,item.surface->isYInverted());
 #else
-            QImage img = composeSurface(m_surfaces.at(i));
-            p.drawImage(m_surfaces.at(i)->geometry().topLeft(),img);
+                p.drawImage(pos,item.surface->image());
 #endif //QT_COMPOSITOR_WAYLAND_GL
+            }
         }
 
         if (!m_cursor.isNull())
@@ -366,7 +301,6 @@ private:
     QList<WaylandSurface *> m_surfaces;
 
 #ifdef QT_COMPOSITOR_WAYLAND_GL
-    GLuint m_surfaceCompositorFbo;
     TextureBlitter *m_textureBlitter;
     QOpenGLTextureCache *m_textureCache;
 #endif
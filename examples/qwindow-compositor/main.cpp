@@ -45,6 +45,22 @@
 #include <QStringList>
 #include <QScreen>
 #include <QSurfaceFormat>
+#include <QFile>
+#include <QScopedPointer>
+#include <QTimer>
+#include <QDebug>
+
+#include <QtCompositor/waylandinput.h>
+#include <QtCompositor/waylandinputrecorder.h>
+
+static QString argumentValue(const QString &name)
+{
+    QStringList arguments = QCoreApplication::arguments();
+    int index = arguments.indexOf(name);
+    if (index != -1 && index + 1 < arguments.size())
+        return arguments.at(index + 1);
+    return QString();
+}
 
 int main(int argc, char *argv[])
 {
@@ -69,5 +85,33 @@ int main(int argc, char *argv[])
 
     QWindowCompositor compositor(&window);
 
-    return app.exec();
+    // -record <file> writes all input to file, -replay <file> plays it back
+    // one second after startup, giving the clients time to show up, and
+    // quits when done. Run with QT_COMPOSITOR_LATENCY_PROBE=1 to get the
+    // input to display latency of the clients.
+    QFile recordFile(argumentValue(QLatin1String("-record")));
+    QScopedPointer<WaylandInputRecorder> recorder;
+    if (!recordFile.fileName().isEmpty()) {
+        if (recordFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            recorder.reset(new WaylandInputRecorder(&recordFile));
+            compositor.defaultInputDevice()->setRecorder(recorder.data());
+        } else {
+            qWarning() << "Cannot record to" << recordFile.fileName();
+        }
+    }
+
+    QFile replayFile(argumentValue(QLatin1String("-replay")));
+    WaylandInputReplay replay(compositor.defaultInputDevice());
+    if (!replayFile.fileName().isEmpty()) {
+        if (replayFile.open(QIODevice::ReadOnly) && replay.load(&replayFile)) {
+            QObject::connect(&replay, SIGNAL(finished()), &app, SLOT(quit()));
+            QTimer::singleShot(1000, &replay, SLOT(start()));
+        } else {
+            qWarning() << "Cannot replay" << replayFile.fileName();
+        }
+    }
+
+    int ret = app.exec();
+    compositor.defaultInputDevice()->setRecorder(0);
+    return ret;
 }
@@ -46,7 +46,6 @@
 #include <QGuiApplication>
 #include <QCursor>
 #include <QPixmap>
-#include <QLinkedList>
 
 #include <QtCompositor/waylandinput.h>
 
@@ -76,9 +75,6 @@ QWindowCompositor::QWindowCompositor(QOpenGLWindow *window)
     m_renderScheduler.setSingleShot(true);
     connect(&m_renderScheduler,SIGNAL(timeout()),this,SLOT(render()));
 
-    QOpenGLFunctions *functions = m_window->context()->functions();
-    functions->glGenFramebuffers(1, &m_surface_fbo);
-
     window->installEventFilter(this);
 
     setRetainedSelectionEnabled(true);
@@ -136,17 +132,33 @@ void QWindowCompositor::surfaceDamaged(WaylandSurface *surface, const QRect &rec
     m_renderScheduler.start(0);
 }
 
+void QWindowCompositor::scheduleRender()
+{
+    m_renderScheduler.start(0);
+}
+
 void QWindowCompositor::surfaceCreated(WaylandSurface *surface)
 {
     connect(surface, SIGNAL(destroyed(QObject *)), this, SLOT(surfaceDestroyed(QObject *)));
     connect(surface, SIGNAL(mapped()), this, SLOT(surfaceMapped()));
     connect(surface, SIGNAL(damaged(const QRect &)), this, SLOT(surfaceDamaged(const QRect &)));
+    connect(surface, SIGNAL(subSurfacesChanged()), this, SLOT(scheduleRender()));
+    connect(surface, SIGNAL(posChanged()), this, SLOT(scheduleRender()));
     m_renderScheduler.start(0);
 }
 
+// The window a sub surface belongs to
+static WaylandSurface *topLevelSurface(WaylandSurface *surface)
+{
+    while (surface->parentSurface())
+        surface = surface->parentSurface();
+    return surface;
+}
+
 QPointF QWindowCompositor::toSurface(WaylandSurface *surface, const QPointF &pos) const
 {
-    return pos - surface->pos();
+    WaylandSurface *window = topLevelSurface(surface);
+    return pos - window->pos() - surface->mapTo(window, QPointF());
 }
 
 void QWindowCompositor::changeCursor(const QImage &image, int hotspotX, int hotspotY)
@@ -163,65 +175,20 @@ void QWindowCompositor::changeCursor(const QImage &image, int hotspotX, int hots
 
 WaylandSurface *QWindowCompositor::surfaceAt(const QPoint &point, QPoint *local)
 {
-    for (int i = m_surfaces.size() - 1; i >= 0; --i) {
-        WaylandSurface *surface = m_surfaces.at(i);
-        QRect geo(surface->pos().toPoint(),surface->size());
-        if (geo.contains(point)) {
-            if (local)
-                *local = toSurface(surface, point).toPoint();
-            return surface;
-        }
-    }
-    return 0;
+    QPointF localF;
+    WaylandSurface *surface = WaylandCompositor::surfaceAt(point, &localF);
+    if (surface && local)
+        *local = localF.toPoint();
+    return surface;
 }
 
-GLuint QWindowCompositor::composeSurface(WaylandSurface *surface)
+GLuint QWindowCompositor::textureForSurface(WaylandSurface *surface)
 {
-    GLuint texture = 0;
-
-    QOpenGLFunctions *functions = QOpenGLContext::currentContext()->functions();
-    functions->glBindFramebuffer(GL_FRAMEBUFFER, m_surface_fbo);
-
-    if (surface->type() == WaylandSurface::Shm) {
-        texture = m_textureCache->bindTexture(QOpenGLContext::currentContext(),surface->image());
-    } else {
-        texture = surface->texture(QOpenGLContext::currentContext());
-    }
-
-    functions->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                                       GL_TEXTURE_2D, texture, 0);
-    paintChildren(surface,surface);
-    functions->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                                       GL_TEXTURE_2D,0, 0);
-
-    functions->glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    return texture;
+    if (surface->type() == WaylandSurface::Shm)
+        return m_textureCache->bindTexture(QOpenGLContext::currentContext(),surface->image());
+    return surface->texture(QOpenGLContext::currentContext());
 }
 
-void QWindowCompositor::paintChildren(WaylandSurface *surface, WaylandSurface *window) {
-
-    if (surface->subSurfaces().size() == 0)
-        return;
-
-    QLinkedListIterator<WaylandSurface *> i(surface->subSurfaces());
-    while (i.hasNext()) {
-        WaylandSurface *subSurface = i.next();
-        QPointF p = subSurface->mapTo(window,QPointF(0,0));
-        if (subSurface->size().isValid()) {
-            GLuint texture = 0;
-            if (subSurface->type() == WaylandSurface::Texture) {
-                texture = subSurface->texture(QOpenGLContext::currentContext());
-            } else if (surface->type() == WaylandSurface::Shm ) {
-                texture = m_textureCache->bindTexture(QOpenGLContext::currentContext(),surface->image());
-            }
-            QRect geo(p.toPoint(),subSurface->size());
-            m_textureBlitter->drawTexture(texture,geo,window->size(),0,window->isYInverted(),subSurface->isYInverted());
-        }
-        paintChildren(subSurface,window);
-    }
-}
-
-
 void QWindowCompositor::render()
 {
     m_window->makeCurrent();
@@ -238,10 +205,16 @@ void QWindowCompositor::render()
         }
     }
 
+    // Sub surfaces are drawn straight into the window, right after their parent
     foreach (WaylandSurface *surface, m_surfaces) {
-        GLuint texture = composeSurface(surface);
-        QRect geo(surface->pos().toPoint(),surface->size());
-        m_textureBlitter->drawTexture(texture,geo,m_window->size(),0,false,surface->isYInverted());
+        const QList<WaylandSurface::RenderItem> items = surface->renderList();
+        foreach (const WaylandSurface::RenderItem &item, items) {
+            if (!item.surface->size().isValid())
+                continue;
+            GLuint texture = textureForSurface(item.surface);
+            QRect geo((surface->pos() + item.pos).toPoint(),item.surface->size());
+            m_textureBlitter->drawTexture(texture,geo,m_window->size(),0,false,item.surface->isYInverted());
+        }
     }
 
     m_textureBlitter->release();
@@ -267,14 +240,16 @@ bool QWindowCompositor::eventFilter(QObject *obj, QEvent *event)
         QMouseEvent *me = static_cast<QMouseEvent *>(event);
         WaylandSurface *targetSurface = surfaceAt(me->pos(), &local);
         if (targetSurface) {
+            WaylandSurface *window = topLevelSurface(targetSurface);
             if (m_dragKeyIsPressed) {
-               m_draggingWindow = targetSurface;
-               m_drag_diff = local;
+               m_draggingWindow = window;
+               m_drag_diff = (me->posF() - window->pos()).toPoint();
             } else {
-                if (input->keyboardFocus() != targetSurface) {
-                    input->setKeyboardFocus(targetSurface);
-                    m_surfaces.removeOne(targetSurface);
-                    m_surfaces.append(targetSurface);
+                if (input->keyboardFocus() != window) {
+                    input->setKeyboardFocus(window);
+                    m_surfaces.removeOne(window);
+                    m_surfaces.append(window);
+                    raiseSurface(window);
                     m_renderScheduler.start(0);
                 }
                 input->sendMousePressEvent(me->button(),local,me->pos());
@@ -333,12 +308,13 @@ bool QWindowCompositor::eventFilter(QObject *obj, QEvent *event)
         QTouchEvent *te = static_cast<QTouchEvent *>(event);
         QList<QTouchEvent::TouchPoint> points = te->touchPoints();
         QPoint pointPos;
+        QPoint local;
         if (!points.isEmpty()) {
             pointPos = points.at(0).pos().toPoint();
-            targetSurface = surfaceAt(pointPos);
+            targetSurface = surfaceAt(pointPos, &local);
         }
         if (targetSurface && targetSurface != input->mouseFocus())
-            input->setMouseFocus(targetSurface, pointPos, pointPos);
+            input->setMouseFocus(targetSurface, local, pointPos);
         if (input->mouseFocus())
             input->sendFullTouchEvent(te);
         break;
@@ -61,6 +61,7 @@ private slots:
     void surfaceDestroyed(QObject *object);
     void surfaceMapped();
     void surfaceDamaged(const QRect &rect);
+    void scheduleRender();
 
     void render();
 protected:
@@ -69,9 +70,7 @@ protected:
 
     WaylandSurface* surfaceAt(const QPoint &point, QPoint *local = 0);
 
-    GLuint composeSurface(WaylandSurface *surface);
-    void paintChildren(WaylandSurface *surface, WaylandSurface *window);
-
+    GLuint textureForSurface(WaylandSurface *surface);
 
     bool eventFilter(QObject *obj, QEvent *event);
     QPointF toSurface(WaylandSurface *surface, const QPointF &pos) const;
@@ -85,7 +84,6 @@ private:
     QList<WaylandSurface *> m_surfaces;
     TextureBlitter *m_textureBlitter;
     QOpenGLTextureCache *m_textureCache;
-    GLuint m_surface_fbo;
     QTimer m_renderScheduler;
 
     //Dragging windows around
@@ -0,0 +1,322 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the Qt Compositor.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Nokia Corporation and its Subsidiary(-ies) nor
+**     the names of its contributors may be used to endorse or promote
+**     products derived from this software without specific prior written
+**     permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "benchmarkclient.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <wayland-client-protocol.h>
+
+// Writes the payload from the pool, like a client that does not block its
+// event loop while the paste is going on
+class PayloadWriter : public QRunnable
+{
+public:
+    PayloadWriter(int fd, const QByteArray &payload)
+        : m_fd(fd), m_payload(payload)
+    {
+    }
+
+    void run()
+    {
+        const char *data = m_payload.constData();
+        qint64 left = m_payload.size();
+        while (left > 0) {
+            ssize_t n = ::write(m_fd, data, left);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            data += n;
+            left -= n;
+        }
+        ::close(m_fd);
+    }
+
+private:
+    int m_fd;
+    QByteArray m_payload;
+};
+
+static int dummyUpdate(uint32_t, void *)
+{
+    return 0;
+}
+
+BenchmarkClient::BenchmarkClient()
+    : m_display(0)
+    , m_compositor(0)
+    , m_inputDevice(0)
+    , m_dataDeviceManager(0)
+    , m_dataDevice(0)
+    , m_surface(0)
+    , m_fd(-1)
+    , m_source(0)
+    , m_sendCount(0)
+    , m_time(0)
+    , m_selectionOffer(0)
+    , m_selectionTime(0)
+{
+}
+
+qint64 BenchmarkClient::now()
+{
+    static QElapsedTimer clock;
+    if (!clock.isValid())
+        clock.start();
+    return clock.nsecsElapsed() / 1000;
+}
+
+bool BenchmarkClient::connectToCompositor(const char *socketName)
+{
+    m_display = wl_display_connect(socketName);
+    if (!m_display)
+        return false;
+
+    wl_display_add_global_listener(m_display, handleGlobal, this);
+    m_fd = wl_display_get_fd(m_display, dummyUpdate, 0);
+    roundtrip();
+    if (!m_compositor || !m_inputDevice || !m_dataDeviceManager)
+        return false;
+
+    m_dataDevice = wl_data_device_manager_get_data_device(m_dataDeviceManager, m_inputDevice);
+    wl_data_device_add_listener(m_dataDevice, &dataDeviceListener, this);
+
+    // The selection only goes to clients having a surface with keyboard focus
+    m_surface = wl_compositor_create_surface(m_compositor);
+    roundtrip();
+    return true;
+}
+
+void BenchmarkClient::handleGlobal(struct wl_display *display, uint32_t id,
+                                   const char *interface, uint32_t version, void *data)
+{
+    Q_UNUSED(version);
+    BenchmarkClient *self = static_cast<BenchmarkClient *>(data);
+    if (strcmp(interface, "wl_compositor") == 0) {
+        self->m_compositor = static_cast<struct wl_compositor *>(wl_display_bind(display, id, &wl_compositor_interface));
+    } else if (strcmp(interface, "wl_input_device") == 0 && !self->m_inputDevice) {
+        self->m_inputDevice = static_cast<struct wl_input_device *>(wl_display_bind(display, id, &wl_input_device_interface));
+    } else if (strcmp(interface, "wl_data_device_manager") == 0) {
+        self->m_dataDeviceManager = static_cast<struct wl_data_device_manager *>(wl_display_bind(display, id, &wl_data_device_manager_interface));
+    }
+}
+
+void BenchmarkClient::dispatch(int timeoutMsecs)
+{
+    wl_display_flush(m_display);
+    struct pollfd pfd = { m_fd, POLLIN, 0 };
+    if (poll(&pfd, 1, timeoutMsecs) > 0)
+        wl_display_iterate(m_display, WL_DISPLAY_READABLE);
+}
+
+void BenchmarkClient::roundtrip()
+{
+    wl_display_roundtrip(m_display);
+}
+
+// Selections older than the current one are dropped by the compositor, so
+// the times have to go up even for sets within the same millisecond
+uint32_t BenchmarkClient::nextTime()
+{
+    m_time = qMax<uint32_t>(m_time + 1, uint32_t(now() / 1000));
+    return m_time;
+}
+
+void BenchmarkClient::setSelection(const QByteArray &mimeType, const QByteArray &payload)
+{
+    clearSelection();
+    m_payload = payload;
+    m_source = wl_data_device_manager_create_data_source(m_dataDeviceManager);
+    wl_data_source_add_listener(m_source, &dataSourceListener, this);
+    wl_data_source_offer(m_source, mimeType.constData());
+    wl_data_device_set_selection(m_dataDevice, m_source, nextTime());
+    wl_display_flush(m_display);
+}
+
+void BenchmarkClient::clearSelection()
+{
+    if (!m_source)
+        return;
+    wl_data_source_destroy(m_source);
+    m_source = 0;
+    m_payload.clear();
+    wl_display_flush(m_display);
+}
+
+bool BenchmarkClient::waitForSelection(int timeoutMsecs)
+{
+    qint64 deadline = now() + qint64(timeoutMsecs) * 1000;
+    while (!m_selectionOffer && now() < deadline)
+        dispatch(10);
+    return m_selectionOffer != 0;
+}
+
+void BenchmarkClient::resetSelection()
+{
+    if (m_selectionOffer)
+        wl_data_offer_destroy(m_selectionOffer);
+    m_selectionOffer = 0;
+    m_selectionTime = 0;
+    wl_display_flush(m_display);
+}
+
+bool BenchmarkClient::receive(const QByteArray &mimeType, Transfer *transfer, BenchmarkClient *source)
+{
+    memset(transfer, 0, sizeof(Transfer));
+    if (!m_selectionOffer)
+        return false;
+
+    int fds[2];
+    if (pipe(fds) == -1)
+        return false;
+
+    int sends = source ? source->sendCount() : 0;
+    transfer->requested = now();
+    wl_data_offer_receive(m_selectionOffer, mimeType.constData(), fds[1]);
+    ::close(fds[1]);
+    wl_display_flush(m_display);
+
+    if (source) {
+        qint64 deadline = now() + 5000000;
+        while (source->sendCount() == sends && now() < deadline)
+            source->dispatch(10);
+    }
+
+    char buffer[65536];
+    for (;;) {
+        struct pollfd pfd = { fds[0], POLLIN, 0 };
+        if (poll(&pfd, 1, 10000) <= 0)
+            break;
+        ssize_t n = ::read(fds[0], buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            transfer->done = now();
+            break;
+        }
+        if (!transfer->bytes)
+            transfer->firstByte = now();
+        transfer->bytes += n;
+    }
+    ::close(fds[0]);
+    return transfer->done != 0;
+}
+
+void BenchmarkClient::dataOffer(void *data, struct wl_data_device *device, uint32_t id)
+{
+    struct wl_proxy *proxy = wl_proxy_create_for_id(reinterpret_cast<struct wl_proxy *>(device),
+                                                    id, &wl_data_offer_interface);
+    wl_data_offer_add_listener(reinterpret_cast<struct wl_data_offer *>(proxy), &dataOfferListener, data);
+}
+
+void BenchmarkClient::enter(void *, struct wl_data_device *, uint32_t,
+                            struct wl_surface *, int32_t, int32_t, struct wl_data_offer *)
+{
+}
+
+void BenchmarkClient::leave(void *, struct wl_data_device *)
+{
+}
+
+void BenchmarkClient::motion(void *, struct wl_data_device *, uint32_t, int32_t, int32_t)
+{
+}
+
+void BenchmarkClient::drop(void *, struct wl_data_device *)
+{
+}
+
+void BenchmarkClient::selection(void *data, struct wl_data_device *device, struct wl_data_offer *id)
+{
+    Q_UNUSED(device);
+    BenchmarkClient *self = static_cast<BenchmarkClient *>(data);
+    if (self->m_selectionOffer && self->m_selectionOffer != id)
+        wl_data_offer_destroy(self->m_selectionOffer);
+    self->m_selectionOffer = id;
+    self->m_selectionTime = now();
+}
+
+const struct wl_data_device_listener BenchmarkClient::dataDeviceListener = {
+    BenchmarkClient::dataOffer,
+    BenchmarkClient::enter,
+    BenchmarkClient::leave,
+    BenchmarkClient::motion,
+    BenchmarkClient::drop,
+    BenchmarkClient::selection
+};
+
+void BenchmarkClient::offer(void *, struct wl_data_offer *, const char *)
+{
+}
+
+const struct wl_data_offer_listener BenchmarkClient::dataOfferListener = {
+    BenchmarkClient::offer
+};
+
+void BenchmarkClient::target(void *, struct wl_data_source *, const char *)
+{
+}
+
+void BenchmarkClient::send(void *data, struct wl_data_source *source, const char *mimeType, int32_t fd)
+{
+    Q_UNUSED(source);
+    Q_UNUSED(mimeType);
+    BenchmarkClient *self = static_cast<BenchmarkClient *>(data);
+    ++self->m_sendCount;
+    QThreadPool::globalInstance()->start(new PayloadWriter(fd, self->m_payload));
+}
+
+void BenchmarkClient::cancelled(void *, struct wl_data_source *)
+{
+}
+
+const struct wl_data_source_listener BenchmarkClient::dataSourceListener = {
+    BenchmarkClient::target,
+    BenchmarkClient::send,
+    BenchmarkClient::cancelled
+};
@@ -0,0 +1,123 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the Qt Compositor.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Nokia Corporation and its Subsidiary(-ies) nor
+**     the names of its contributors may be used to endorse or promote
+**     products derived from this software without specific prior written
+**     permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef BENCHMARKCLIENT_H
+#define BENCHMARKCLIENT_H
+
+#include <QtCore/QByteArray>
+
+#include <wayland-client.h>
+
+// A bare wayland client using the data device directly, so that only the
+// transfer paths of the compositor are measured and not the ones of the
+// platform plugin. All of it runs on the thread that connected.
+class BenchmarkClient
+{
+public:
+    BenchmarkClient();
+
+    bool connectToCompositor(const char *socketName);
+
+    // Microseconds on a clock shared by the compositor and the clients
+    static qint64 now();
+
+    void dispatch(int timeoutMsecs);
+    void roundtrip();
+
+    void setSelection(const QByteArray &mimeType, const QByteArray &payload);
+    void clearSelection();
+    int sendCount() const { return m_sendCount; }
+
+    bool waitForSelection(int timeoutMsecs);
+    qint64 selectionTime() const { return m_selectionTime; }
+    void resetSelection();
+
+    struct Transfer {
+        qint64 requested;
+        qint64 firstByte;
+        qint64 done;
+        qint64 bytes;
+    };
+
+    // Reads mimeType from the current selection. A source client in the
+    // same thread has to be given, it needs to see the send request.
+    bool receive(const QByteArray &mimeType, Transfer *transfer, BenchmarkClient *source = 0);
+
+private:
+    struct wl_display *m_display;
+    struct wl_compositor *m_compositor;
+    struct wl_input_device *m_inputDevice;
+    struct wl_data_device_manager *m_dataDeviceManager;
+    struct wl_data_device *m_dataDevice;
+    struct wl_surface *m_surface;
+    int m_fd;
+
+    struct wl_data_source *m_source;
+    QByteArray m_payload;
+    int m_sendCount;
+    uint32_t m_time;
+
+    struct wl_data_offer *m_selectionOffer;
+    qint64 m_selectionTime;
+
+    uint32_t nextTime();
+
+    static void handleGlobal(struct wl_display *display, uint32_t id,
+                             const char *interface, uint32_t version, void *data);
+
+    static void dataOffer(void *data, struct wl_data_device *device, uint32_t id);
+    static void enter(void *data, struct wl_data_device *device, uint32_t time,
+                      struct wl_surface *surface, int32_t x, int32_t y, struct wl_data_offer *id);
+    static void leave(void *data, struct wl_data_device *device);
+    static void motion(void *data, struct wl_data_device *device, uint32_t time, int32_t x, int32_t y);
+    static void drop(void *data, struct wl_data_device *device);
+    static void selection(void *data, struct wl_data_device *device, struct wl_data_offer *id);
+    static const struct wl_data_device_listener dataDeviceListener;
+
+    static void offer(void *data, struct wl_data_offer *offer, const char *type);
+    static const struct wl_data_offer_listener dataOfferListener;
+
+    static void target(void *data, struct wl_data_source *source, const char *mimeType);
+    static void send(void *data, struct wl_data_source *source, const char *mimeType, int32_t fd);
+    static void cancelled(void *data, struct wl_data_source *source);
+    static const struct wl_data_source_listener dataSourceListener;
+};
+
+#endif // BENCHMARKCLIENT_H
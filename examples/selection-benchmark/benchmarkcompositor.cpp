@@ -0,0 +1,116 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the Qt Compositor.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Nokia Corporation and its Subsidiary(-ies) nor
+**     the names of its contributors may be used to endorse or promote
+**     products derived from this software without specific prior written
+**     permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "benchmarkcompositor.h"
+#include "benchmarkclient.h"
+
+#include "waylandinput.h"
+#include "waylandsurface.h"
+
+#include <QtCore/QMimeData>
+
+BenchmarkCompositor::BenchmarkCompositor(const char *socketName)
+    : WaylandCompositor(0, socketName)
+    , m_retained(false)
+    , m_retainedTime(0)
+{
+}
+
+void BenchmarkCompositor::surfaceCreated(WaylandSurface *surface)
+{
+    m_surfaces.append(surface);
+}
+
+void BenchmarkCompositor::surfaceAboutToBeDestroyed(WaylandSurface *surface)
+{
+    m_surfaces.removeOne(surface);
+}
+
+void BenchmarkCompositor::retainedSelectionReceived(QMimeData *mimeData)
+{
+    Q_UNUSED(mimeData);
+    // Overriding the selection reports the new data here as well
+    QMutexLocker locker(&m_mutex);
+    if (m_retained)
+        m_retainedTime = BenchmarkClient::now();
+}
+
+qint64 BenchmarkCompositor::retainedTime() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_retainedTime;
+}
+
+void BenchmarkCompositor::focusLastSurface()
+{
+    if (!m_surfaces.isEmpty())
+        defaultInputDevice()->setKeyboardFocus(m_surfaces.last());
+}
+
+// Clients are offered a changed selection when they get focus
+void BenchmarkCompositor::refocus()
+{
+    WaylandSurface *focus = defaultInputDevice()->keyboardFocus();
+    defaultInputDevice()->setKeyboardFocus(0);
+    defaultInputDevice()->setKeyboardFocus(focus);
+}
+
+void BenchmarkCompositor::setRetained(bool retained)
+{
+    QMutexLocker locker(&m_mutex);
+    m_retained = retained;
+    m_retainedTime = 0;
+    setRetainedSelectionEnabled(retained);
+    setRetainedSelectionPolicy(RetainAllTypes);
+}
+
+void BenchmarkCompositor::override(const QByteArray &mimeType, const QByteArray &payload)
+{
+    QMimeData mimeData;
+    mimeData.setData(QString::fromLatin1(mimeType), payload);
+    overrideSelection(&mimeData);
+}
+
+void BenchmarkCompositor::overrideImage(const QImage &image)
+{
+    QMimeData mimeData;
+    mimeData.setImageData(image);
+    overrideSelection(&mimeData);
+}
@@ -0,0 +1,80 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the Qt Compositor.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Nokia Corporation and its Subsidiary(-ies) nor
+**     the names of its contributors may be used to endorse or promote
+**     products derived from this software without specific prior written
+**     permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef BENCHMARKCOMPOSITOR_H
+#define BENCHMARKCOMPOSITOR_H
+
+#include "waylandcompositor.h"
+
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtGui/QImage>
+
+// A compositor without any output, the benchmark thread drives it through
+// queued calls to the slots below.
+class BenchmarkCompositor : public QObject, public WaylandCompositor
+{
+    Q_OBJECT
+public:
+    BenchmarkCompositor(const char *socketName);
+
+    void surfaceCreated(WaylandSurface *surface);
+    void surfaceAboutToBeDestroyed(WaylandSurface *surface);
+    void retainedSelectionReceived(QMimeData *mimeData);
+
+    // When the last retained selection was complete, 0 before that
+    qint64 retainedTime() const;
+
+public slots:
+    void focusLastSurface();
+    void refocus();
+    void setRetained(bool retained);
+    void override(const QByteArray &mimeType, const QByteArray &payload);
+    void overrideImage(const QImage &image);
+
+private:
+    QList<WaylandSurface *> m_surfaces;
+    bool m_retained;
+    mutable QMutex m_mutex;
+    qint64 m_retainedTime;
+};
+
+#endif // BENCHMARKCOMPOSITOR_H
@@ -0,0 +1,94 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the Qt Compositor.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Nokia Corporation and its Subsidiary(-ies) nor
+**     the names of its contributors may be used to endorse or promote
+**     products derived from this software without specific prior written
+**     permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "benchmarkcompositor.h"
+#include "selectionbenchmark.h"
+
+#include <QGuiApplication>
+#include <QStringList>
+
+#include <signal.h>
+#include <unistd.h>
+
+static QString argumentValue(const QString &name)
+{
+    QStringList arguments = QCoreApplication::arguments();
+    int index = arguments.indexOf(name);
+    if (index != -1 && index + 1 < arguments.size())
+        return arguments.at(index + 1);
+    return QString();
+}
+
+// Measures copy and paste between two clients, from the retained copy and
+// from a selection set by the compositor. Payloads of 1 MB and more are
+// also pasted from an image selection, which the compositor has to convert
+// once and then serves from its cache. No window is shown, run it with
+// e.g. -platform minimal. -sizes takes a comma separated list of payload
+// sizes in bytes, -repeat the number of runs the medians are taken from.
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+    signal(SIGPIPE, SIG_IGN);
+
+    QList<int> sizes;
+    foreach (const QString &size, argumentValue(QLatin1String("-sizes")).split(QLatin1Char(','), QString::SkipEmptyParts))
+        sizes.append(size.toInt());
+    if (sizes.isEmpty())
+        sizes << 1024 << 64 * 1024 << 1024 * 1024 << 10 * 1024 * 1024 << 50 * 1024 * 1024;
+
+    int repeat = argumentValue(QLatin1String("-repeat")).toInt();
+    if (repeat <= 0)
+        repeat = 5;
+
+    QByteArray socketName = "selection-benchmark-" + QByteArray::number(getpid());
+
+    // libwayland-client and libwayland-server both export wl_display_destroy,
+    // so neither the compositor nor the clients are torn down; the process
+    // just exits when done.
+    BenchmarkCompositor *compositor = new BenchmarkCompositor(socketName.constData());
+
+    SelectionBenchmark benchmark(compositor, socketName, sizes, repeat);
+    QObject::connect(&benchmark, SIGNAL(finished()), &app, SLOT(quit()));
+    benchmark.start();
+    app.exec();
+    benchmark.wait();
+
+    return benchmark.succeeded() ? 0 : 1;
+}
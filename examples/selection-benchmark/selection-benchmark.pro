@@ -0,0 +1,35 @@
+QT += gui gui-private core-private compositor
+
+# comment out the following to not use pkg-config in the pri files
+CONFIG += use_pkgconfig
+
+# to make QtCompositor/... style includes working without installing
+INCLUDEPATH += $$PWD/../../include
+
+#  if you want to compile QtCompositor as part of the application
+#  instead of linking to it, remove the QT += compositor and uncomment
+#  the following line
+#include(../../src/compositor/compositor.pri)
+
+# The clients talk to the compositor with the plain client library
+!contains(QT_CONFIG, no-pkg-config) {
+    QMAKE_CFLAGS_WAYLAND_CLIENT=$$system(pkg-config --cflags wayland-client 2>/dev/null)
+    QMAKE_LIBS_WAYLAND_CLIENT=$$system(pkg-config --libs wayland-client 2>/dev/null)
+}
+QMAKE_CXXFLAGS += $$QMAKE_CFLAGS_WAYLAND_CLIENT
+LIBS += $$QMAKE_LIBS_WAYLAND_CLIENT
+
+HEADERS += \
+    benchmarkclient.h \
+    benchmarkcompositor.h \
+    selectionbenchmark.h
+
+SOURCES += main.cpp \
+    benchmarkclient.cpp \
+    benchmarkcompositor.cpp \
+    selectionbenchmark.cpp
+
+target.path = $$[QT_INSTALL_EXAMPLES]/qtwayland/selection-benchmark
+sources.files = $$SOURCES $$HEADERS selection-benchmark.pro
+sources.path = $$[QT_INSTALL_EXAMPLES]/qtwayland/selection-benchmark
+INSTALLS += target sources
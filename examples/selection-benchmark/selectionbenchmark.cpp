@@ -0,0 +1,245 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the Qt Compositor.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Nokia Corporation and its Subsidiary(-ies) nor
+**     the names of its contributors may be used to endorse or promote
+**     products derived from this software without specific prior written
+**     permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "selectionbenchmark.h"
+#include "benchmarkcompositor.h"
+
+#include <QtCore/QMetaObject>
+#include <QtGui/QImage>
+
+#include <algorithm>
+#include <stdio.h>
+
+SelectionBenchmark::SelectionBenchmark(BenchmarkCompositor *compositor, const QByteArray &socketName,
+                                       const QList<int> &sizes, int repeat)
+    : m_compositor(compositor)
+    , m_socketName(socketName)
+    , m_sizes(sizes)
+    , m_repeat(qMax(1, repeat))
+    , m_succeeded(false)
+{
+}
+
+// An image of about size bytes, with enough detail that encoding it is
+// not trivial
+static QImage createImage(int size)
+{
+    const int width = 1024;
+    QImage image(width, qMax(1, size / (width * 4)), QImage::Format_ARGB32);
+    quint32 seed = 1;
+    for (int y = 0; y < image.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            seed = seed * 1103515245 + 12345;
+            line[x] = qRgba(x, y, (x ^ y) + (seed >> 28), 255);
+        }
+    }
+    return image;
+}
+
+void SelectionBenchmark::run()
+{
+    // The target connects last, so its surface is the one getting focus
+    if (!m_source.connectToCompositor(m_socketName.constData())
+            || !m_target.connectToCompositor(m_socketName.constData())) {
+        fprintf(stderr, "Cannot connect to the compositor\n");
+        return;
+    }
+    QMetaObject::invokeMethod(m_compositor, "focusLastSurface", Qt::BlockingQueuedConnection);
+
+    printf("%-10s %10s %10s %10s %10s %10s %10s %10s\n",
+           "path", "bytes", "source", "offer", "first", "transfer", "total", "MB/s");
+
+    foreach (int size, m_sizes) {
+        // Small payloads stand for text, large ones are sent as raw data and
+        // as an image the compositor has to convert
+        QByteArray mimeType = size < 1024 * 1024 ? "text/plain;charset=utf-8" : "application/octet-stream";
+        QByteArray payload(size, Qt::Uninitialized);
+        for (int i = 0; i < size; ++i)
+            payload[i] = char('a' + i % 26);
+        QImage image;
+        if (size >= 1024 * 1024)
+            image = createImage(size);
+
+        for (int path = DirectPath; path <= CachedImagePath; ++path) {
+            bool imagePath = path == ImagePath || path == CachedImagePath;
+            if (imagePath && image.isNull())
+                continue;
+            QList<Result> results;
+            for (int i = 0; i < m_repeat; ++i) {
+                Result result;
+                bool ok = imagePath ? measureImage(Path(path), image, &result)
+                                    : measure(Path(path), mimeType, payload, &result);
+                if (!ok) {
+                    fprintf(stderr, "Transfer of %d bytes failed\n", size);
+                    return;
+                }
+                results.append(result);
+            }
+            report(Path(path), imagePath ? image.byteCount() : size, results);
+        }
+    }
+
+    m_succeeded = true;
+}
+
+bool SelectionBenchmark::measure(Path path, const QByteArray &mimeType, const QByteArray &payload, Result *result)
+{
+    m_target.resetSelection();
+    QMetaObject::invokeMethod(m_compositor, "setRetained", Qt::BlockingQueuedConnection,
+                              Q_ARG(bool, path == RetainedPath));
+
+    qint64 start = BenchmarkClient::now();
+    switch (path) {
+    case DirectPath:
+        m_source.setSelection(mimeType, payload);
+        m_source.roundtrip();
+        result->source = BenchmarkClient::now() - start;
+        break;
+    case RetainedPath: {
+        m_source.setSelection(mimeType, payload);
+        // The source has to answer the compositor's reads meanwhile
+        qint64 deadline = start + 30000000;
+        while (!m_compositor->retainedTime() && BenchmarkClient::now() < deadline)
+            m_source.dispatch(10);
+        if (!m_compositor->retainedTime())
+            return false;
+        result->source = m_compositor->retainedTime() - start;
+        // Only the retained copy is left to paste from
+        m_source.clearSelection();
+        m_source.roundtrip();
+        break;
+    }
+    case CompositorPath:
+        m_source.clearSelection();
+        m_source.roundtrip();
+        start = BenchmarkClient::now();
+        QMetaObject::invokeMethod(m_compositor, "override", Qt::BlockingQueuedConnection,
+                                  Q_ARG(QByteArray, mimeType), Q_ARG(QByteArray, payload));
+        result->source = BenchmarkClient::now() - start;
+        break;
+    }
+
+    // Overriding already sent the selection to the focused client
+    qint64 offerStart = BenchmarkClient::now();
+    if (path != CompositorPath)
+        QMetaObject::invokeMethod(m_compositor, "refocus", Qt::BlockingQueuedConnection);
+    if (!m_target.waitForSelection(5000))
+        return false;
+    result->offer = qMax<qint64>(0, m_target.selectionTime() - offerStart);
+
+    BenchmarkClient::Transfer transfer;
+    if (!m_target.receive(mimeType, &transfer, path == DirectPath ? &m_source : 0)
+            || transfer.bytes != payload.size())
+        return false;
+    result->firstByte = transfer.firstByte - transfer.requested;
+    result->transfer = transfer.done - transfer.firstByte;
+    result->bytes = transfer.bytes;
+    return true;
+}
+
+// The compositor owns the selection as a QImage, a paste of it is encoded
+// on a worker thread the first time and then served from the cache
+bool SelectionBenchmark::measureImage(Path path, const QImage &image, Result *result)
+{
+    static const QByteArray mimeType("application/x-qt-image");
+
+    m_target.resetSelection();
+    QMetaObject::invokeMethod(m_compositor, "setRetained", Qt::BlockingQueuedConnection,
+                              Q_ARG(bool, false));
+    m_source.clearSelection();
+    m_source.roundtrip();
+
+    qint64 start = BenchmarkClient::now();
+    QMetaObject::invokeMethod(m_compositor, "overrideImage", Qt::BlockingQueuedConnection,
+                              Q_ARG(QImage, image));
+    result->source = BenchmarkClient::now() - start;
+
+    qint64 offerStart = BenchmarkClient::now();
+    if (!m_target.waitForSelection(5000))
+        return false;
+    result->offer = qMax<qint64>(0, m_target.selectionTime() - offerStart);
+
+    BenchmarkClient::Transfer transfer;
+    if (!m_target.receive(mimeType, &transfer) || !transfer.bytes)
+        return false;
+    if (path == CachedImagePath) {
+        // Only the second paste is timed
+        if (!m_target.receive(mimeType, &transfer) || !transfer.bytes)
+            return false;
+        result->source = 0;
+        result->offer = 0;
+    }
+    result->firstByte = transfer.firstByte - transfer.requested;
+    result->transfer = transfer.done - transfer.firstByte;
+    result->bytes = transfer.bytes;
+    return true;
+}
+
+static qint64 median(QList<qint64> values)
+{
+    std::sort(values.begin(), values.end());
+    return values.at(values.size() / 2);
+}
+
+// Prints the median of each phase in milliseconds
+void SelectionBenchmark::report(Path path, int size, const QList<Result> &results)
+{
+    static const char *const names[] = { "direct", "retained", "compositor", "image", "cached" };
+
+    QList<qint64> source, offer, firstByte, transfer, total, bytes;
+    foreach (const Result &result, results) {
+        source.append(result.source);
+        offer.append(result.offer);
+        firstByte.append(result.firstByte);
+        transfer.append(result.transfer);
+        total.append(result.source + result.offer + result.firstByte + result.transfer);
+        bytes.append(result.bytes);
+    }
+
+    // Converted images are not as large as the pixels they were made from
+    qint64 transferTime = median(firstByte) + median(transfer);
+    double throughput = transferTime > 0 ? double(median(bytes)) / transferTime : 0;
+    printf("%-10s %10d %10.3f %10.3f %10.3f %10.3f %10.3f %10.1f\n",
+           names[path], size,
+           median(source) / 1000.0, median(offer) / 1000.0, median(firstByte) / 1000.0,
+           median(transfer) / 1000.0, median(total) / 1000.0, throughput);
+    fflush(stdout);
+}
@@ -0,0 +1,98 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the Qt Compositor.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Nokia Corporation and its Subsidiary(-ies) nor
+**     the names of its contributors may be used to endorse or promote
+**     products derived from this software without specific prior written
+**     permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef SELECTIONBENCHMARK_H
+#define SELECTIONBENCHMARK_H
+
+#include "benchmarkclient.h"
+
+#include <QtCore/QList>
+#include <QtCore/QThread>
+
+class BenchmarkCompositor;
+class QImage;
+
+// Runs the source and the target client and measures each transfer path
+// of the compositor, one phase at a time, so that a regression shows up
+// in the phase that caused it.
+class SelectionBenchmark : public QThread
+{
+    Q_OBJECT
+public:
+    SelectionBenchmark(BenchmarkCompositor *compositor, const QByteArray &socketName,
+                       const QList<int> &sizes, int repeat);
+
+    bool succeeded() const { return m_succeeded; }
+
+protected:
+    void run();
+
+private:
+    enum Path {
+        DirectPath,
+        RetainedPath,
+        CompositorPath,
+        ImagePath,          // a QImage owned by the compositor, converted on paste
+        CachedImagePath     // the same, pasted again from the conversion cache
+    };
+
+    struct Result {
+        qint64 source;      // set_selection until retained, or overrideSelection()
+        qint64 offer;       // focus change until the selection event
+        qint64 firstByte;   // receive until the first byte, includes a conversion
+        qint64 transfer;    // first until last byte
+        qint64 bytes;
+    };
+
+    bool measure(Path path, const QByteArray &mimeType, const QByteArray &payload, Result *result);
+    bool measureImage(Path path, const QImage &image, Result *result);
+    void report(Path path, int size, const QList<Result> &results);
+
+    BenchmarkCompositor *m_compositor;
+    QByteArray m_socketName;
+    QList<int> m_sizes;
+    int m_repeat;
+    bool m_succeeded;
+
+    BenchmarkClient m_source;
+    BenchmarkClient m_target;
+};
+
+#endif // SELECTIONBENCHMARK_H
@@ -3,12 +3,14 @@ INCLUDEPATH += $$PWD
 HEADERS += \
     $$PWD/waylandcompositor.h \
     $$PWD/waylandsurface.h \
-    $$PWD/waylandinput.h
+    $$PWD/waylandinput.h \
+    $$PWD/waylandinputrecorder.h
 
 SOURCES += \
     $$PWD/waylandcompositor.cpp \
     $$PWD/waylandsurface.cpp \
-    $$PWD/waylandinput.cpp
+    $$PWD/waylandinput.cpp \
+    $$PWD/waylandinputrecorder.cpp
 
 QT += core-private
 
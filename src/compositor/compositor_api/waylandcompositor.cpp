@@ -45,6 +45,7 @@
 #include "wayland_wrapper/wlcompositor.h"
 #include "wayland_wrapper/wlsurface.h"
 #include "wayland_wrapper/wlinputdevice.h"
+#include "wayland_wrapper/wldatadevicemanager.h"
 #include <QtCore/QCoreApplication>
 #include <QtCore/QStringList>
 
@@ -93,6 +94,35 @@ void WaylandCompositor::destroyClientForSurface(WaylandSurface *surface)
     m_compositor->destroyClientForSurface(surface->handle());
 }
 
+/*!
+  Returns the topmost mapped surface accepting input at \a point, in output
+  coordinates, honouring sub surfaces and the input region set by the client.
+  If \a local is given it receives the position relative to that surface.
+*/
+WaylandSurface *WaylandCompositor::surfaceAt(const QPointF &point, QPointF *local)
+{
+    Wayland::Surface *surface = m_compositor->surfaceIndex()->surfaceAt(point, local);
+    return surface ? surface->waylandSurface() : 0;
+}
+
+void WaylandCompositor::raiseSurface(WaylandSurface *surface)
+{
+    m_compositor->surfaceIndex()->raise(surface->handle());
+}
+
+void WaylandCompositor::lowerSurface(WaylandSurface *surface)
+{
+    m_compositor->surfaceIndex()->lower(surface->handle());
+}
+
+/*!
+  When enabled, fully transparent pixels of shm surfaces do not take input.
+*/
+void WaylandCompositor::setAlphaHitTestEnabled(bool enable)
+{
+    m_compositor->surfaceIndex()->setAlphaTestEnabled(enable);
+}
+
 void WaylandCompositor::setDirectRenderSurface(WaylandSurface *surface)
 {
     m_compositor->setDirectRenderSurface(surface ? surface->handle() : 0);
@@ -127,6 +157,44 @@ void WaylandCompositor::setRetainedSelectionEnabled(bool enable)
         m_compositor->setRetainedSelectionWatcher(0, 0);
 }
 
+/** Chooses which of the types offered by the selection owner are copied
+ *  into the compositor. RetainPreferredTypes, the default, only copies the
+ *  types set with setRetainedSelectionPreferredTypes(), plain text, URI lists
+ *  and HTML unless changed. RetainRequestedTypes copies nothing until
+ *  requestRetainedSelectionType() is called. Types that are not retained
+ *  are lost when the owner goes away.
+ **/
+void WaylandCompositor::setRetainedSelectionPolicy(RetainedSelectionPolicy policy)
+{
+    m_compositor->dataDeviceManager()->setRetainPolicy(Wayland::DataDeviceManager::RetainPolicy(policy));
+}
+
+void WaylandCompositor::setRetainedSelectionPreferredTypes(const QStringList &mimeTypes)
+{
+    QList<QByteArray> types;
+    foreach (const QString &mimeType, mimeTypes)
+        types.append(mimeType.toLatin1());
+    m_compositor->dataDeviceManager()->setRetainPreferredTypes(types);
+}
+
+/** Stops retaining a selection once \a bytes have been read from its owner,
+ *  the types read completely up to then are kept. Types requested later are
+ *  still read if they fit in what is left. 0 means no limit.
+ **/
+void WaylandCompositor::setRetainedSelectionLimit(int bytes)
+{
+    m_compositor->dataDeviceManager()->setRetainLimit(bytes);
+}
+
+/** Reads \a mimeType from the current selection owner in addition to the
+ *  types already retained. retainedSelectionReceived() is called again
+ *  when it is available.
+ **/
+void WaylandCompositor::requestRetainedSelectionType(const QString &mimeType)
+{
+    m_compositor->dataDeviceManager()->requestRetainedType(mimeType.toLatin1());
+}
+
 void WaylandCompositor::retainedSelectionChanged(QMimeData *mimeData, void *param)
 {
     WaylandCompositor *self = static_cast<WaylandCompositor *>(param);
@@ -172,9 +240,79 @@ QRect WaylandCompositor::outputGeometry() const
     return m_compositor->outputGeometry();
 }
 
+/** There is one output per screen when the compositor starts, the primary
+ *  screen first, at the origin, and one more for each screen added later.
+ *  Output indexes stay valid for the lifetime of the compositor: the
+ *  output of a screen that goes away is kept with an empty geometry.
+ **/
+int WaylandCompositor::outputCount() const
+{
+    return m_compositor->outputs().size();
+}
+
+/** Adds a virtual output, for instance a panel the compositor drives
+ *  without a QScreen. Surfaces shown mainly on it get their frame
+ *  callbacks at most \a refreshRate times per second. Returns its index.
+ **/
+int WaylandCompositor::addOutput(const QRect &geometry, qreal refreshRate)
+{
+    m_compositor->addOutput(geometry, qRound(refreshRate * 1000));
+    return m_compositor->outputs().size() - 1;
+}
+
+void WaylandCompositor::setOutputGeometry(int output, const QRect &geometry)
+{
+    m_compositor->setOutputGeometry(m_compositor->outputs().at(output), geometry);
+}
+
+QRect WaylandCompositor::outputGeometry(int output) const
+{
+    return m_compositor->outputs().at(output)->geometry();
+}
+
+void WaylandCompositor::setOutputRefreshRate(int output, qreal refreshRate)
+{
+    m_compositor->outputs().at(output)->setRefreshRate(qRound(refreshRate * 1000));
+}
+
+qreal WaylandCompositor::outputRefreshRate(int output) const
+{
+    return m_compositor->outputs().at(output)->refreshRate() / qreal(1000);
+}
+
+/** The output pacing the frame callbacks of \a surface: the one showing
+ *  most of its window, or the first one if it is on none.
+ **/
+int WaylandCompositor::outputForSurface(WaylandSurface *surface) const
+{
+    return m_compositor->outputs().indexOf(m_compositor->outputForSurface(surface->handle()));
+}
+
+/** For compositors that render each output on its own: the frame of
+ *  \a output is done, instead of frameFinished() for all of them.
+ **/
+void WaylandCompositor::outputFrameFinished(int output)
+{
+    m_compositor->outputFrameFinished(m_compositor->outputs().at(output));
+}
+
 WaylandInputDevice *WaylandCompositor::defaultInputDevice() const
 {
-    return m_compositor->defaultInputDevice()->handle();
+    Wayland::InputDevice *device = m_compositor->defaultInputDevice();
+    return device ? device->handle() : 0;
+}
+
+/** All seats, the default one first. More seats are added by constructing a
+ *  WaylandInputDevice, each with its own focus, data device and cursor. The
+ *  compositor only owns the default seat, the application deletes the seats
+ *  it created, before or after the compositor.
+ **/
+QList<WaylandInputDevice *> WaylandCompositor::inputDevices() const
+{
+    QList<WaylandInputDevice *> devices;
+    foreach (Wayland::InputDevice *device, m_compositor->inputDevices())
+        devices.append(device->handle());
+    return devices;
 }
 
 bool WaylandCompositor::isDragging() const
@@ -201,6 +339,16 @@ void WaylandCompositor::changeCursor(const QImage &image, int hotspotX, int hots
     qDebug() << "changeCursor" << image.size() << hotspotX << hotspotY;
 }
 
+/** Called when a client sets the cursor of \a inputDevice. Only the cursor of
+ *  the default seat is forwarded to changeCursor(), compositors drawing a
+ *  pointer per seat reimplement this.
+ **/
+void WaylandCompositor::changeInputDeviceCursor(WaylandInputDevice *inputDevice, const QImage &image, int hotspotX, int hotspotY)
+{
+    if (inputDevice == defaultInputDevice())
+        changeCursor(image, hotspotX, hotspotY);
+}
+
 void WaylandCompositor::enableSubSurfaceExtension()
 {
     m_compositor->enableSubSurfaceExtension();
@@ -215,3 +363,21 @@ void WaylandCompositor::configureTouchExtension(TouchExtensionFlags flags)
 {
     m_compositor->configureTouchExtension(flags);
 }
+
+/** With a resampling latency set, pointer and touch motion is held back
+ *  until the frame is finished, with frameFinished() without a surface or
+ *  outputFrameFinished(). Clients then get one position per frame,
+ *  interpolated for the frame time minus \a msecs, or extrapolated a little
+ *  when input is late, so that motion looks even whatever rate the input
+ *  device runs at. Presses, releases and keys are never delayed. 0, the
+ *  default unless QT_COMPOSITOR_RESAMPLE_LATENCY is set, disables it.
+ **/
+void WaylandCompositor::setInputResamplingLatency(int msecs)
+{
+    m_compositor->setInputResamplingLatency(msecs);
+}
+
+int WaylandCompositor::inputResamplingLatency() const
+{
+    return m_compositor->inputResamplingLatency();
+}
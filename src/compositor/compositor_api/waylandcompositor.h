@@ -46,8 +46,10 @@
 #include <QObject>
 #include <QImage>
 #include <QRect>
+#include <QPointF>
 
 class QMimeData;
+class QStringList;
 class WaylandSurface;
 class WaylandInputDevice;
 
@@ -66,6 +68,11 @@ public:
 
     void destroyClientForSurface(WaylandSurface *surface);
 
+    WaylandSurface *surfaceAt(const QPointF &point, QPointF *local = 0);
+    void raiseSurface(WaylandSurface *surface);
+    void lowerSurface(WaylandSurface *surface);
+    void setAlphaHitTestEnabled(bool enable);
+
     void setDirectRenderSurface(WaylandSurface *surface);
     WaylandSurface *directRenderSurface() const;
 
@@ -77,6 +84,15 @@ public:
     Wayland::Compositor *handle() const;
 
     void setRetainedSelectionEnabled(bool enable);
+    enum RetainedSelectionPolicy {
+        RetainAllTypes,
+        RetainPreferredTypes,
+        RetainRequestedTypes
+    };
+    void setRetainedSelectionPolicy(RetainedSelectionPolicy policy);
+    void setRetainedSelectionPreferredTypes(const QStringList &mimeTypes);
+    void setRetainedSelectionLimit(int bytes);
+    void requestRetainedSelectionType(const QString &mimeType);
     virtual void retainedSelectionReceived(QMimeData *mimeData);
     void overrideSelection(QMimeData *data);
 
@@ -89,13 +105,24 @@ public:
     void setOutputGeometry(const QRect &outputGeometry);
     QRect outputGeometry() const;
 
+    int outputCount() const;
+    int addOutput(const QRect &geometry, qreal refreshRate = 60);
+    void setOutputGeometry(int output, const QRect &geometry);
+    QRect outputGeometry(int output) const;
+    void setOutputRefreshRate(int output, qreal refreshRate);
+    qreal outputRefreshRate(int output) const;
+    int outputForSurface(WaylandSurface *surface) const;
+    void outputFrameFinished(int output);
+
     WaylandInputDevice *defaultInputDevice() const;
+    QList<WaylandInputDevice *> inputDevices() const;
 
     bool isDragging() const;
     void sendDragMoveEvent(const QPoint &global, const QPoint &local, WaylandSurface *surface);
     void sendDragEndEvent();
 
     virtual void changeCursor(const QImage &image, int hotspotX, int hotspotY);
+    virtual void changeInputDeviceCursor(WaylandInputDevice *inputDevice, const QImage &image, int hotspotX, int hotspotY);
 
     void enableSubSurfaceExtension();
 
@@ -106,6 +133,9 @@ public:
     Q_DECLARE_FLAGS(TouchExtensionFlags, TouchExtensionFlag)
     void configureTouchExtension(TouchExtensionFlags flags);
 
+    void setInputResamplingLatency(int msecs);
+    int inputResamplingLatency() const;
+
 private:
     static void retainedSelectionChanged(QMimeData *mimeData, void *param);
 
@@ -42,9 +42,41 @@
 
 #include "wlinputdevice.h"
 #include "waylandcompositor.h"
+#include "waylandinputrecorder.h"
+#include "waylandsurface.h"
 #include "wlsurface.h"
 #include "wlcompositor.h"
 
+#include <QtGui/QTouchEvent>
+
+// Global position as the client will see it
+static inline QPoint validGlobalPos(Wayland::InputDevice *d, const QPoint &localPos, const QPoint &globalPos)
+{
+    if (!globalPos.isNull() || !d->mouseFocus())
+        return globalPos.isNull() ? localPos : globalPos;
+    return localPos + d->mouseFocus()->pos().toPoint();
+}
+
+static inline void recordMouseEvent(Wayland::InputDevice *d, WaylandInputRecorder::EventType type, int button,
+                                    const QPoint &localPos, const QPoint &globalPos)
+{
+    const QPoint global = validGlobalPos(d, localPos, globalPos);
+    if (type == WaylandInputRecorder::MouseMove)
+        d->recorder()->record(type, localPos.x(), localPos.y(), global.x(), global.y());
+    else
+        d->recorder()->record(type, button, localPos.x(), localPos.y(), global.x(), global.y());
+}
+
+// Where replay looks for the surface that had keyboard focus
+static QPoint surfaceCenter(WaylandSurface *surface)
+{
+    WaylandSurface *root = surface;
+    while (root->parentSurface())
+        root = root->parentSurface();
+    const QPointF topLeft = root->pos() + surface->mapTo(root, QPointF());
+    return (topLeft + QPointF(surface->size().width(), surface->size().height()) / 2).toPoint();
+}
+
 WaylandInputDevice::WaylandInputDevice(WaylandCompositor *compositor)
     : d(new Wayland::InputDevice(this,compositor->handle()))
 {
@@ -57,17 +89,26 @@ WaylandInputDevice::~WaylandInputDevice()
 
 void WaylandInputDevice::sendMousePressEvent(Qt::MouseButton button, const QPoint &localPos, const QPoint &globalPos)
 {
+    if (d->recorder())
+        recordMouseEvent(d, WaylandInputRecorder::MousePress, button, localPos, globalPos);
     d->sendMousePressEvent(button,localPos,globalPos);
+    d->compositor()->latencyProbe()->inputSent(d->mouseFocus());
 }
 
 void WaylandInputDevice::sendMouseReleaseEvent(Qt::MouseButton button, const QPoint &localPos, const QPoint &globalPos)
 {
+    if (d->recorder())
+        recordMouseEvent(d, WaylandInputRecorder::MouseRelease, button, localPos, globalPos);
     d->sendMouseReleaseEvent(button,localPos,globalPos);
+    d->compositor()->latencyProbe()->inputSent(d->mouseFocus());
 }
 
 void WaylandInputDevice::sendMouseMoveEvent(const QPoint &localPos, const QPoint &globalPos)
 {
+    if (d->recorder())
+        recordMouseEvent(d, WaylandInputRecorder::MouseMove, 0, localPos, globalPos);
     d->sendMouseMoveEvent(localPos,globalPos);
+    d->compositor()->latencyProbe()->inputSent(d->mouseFocus());
 }
 
 /** Convenience function that will set the mouse focus to the surface, then send the mouse move event.
@@ -76,37 +117,86 @@ void WaylandInputDevice::sendMouseMoveEvent(const QPoint &localPos, const QPoint
 void WaylandInputDevice::sendMouseMoveEvent(WaylandSurface *surface, const QPoint &localPos, const QPoint &globalPos)
 {
     Wayland::Surface *wlsurface = surface? surface->handle():0;
+    if (d->recorder() && wlsurface) {
+        const QPoint global = globalPos.isNull() ? localPos + wlsurface->pos().toPoint() : globalPos;
+        recordMouseEvent(d, WaylandInputRecorder::MouseMove, 0, localPos, global);
+    }
     d->sendMouseMoveEvent(wlsurface,localPos,globalPos);
+    d->compositor()->latencyProbe()->inputSent(wlsurface);
+}
+
+/** Merges consecutive mouse move events into one, sent before any other input event,
+ *  when a frame is finished, or at the latest after \a msecs milliseconds.
+ *  0 disables coalescing. The default is taken from QT_COMPOSITOR_COALESCE_MOTION.
+ **/
+void WaylandInputDevice::setMotionCoalescingLatency(int msecs)
+{
+    d->setMotionCoalescingLatency(msecs);
+}
+
+int WaylandInputDevice::motionCoalescingLatency() const
+{
+    return d->motionCoalescingLatency();
 }
 
 void WaylandInputDevice::sendKeyPressEvent(uint code)
 {
+    if (d->recorder())
+        d->recorder()->record(WaylandInputRecorder::KeyPress, code);
     d->sendKeyPressEvent(code);
+    d->compositor()->latencyProbe()->inputSent(d->keyboardFocus());
 }
 
 void WaylandInputDevice::sendKeyReleaseEvent(uint code)
 {
+    if (d->recorder())
+        d->recorder()->record(WaylandInputRecorder::KeyRelease, code);
     d->sendKeyReleaseEvent(code);
+    d->compositor()->latencyProbe()->inputSent(d->keyboardFocus());
 }
 
 void WaylandInputDevice::sendTouchPointEvent(int id, int x, int y, Qt::TouchPointState state)
 {
+    if (d->recorder())
+        d->recorder()->record(WaylandInputRecorder::TouchPoint, id, x, y, state);
     d->sendTouchPointEvent(id,x,y,state);
+    d->compositor()->latencyProbe()->inputSent(d->mouseFocus());
 }
 
 void WaylandInputDevice::sendTouchFrameEvent()
 {
+    if (d->recorder())
+        d->recorder()->record(WaylandInputRecorder::TouchFrame);
     d->sendTouchFrameEvent();
 }
 
 void WaylandInputDevice::sendTouchCancelEvent()
 {
+    if (d->recorder())
+        d->recorder()->record(WaylandInputRecorder::TouchCancel);
     d->sendTouchCancelEvent();
 }
 
+/** When recording, the points of \a event are stored as surface relative touch points
+ *  followed by a touch frame, they replay through sendTouchPointEvent().
+ **/
 void WaylandInputDevice::sendFullTouchEvent(QTouchEvent *event)
 {
+    if (d->recorder() && d->mouseFocus()) {
+        WaylandInputRecorder *recorder = d->recorder();
+        if (event->type() == QEvent::TouchCancel) {
+            recorder->record(WaylandInputRecorder::TouchCancel);
+        } else {
+            const QPointF surfacePos = d->mouseFocus()->pos();
+            foreach (const QTouchEvent::TouchPoint &tp, event->touchPoints()) {
+                const QPoint p = (tp.pos() - surfacePos).toPoint();
+                recorder->record(WaylandInputRecorder::TouchPoint, tp.id(), p.x(), p.y(), tp.state());
+            }
+            recorder->record(WaylandInputRecorder::TouchFrame);
+        }
+    }
     d->sendFullTouchEvent(event);
+    d->compositor()->latencyProbe()->inputSent(d->mouseFocus());
 }
 
 WaylandSurface *WaylandInputDevice::keyboardFocus() const
@@ -119,6 +209,14 @@ WaylandSurface *WaylandInputDevice::keyboardFocus() const
 
 void WaylandInputDevice::setKeyboardFocus(WaylandSurface *surface)
 {
+    if (d->recorder()) {
+        if (surface) {
+            const QPoint center = surfaceCenter(surface);
+            d->recorder()->record(WaylandInputRecorder::KeyboardFocus, 1, center.x(), center.y());
+        } else {
+            d->recorder()->record(WaylandInputRecorder::KeyboardFocus, 0);
+        }
+    }
     Wayland::Surface *wlsurface = surface?surface->handle():0;
     d->setKeyboardFocus(wlsurface);
 }
@@ -137,6 +235,19 @@ void WaylandInputDevice::setMouseFocus(WaylandSurface *surface, const QPoint &lo
     d->setMouseFocus(wlsurface,localPos,globalPos);
 }
 
+/** Records all input sent through this device to \a recorder, 0 stops recording.
+ *  The recorder is not owned by the input device.
+ **/
+void WaylandInputDevice::setRecorder(WaylandInputRecorder *recorder)
+{
+    d->setRecorder(recorder);
+}
+
+WaylandInputRecorder *WaylandInputDevice::recorder() const
+{
+    return d->recorder();
+}
+
 WaylandCompositor *WaylandInputDevice::compositor() const
 {
     return d->compositor()->waylandCompositor();
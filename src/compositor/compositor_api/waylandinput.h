@@ -48,6 +48,7 @@
 
 class WaylandCompositor;
 class WaylandSurface;
+class WaylandInputRecorder;
 class QTouchEvent;
 
 namespace Wayland {
@@ -65,6 +66,9 @@ public:
     void sendMouseMoveEvent(const QPoint &localPos, const QPoint &globalPos = QPoint());
     void sendMouseMoveEvent(WaylandSurface *surface , const QPoint &localPos, const QPoint &globalPos = QPoint());
 
+    void setMotionCoalescingLatency(int msecs);
+    int motionCoalescingLatency() const;
+
     void sendKeyPressEvent(uint code);
     void sendKeyReleaseEvent(uint code);
 
@@ -80,6 +84,9 @@ public:
     WaylandSurface *mouseFocus() const;
     void setMouseFocus(WaylandSurface *surface, const QPoint &local_pos, const QPoint &global_pos = QPoint());
 
+    void setRecorder(WaylandInputRecorder *recorder);
+    WaylandInputRecorder *recorder() const;
+
     WaylandCompositor *compositor() const;
     Wayland::InputDevice *handle() const;
 private:
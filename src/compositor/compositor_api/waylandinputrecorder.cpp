@@ -0,0 +1,196 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the Qt Compositor.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Nokia Corporation and its Subsidiary(-ies) nor
+**     the names of its contributors may be used to endorse or promote
+**     products derived from this software without specific prior written
+**     permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "waylandinputrecorder.h"
+
+#include "waylandinput.h"
+#include "waylandcompositor.h"
+
+#include <QtCore/QIODevice>
+#include <QDebug>
+
+#include <stdio.h>
+#include <string.h>
+
+static const char *const eventNames[WaylandInputRecorder::EventTypeCount] = {
+    "mouse-press",
+    "mouse-release",
+    "mouse-move",
+    "key-press",
+    "key-release",
+    "touch-point",
+    "touch-frame",
+    "touch-cancel",
+    "keyboard-focus"
+};
+
+WaylandInputRecorder::WaylandInputRecorder(QIODevice *output)
+    : m_output(output)
+{
+    m_clock.start();
+}
+
+const char *WaylandInputRecorder::eventName(EventType type)
+{
+    return eventNames[type];
+}
+
+void WaylandInputRecorder::record(EventType type, int arg0, int arg1, int arg2, int arg3, int arg4)
+{
+    char line[128];
+    int length = qsnprintf(line, sizeof(line), "%lld %s %d %d %d %d %d\n",
+                           m_clock.nsecsElapsed() / 1000, eventNames[type],
+                           arg0, arg1, arg2, arg3, arg4);
+    m_output->write(line, length);
+}
+
+WaylandInputReplay::WaylandInputReplay(WaylandInputDevice *device, QObject *parent)
+    : QObject(parent)
+    , m_device(device)
+    , m_next(0)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(dispatchEvents()));
+}
+
+bool WaylandInputReplay::load(QIODevice *input)
+{
+    m_events.clear();
+    m_next = 0;
+
+    while (!input->atEnd()) {
+        const QByteArray line = input->readLine().trimmed();
+        if (line.isEmpty())
+            continue;
+
+        Event event;
+        long long time;
+        char name[32];
+        if (sscanf(line.constData(), "%lld %31s %d %d %d %d %d", &time, name,
+                   &event.args[0], &event.args[1], &event.args[2],
+                   &event.args[3], &event.args[4]) != 7) {
+            qWarning() << "WaylandInputReplay: malformed line" << line;
+            return false;
+        }
+        int type = 0;
+        while (type < WaylandInputRecorder::EventTypeCount && strcmp(name, eventNames[type]))
+            ++type;
+        if (type == WaylandInputRecorder::EventTypeCount) {
+            qWarning() << "WaylandInputReplay: unknown event" << name;
+            return false;
+        }
+        event.time = time;
+        event.type = WaylandInputRecorder::EventType(type);
+        m_events.append(event);
+    }
+    return true;
+}
+
+void WaylandInputReplay::start()
+{
+    m_next = 0;
+    m_clock.start();
+    scheduleNext();
+}
+
+void WaylandInputReplay::scheduleNext()
+{
+    if (m_next >= m_events.size()) {
+        emit finished();
+        return;
+    }
+    const qint64 due = m_events.at(m_next).time - m_clock.nsecsElapsed() / 1000;
+    m_timer.start(due > 0 ? int((due + 999) / 1000) : 0);
+}
+
+void WaylandInputReplay::dispatchEvents()
+{
+    // Everything that became due while waiting goes out at once, so
+    // the replay does not drift behind the recording.
+    const qint64 now = m_clock.nsecsElapsed() / 1000;
+    while (m_next < m_events.size() && m_events.at(m_next).time <= now)
+        dispatch(m_events.at(m_next++));
+    scheduleNext();
+}
+
+void WaylandInputReplay::dispatch(const Event &event)
+{
+    const int *args = event.args;
+    switch (event.type) {
+    case WaylandInputRecorder::MousePress:
+    case WaylandInputRecorder::MouseRelease:
+    case WaylandInputRecorder::MouseMove: {
+        const int offset = event.type == WaylandInputRecorder::MouseMove ? 0 : 1;
+        const QPoint globalPos(args[offset + 2], args[offset + 3]);
+        QPointF local;
+        WaylandSurface *surface = m_device->compositor()->surfaceAt(globalPos, &local);
+        m_device->sendMouseMoveEvent(surface, local.toPoint(), globalPos);
+        if (event.type == WaylandInputRecorder::MousePress)
+            m_device->sendMousePressEvent(Qt::MouseButton(args[0]), local.toPoint(), globalPos);
+        else if (event.type == WaylandInputRecorder::MouseRelease)
+            m_device->sendMouseReleaseEvent(Qt::MouseButton(args[0]), local.toPoint(), globalPos);
+        break;
+    }
+    case WaylandInputRecorder::KeyPress:
+        m_device->sendKeyPressEvent(args[0]);
+        break;
+    case WaylandInputRecorder::KeyRelease:
+        m_device->sendKeyReleaseEvent(args[0]);
+        break;
+    case WaylandInputRecorder::TouchPoint:
+        m_device->sendTouchPointEvent(args[0], args[1], args[2], Qt::TouchPointState(args[3]));
+        break;
+    case WaylandInputRecorder::TouchFrame:
+        m_device->sendTouchFrameEvent();
+        break;
+    case WaylandInputRecorder::TouchCancel:
+        m_device->sendTouchCancelEvent();
+        break;
+    case WaylandInputRecorder::KeyboardFocus: {
+        WaylandSurface *surface = 0;
+        if (args[0])
+            surface = m_device->compositor()->surfaceAt(QPoint(args[1], args[2]));
+        m_device->setKeyboardFocus(surface);
+        break;
+    }
+    default:
+        break;
+    }
+}
@@ -0,0 +1,125 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the Qt Compositor.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Nokia Corporation and its Subsidiary(-ies) nor
+**     the names of its contributors may be used to endorse or promote
+**     products derived from this software without specific prior written
+**     permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef WAYLANDINPUTRECORDER_H
+#define WAYLANDINPUTRECORDER_H
+
+#include "waylandexport.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
+
+class QIODevice;
+class WaylandInputDevice;
+
+/** Writes the input events delivered to a WaylandInputDevice to \a output, one line per
+ *  event, prefixed with the time in microseconds since the recorder was created.
+ *  Install it with WaylandInputDevice::setRecorder().
+ **/
+class Q_COMPOSITOR_EXPORT WaylandInputRecorder
+{
+public:
+    enum EventType {
+        MousePress,
+        MouseRelease,
+        MouseMove,
+        KeyPress,
+        KeyRelease,
+        TouchPoint,
+        TouchFrame,
+        TouchCancel,
+        KeyboardFocus,
+        EventTypeCount
+    };
+
+    explicit WaylandInputRecorder(QIODevice *output);
+
+    void record(EventType type, int arg0 = 0, int arg1 = 0, int arg2 = 0, int arg3 = 0, int arg4 = 0);
+
+    static const char *eventName(EventType type);
+
+private:
+    QIODevice *m_output;
+    QElapsedTimer m_clock;
+};
+
+/** Replays a recording made by WaylandInputRecorder into \a device with the original timing.
+ *  Pointer events are routed to the surface found at their global position, so the
+ *  surfaces do not have to be where they were during the recording. Keyboard focus
+ *  goes to the surface found where the focused surface was centered when recording.
+ **/
+class Q_COMPOSITOR_EXPORT WaylandInputReplay : public QObject
+{
+    Q_OBJECT
+public:
+    explicit WaylandInputReplay(WaylandInputDevice *device, QObject *parent = 0);
+
+    bool load(QIODevice *input);
+    bool isRunning() const { return m_timer.isActive(); }
+
+public slots:
+    void start();
+
+signals:
+    void finished();
+
+private slots:
+    void dispatchEvents();
+
+private:
+    struct Event {
+        qint64 time;
+        WaylandInputRecorder::EventType type;
+        int args[5];
+    };
+
+    void dispatch(const Event &event);
+    void scheduleNext();
+
+    WaylandInputDevice *m_device;
+    QVector<Event> m_events;
+    int m_next;
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+};
+
+#endif // WAYLANDINPUTRECORDER_H
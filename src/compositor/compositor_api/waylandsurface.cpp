@@ -90,19 +90,32 @@ WaylandSurface::WaylandSurface(Wayland::Surface *surface)
 WaylandSurface *WaylandSurface::parentSurface() const
 {
     Q_D(const WaylandSurface);
-    if (d->surface->subSurface()) {
+    if (d->surface->subSurface() && d->surface->subSurface()->parent()) {
         return d->surface->subSurface()->parent()->waylandSurface();
     }
     return 0;
 }
 
-QLinkedList<WaylandSurface *> WaylandSurface::subSurfaces() const
+QList<WaylandSurface *> WaylandSurface::subSurfaces() const
 {
     Q_D(const WaylandSurface);
     if (d->surface->subSurface()) {
         return d->surface->subSurface()->subSurfaces();
     }
-    return QLinkedList<WaylandSurface *>();
+    return QList<WaylandSurface *>();
+}
+
+QList<WaylandSurface::RenderItem> WaylandSurface::renderList() const
+{
+    Q_D(const WaylandSurface);
+    if (d->surface->subSurface())
+        return d->surface->subSurface()->renderList();
+
+    RenderItem item;
+    item.surface = const_cast<WaylandSurface *>(this);
+    QList<RenderItem> list;
+    list.append(item);
+    return list;
 }
 
 WaylandSurface::Type WaylandSurface::type() const
@@ -276,19 +289,20 @@ QPointF WaylandSurface::mapToParent(const QPointF &pos) const
     return pos + this->pos();
 }
 
+// parent must be in the parent hierarchy. Both offsets are cached by the
+// sub surface tree, so this does not walk up to the parent.
 QPointF WaylandSurface::mapTo(WaylandSurface *parent, const QPointF &pos) const
 {
-    QPointF p = pos;
-    if (parent) {
-        const WaylandSurface * surface = this;
-        while (surface != parent) {
-            Q_ASSERT_X(surface, "WaylandSurface::mapTo(WaylandSurface *parent, const QPoint &pos)",
-                       "parent must be in parent hierarchy");
-            p = surface->mapToParent(p);
-            surface = surface->parentSurface();
-        }
-    }
-    return p;
+    Q_D(const WaylandSurface);
+    if (!parent || parent == this)
+        return pos;
+
+    Wayland::SubSurface *subSurface = d->surface->subSurface();
+    Wayland::SubSurface *parentSubSurface = parent->handle()->subSurface();
+    Q_ASSERT_X(subSurface && parentSubSurface && subSurface->parent(),
+               "WaylandSurface::mapTo(WaylandSurface *parent, const QPoint &pos)",
+               "parent must be in parent hierarchy");
+    return pos + subSurface->treeOffset() - parentSubSurface->treeOffset();
 }
 
 WaylandCompositor *WaylandSurface::compositor() const
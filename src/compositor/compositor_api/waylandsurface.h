@@ -46,6 +46,7 @@
 #include <QtCore/QScopedPointer>
 #include <QtGui/QImage>
 #include <QtCore/QVariantMap>
+#include <QtCore/QList>
 
 #include <QtGui/QOpenGLContext>
 #ifdef QT_COMPOSITOR_WAYLAND_GL
@@ -96,7 +97,16 @@ public:
     WaylandSurface(Wayland::Surface *surface = 0);
 
     WaylandSurface *parentSurface() const;
-    QLinkedList<WaylandSurface *> subSurfaces() const;
+    QList<WaylandSurface *> subSurfaces() const;
+
+    // A surface of the tree and where to draw it, relative to the surface
+    // the render list was asked for
+    struct RenderItem {
+        WaylandSurface *surface;
+        QPointF pos;
+    };
+    // The surface and all its sub surfaces in drawing order, bottom first
+    QList<RenderItem> renderList() const;
 
     Type type() const;
     bool isYInverted() const;
@@ -147,6 +157,7 @@ signals:
     void unmapped();
     void damaged(const QRect &rect);
     void parentChanged(WaylandSurface *newParent, WaylandSurface *oldParent);
+    void subSurfacesChanged();
     void sizeChanged();
     void posChanged();
     void windowPropertyChanged(const QString &name, const QVariant &value);
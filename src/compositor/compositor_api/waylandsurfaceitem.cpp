@@ -43,6 +43,7 @@
 #include "waylandcompositor.h"
 #include "waylandinput.h"
 
+#include "wlcompositor.h"
 #include "wlsurface.h"
 #include "wlextendedsurface.h"
 
@@ -78,6 +79,7 @@ WaylandSurfaceItem::WaylandSurfaceItem(QQuickItem *parent)
     , m_useTextureAlpha(false)
     , m_clientRenderingEnabled(false)
     , m_touchEventsEnabled(false)
+    , m_inputDevice(0)
 {
 }
 
@@ -90,6 +92,7 @@ WaylandSurfaceItem::WaylandSurfaceItem(WaylandSurface *surface, QQuickItem *pare
     , m_useTextureAlpha(false)
     , m_clientRenderingEnabled(false)
     , m_touchEventsEnabled(false)
+    , m_inputDevice(0)
 {
     init(surface);
 }
@@ -105,6 +108,9 @@ void WaylandSurfaceItem::init(WaylandSurface *surface)
 
     m_surface = surface;
     m_surface->setSurfaceItem(this);
+    // Looked up once, input events are delivered through it at a high rate
+    if (!m_inputDevice)
+        setInputDevice(0);
     if (m_clientRenderingEnabled) {
         m_surface->sendOnScreenVisibilityChange(m_clientRenderingEnabled);
     }
@@ -160,59 +166,51 @@ QSGTextureProvider *WaylandSurfaceItem::textureProvider() const
 
 void WaylandSurfaceItem::mousePressEvent(QMouseEvent *event)
 {
-    if (m_surface) {
-        WaylandInputDevice *inputDevice = m_surface->compositor()->defaultInputDevice();
-        if (inputDevice->mouseFocus() != m_surface)
-            inputDevice->setMouseFocus(m_surface, event->pos(), event->globalPos());
-        inputDevice->sendMousePressEvent(event->button(), toSurface(event->pos()));
+    if (m_surface && m_inputDevice) {
+        if (m_inputDevice->mouseFocus() != m_surface)
+            m_inputDevice->setMouseFocus(m_surface, event->pos(), event->globalPos());
+        m_inputDevice->sendMousePressEvent(event->button(), toSurface(event->pos()));
     }
 }
 
 void WaylandSurfaceItem::mouseMoveEvent(QMouseEvent *event)
 {
-    if (m_surface){
-        WaylandInputDevice *inputDevice = m_surface->compositor()->defaultInputDevice();
-        inputDevice->sendMouseMoveEvent(m_surface, toSurface(event->pos()));
+    if (m_surface && m_inputDevice){
+        m_inputDevice->sendMouseMoveEvent(m_surface, toSurface(event->pos()));
     }
 }
 
 void WaylandSurfaceItem::mouseReleaseEvent(QMouseEvent *event)
 {
-    if (m_surface){
-        WaylandInputDevice *inputDevice = m_surface->compositor()->defaultInputDevice();
-        inputDevice->sendMouseReleaseEvent(event->button(), toSurface(event->pos()));
+    if (m_surface && m_inputDevice){
+        m_inputDevice->sendMouseReleaseEvent(event->button(), toSurface(event->pos()));
     }
 }
 
 void WaylandSurfaceItem::keyPressEvent(QKeyEvent *event)
 {
-    if (m_surface && hasFocus()) {
-        WaylandInputDevice *inputDevice = m_surface->compositor()->defaultInputDevice();
-        inputDevice->sendKeyPressEvent(event->nativeScanCode());
-    }
+    if (m_surface && m_inputDevice && hasFocus())
+        m_inputDevice->sendKeyPressEvent(event->nativeScanCode());
 }
 
 void WaylandSurfaceItem::keyReleaseEvent(QKeyEvent *event)
 {
-    if (m_surface && hasFocus()) {
-        WaylandInputDevice *inputDevice = m_surface->compositor()->defaultInputDevice();
-        inputDevice->sendKeyReleaseEvent(event->nativeScanCode());
-    }
+    if (m_surface && m_inputDevice && hasFocus())
+        m_inputDevice->sendKeyReleaseEvent(event->nativeScanCode());
 }
 
 void WaylandSurfaceItem::touchEvent(QTouchEvent *event)
 {
-    if (m_touchEventsEnabled && m_surface) {
-        WaylandInputDevice *inputDevice = m_surface->compositor()->defaultInputDevice();
+    if (m_touchEventsEnabled && m_surface && m_inputDevice) {
         event->accept();
-        if (inputDevice->mouseFocus() != m_surface) {
+        if (m_inputDevice->mouseFocus() != m_surface) {
             QPoint pointPos;
             QList<QTouchEvent::TouchPoint> points = event->touchPoints();
             if (!points.isEmpty())
                 pointPos = points.at(0).pos().toPoint();
-            inputDevice->setMouseFocus(m_surface, pointPos, pointPos);
+            m_inputDevice->setMouseFocus(m_surface, pointPos, pointPos);
         }
-        inputDevice->sendFullTouchEvent(event);
+        m_inputDevice->sendFullTouchEvent(event);
     } else {
         event->ignore();
     }
@@ -222,9 +220,8 @@ void WaylandSurfaceItem::takeFocus()
 {
     setFocus(true);
 
-    if (m_surface) {
-        WaylandInputDevice *inputDevice = m_surface->compositor()->defaultInputDevice();
-        inputDevice->setKeyboardFocus(m_surface);
+    if (m_surface && m_inputDevice) {
+        m_inputDevice->setKeyboardFocus(m_surface);
     }
 }
 
@@ -401,3 +398,25 @@ void WaylandSurfaceItem::setTouchEventsEnabled(bool enabled)
         emit touchEventsEnabledChanged();
     }
 }
+
+/** Routes the input this item receives to \a inputDevice instead of the
+ *  default seat, e.g. when every user of a shared screen has their own seat.
+ *  When the seat is deleted the item goes back to the default seat, as it
+ *  does for 0.
+ **/
+void WaylandSurfaceItem::setInputDevice(WaylandInputDevice *inputDevice)
+{
+    m_inputDevice = inputDevice;
+    if (!m_inputDevice && m_surface)
+        m_inputDevice = m_surface->compositor()->defaultInputDevice();
+    if (m_inputDevice) {
+        connect(m_inputDevice->compositor()->handle(), SIGNAL(inputDeviceUnregistered(WaylandInputDevice*)),
+                this, SLOT(inputDeviceUnregistered(WaylandInputDevice*)), Qt::UniqueConnection);
+    }
+}
+
+void WaylandSurfaceItem::inputDeviceUnregistered(WaylandInputDevice *inputDevice)
+{
+    if (inputDevice == m_inputDevice)
+        setInputDevice(0);
+}
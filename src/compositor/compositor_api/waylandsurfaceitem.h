@@ -51,6 +51,7 @@
 
 class WaylandSurfaceTextureProvider;
 class WaylandSurfaceNode;
+class WaylandInputDevice;
 
 Q_DECLARE_METATYPE(WaylandSurface*)
 
@@ -88,6 +89,9 @@ public:
 
     void setDamagedFlag(bool on);
 
+    void setInputDevice(WaylandInputDevice *inputDevice);
+    WaylandInputDevice *inputDevice() const { return m_inputDevice; }
+
 protected:
     void mousePressEvent(QMouseEvent *event);
     void mouseMoveEvent(QMouseEvent *event);
@@ -110,6 +114,7 @@ private slots:
     void parentChanged(WaylandSurface *newParent, WaylandSurface *oldParent);
     void updateSize();
     void updatePosition();
+    void inputDeviceUnregistered(WaylandInputDevice *inputDevice);
 
 signals:
     void textureChanged();
@@ -135,6 +140,7 @@ private:
     bool m_useTextureAlpha;
     bool m_clientRenderingEnabled;
     bool m_touchEventsEnabled;
+    WaylandInputDevice *m_inputDevice;
     bool m_damaged;
     bool m_yInverted;
 };
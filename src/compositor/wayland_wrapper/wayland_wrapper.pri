@@ -11,6 +11,7 @@ HEADERS += \
     $$PWD/wloutput.h \
     $$PWD/wlshmbuffer.h \
     $$PWD/wlsurface.h \
+    $$PWD/wlsurfaceindex.h \
     $$PWD/wlshellsurface.h \
     $$PWD/wlinputdevice.h \
     $$PWD/wldatadevicemanager.h \
@@ -21,7 +22,11 @@ HEADERS += \
     $$PWD/wlextendedoutput.h \
     $$PWD/wlsubsurface.h \
     $$PWD/wltouch.h \
+    $$PWD/wllatencyprobe.h \
+    $$PWD/wlmotionresampler.h \
     $$PWD/../../shared/qwaylandmimehelper.h \
+    $$PWD/../../shared/qwaylandlatencyhistogram.h \
+    $$PWD/../../shared/qwaylandpropertybatch.h \
     $$PWD/wlsurfacebuffer.h
 
 SOURCES += \
@@ -30,6 +35,7 @@ SOURCES += \
     $$PWD/wloutput.cpp \
     $$PWD/wlshmbuffer.cpp \
     $$PWD/wlsurface.cpp \
+    $$PWD/wlsurfaceindex.cpp \
     $$PWD/wlshellsurface.cpp \
     $$PWD/wlinputdevice.cpp \
     $$PWD/wldatadevicemanager.cpp \
@@ -40,7 +46,11 @@ SOURCES += \
     $$PWD/wlextendedoutput.cpp \
     $$PWD/wlsubsurface.cpp \
     $$PWD/wltouch.cpp \
+    $$PWD/wllatencyprobe.cpp \
+    $$PWD/wlmotionresampler.cpp \
     $$PWD/../../shared/qwaylandmimehelper.cpp \
+    $$PWD/../../shared/qwaylandlatencyhistogram.cpp \
+    $$PWD/../../shared/qwaylandpropertybatch.cpp \
     $$PWD/wlsurfacebuffer.cpp
 
 INCLUDEPATH += $$PWD
@@ -60,6 +60,7 @@
 #include <QPlatformScreen>
 #include <QGuiApplication>
 #include <QPlatformScreenPageFlipper>
+#include <QElapsedTimer>
 #include <QDebug>
 
 #include <stdio.h>
@@ -124,6 +125,7 @@ Compositor::Compositor(WaylandCompositor *qt_compositor)
     , m_subSurfaceExtension(0)
     , m_touchExtension(0)
     , m_retainNotify(0)
+    , m_inputResamplingLatency(qgetenv("QT_COMPOSITOR_RESAMPLE_LATENCY").toInt())
 {
     compositor = this;
     qDebug() << "Compositor instance is" << this;
@@ -139,7 +141,15 @@ Compositor::Compositor(WaylandCompositor *qt_compositor)
 
     m_data_device_manager =  new DataDeviceManager(this);
 
-    wl_display_add_global(m_display->handle(),&wl_output_interface, &m_output_global,OutputGlobal::output_bind_func);
+    // The primary screen keeps the origin, the others are placed relative to it
+    QScreen *primaryScreen = QGuiApplication::primaryScreen();
+    addOutput(QRect(QPoint(0, 0), primaryScreen->availableGeometry().size()),
+              qRound(primaryScreen->refreshRate() * 1000), primaryScreen);
+    foreach (QScreen *screen, QGuiApplication::screens()) {
+        if (screen != primaryScreen)
+            screenAdded(screen);
+    }
+    connect(qApp, SIGNAL(screenAdded(QScreen*)), this, SLOT(screenAdded(QScreen*)));
 
     m_shell = new Shell();
     wl_display_add_global(m_display->handle(), &wl_shell_interface, m_shell, Shell::bind_func);
@@ -161,17 +171,29 @@ Compositor::Compositor(WaylandCompositor *qt_compositor)
 
     qRegisterMetaType<SurfaceBuffer*>("SurfaceBuffer*");
     //initialize distancefieldglyphcache here
+
+    m_motionFlushTimer.setSingleShot(true);
+    connect(&m_motionFlushTimer, SIGNAL(timeout()), this, SLOT(flushPendingMotion()));
+
+    m_propertyFlushTimer.setSingleShot(true);
+    connect(&m_propertyFlushTimer, SIGNAL(timeout()), this, SLOT(flushPendingProperties()));
 }
 
 Compositor::~Compositor()
 {
     delete m_shell;
+    qDeleteAll(m_outputs);
     delete m_outputExtension;
     delete m_surfaceExtension;
     delete m_subSurfaceExtension;
     delete m_touchExtension;
 
+    // Only the default seat is the compositor's, seats created by the
+    // application are deleted by it and just lose their compositor here
     delete m_default_wayland_input_device;
+    foreach (InputDevice *device, m_inputDevices)
+        device->compositorDestroyed();
+    m_inputDevices.clear();
     delete m_data_device_manager;
 
 #ifdef QT_COMPOSITOR_WAYLAND_GL
@@ -185,13 +207,111 @@ void Compositor::frameFinished(Surface *surface)
 {
     if (surface && m_dirty_surfaces.contains(surface)) {
         m_dirty_surfaces.remove(surface);
+        m_latencyProbe.displayed(surface);
         surface->sendFrameCallback();
     } else if (!surface) {
-        QSet<Surface *> dirty = m_dirty_surfaces;
-        m_dirty_surfaces.clear();
-        foreach (Surface *surface, dirty)
-            surface->sendFrameCallback();
+        // Clients should see the pointer where it was when the frame was
+        // made, once per frame and not per surface in it
+        resampleInput();
+        foreach (OutputGlobal *output, m_outputs)
+            finishOutputFrame(output);
+    }
+}
+
+// For compositors that compose each output on its own
+void Compositor::outputFrameFinished(OutputGlobal *output)
+{
+    resampleInput();
+    finishOutputFrame(output);
+}
+
+// Only the surfaces dirty when the frame was finished made it into the
+// frame, the ones committed until the next tick of the output wait for
+// the following one
+void Compositor::finishOutputFrame(OutputGlobal *output)
+{
+    QSet<Surface *> &finished = m_finishedSurfaces[output];
+    QSet<Surface *>::iterator it = m_dirty_surfaces.begin();
+    while (it != m_dirty_surfaces.end()) {
+        if (outputForSurface(*it) == output) {
+            finished.insert(*it);
+            it = m_dirty_surfaces.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    output->frameFinished();
+}
+
+// Called by the frame clock of the output, once per refresh at most
+void Compositor::sendFrameCallbacks(OutputGlobal *output)
+{
+    const QSet<Surface *> finished = m_finishedSurfaces.take(output);
+    foreach (Surface *surface, finished) {
+        m_latencyProbe.displayed(surface);
+        surface->sendFrameCallback();
+    }
+}
+
+void Compositor::scheduleMotionFlush(int msecs)
+{
+    if (!m_motionFlushTimer.isActive())
+        m_motionFlushTimer.start(msecs);
+}
+
+void Compositor::flushPendingMotion()
+{
+    m_motionFlushTimer.stop();
+    // Each seat only sends the motion it has queued itself
+    foreach (InputDevice *device, m_inputDevices)
+        device->flushPendingMotion();
+    if (m_touchExtension)
+        m_touchExtension->flushPendingTouch();
+}
+
+// Window properties set while handling one event go out as one batch per
+// surface once control is back in the event loop.
+void Compositor::schedulePropertyFlush(ExtendedSurface *surface)
+{
+    m_pendingPropertySurfaces.insert(surface);
+    if (!m_propertyFlushTimer.isActive())
+        m_propertyFlushTimer.start(0);
+}
+
+void Compositor::unschedulePropertyFlush(ExtendedSurface *surface)
+{
+    m_pendingPropertySurfaces.remove(surface);
+}
+
+void Compositor::flushPendingProperties()
+{
+    QSet<ExtendedSurface *> pending = m_pendingPropertySurfaces;
+    m_pendingPropertySurfaces.clear();
+    foreach (ExtendedSurface *surface, pending)
+        surface->flushPendingProperties();
+}
+
+void Compositor::setInputResamplingLatency(int msecs)
+{
+    flushPendingMotion();
+    m_inputResamplingLatency = qMax(0, msecs);
+}
+
+// Motion queued since the last frame goes out as one position per seat
+// and touch point, taken at the frame time minus the resampling latency.
+void Compositor::resampleInput()
+{
+    if (m_inputResamplingLatency <= 0) {
+        flushPendingMotion();
+        return;
     }
+
+    m_motionFlushTimer.stop();
+    qint64 sampleTime = monotonicTimeUsecs() - m_inputResamplingLatency * 1000;
+    foreach (InputDevice *device, m_inputDevices)
+        device->resamplePendingMotion(sampleTime);
+    if (m_touchExtension)
+        m_touchExtension->resamplePendingTouch(sampleTime);
 }
 
 void Compositor::createSurface(struct wl_client *client, uint32_t id)
@@ -243,6 +363,14 @@ uint Compositor::currentTimeMsecs()
     return 0;
 }
 
+qint64 Compositor::monotonicTimeUsecs()
+{
+    static QElapsedTimer clock;
+    if (!clock.isValid())
+        clock.start();
+    return clock.nsecsElapsed() / 1000;
+}
+
 void Compositor::releaseBuffer(SurfaceBuffer *screenBuffer)
 {
     screenBuffer->scheduledRelease();
@@ -257,10 +385,21 @@ void Compositor::processWaylandEvents()
 
 void Compositor::surfaceDestroyed(Surface *surface)
 {
-    if (defaultInputDevice()->mouseFocus() == surface)
-        defaultInputDevice()->setMouseFocus(0, QPoint(), QPoint());
+    foreach (InputDevice *device, m_inputDevices) {
+        if (device->mouseFocus() == surface)
+            device->setMouseFocus(0, QPoint(), QPoint());
+        if (DataDevice *dragDevice = device->dragDevice())
+            dragDevice->surfaceDestroyed(surface);
+    }
     m_surfaces.removeOne(surface);
     m_dirty_surfaces.remove(surface);
+    for (QHash<OutputGlobal *, QSet<Surface *> >::iterator it = m_finishedSurfaces.begin();
+         it != m_finishedSurfaces.end(); ++it)
+        it.value().remove(surface);
+    m_surfaceIndex.remove(surface);
+    m_latencyProbe.surfaceDestroyed(surface);
+    if (m_touchExtension)
+        m_touchExtension->surfaceDestroyed(surface);
     if (m_directRenderSurface == surface)
         setDirectRenderSurface(0);
     waylandCompositor()->surfaceAboutToBeDestroyed(surface->waylandSurface());
@@ -356,10 +495,10 @@ void Compositor::setScreenOrientation(Qt::ScreenOrientation orientation)
     QList<struct wl_client*> clientList = clients();
     for (int i = 0; i < clientList.length(); ++i) {
         struct wl_client *client = clientList.at(i);
-        Output *output = m_output_global.outputForClient(client);
-        Q_ASSERT(output);
-        if (output->extendedOutput()){
-            output->extendedOutput()->sendOutputOrientation(orientation);
+        foreach (OutputGlobal *outputGlobal, m_outputs) {
+            Output *output = outputGlobal->outputForClient(client);
+            if (output && output->extendedOutput())
+                output->extendedOutput()->sendOutputOrientation(orientation);
         }
     }
 }
@@ -371,12 +510,83 @@ Qt::ScreenOrientation Compositor::screenOrientation() const
 
 void Compositor::setOutputGeometry(const QRect &geometry)
 {
-    m_output_global.setGeometry(geometry);
+    setOutputGeometry(m_outputs.first(), geometry);
 }
 
 QRect Compositor::outputGeometry() const
 {
-    return m_output_global.geometry();
+    return m_outputs.first()->geometry();
+}
+
+OutputGlobal *Compositor::addOutput(const QRect &geometry, int refreshRate, QScreen *screen)
+{
+    OutputGlobal *output = new OutputGlobal(this, geometry, refreshRate, screen);
+    m_outputs.append(output);
+    if (screen)
+        connect(screen, SIGNAL(destroyed(QObject*)), this, SLOT(screenDestroyed(QObject*)));
+    foreach (Surface *surface, m_surfaces)
+        updateSurfaceOutputs(surface);
+    return output;
+}
+
+void Compositor::screenAdded(QScreen *screen)
+{
+    const QPoint origin = QGuiApplication::primaryScreen()->geometry().topLeft();
+    addOutput(QRect(screen->geometry().topLeft() - origin, screen->availableGeometry().size()),
+              qRound(screen->refreshRate() * 1000), screen);
+}
+
+// Output indexes stay valid, so the output of a screen that goes away is
+// kept without a global and without an area, showing no surface
+void Compositor::screenDestroyed(QObject *screen)
+{
+    foreach (OutputGlobal *output, m_outputs) {
+        if (output->screen() != screen)
+            continue;
+        sendFrameCallbacks(output);
+        output->screenRemoved();
+        foreach (Surface *surface, m_surfaces)
+            updateSurfaceOutputs(surface);
+    }
+}
+
+void Compositor::setOutputGeometry(OutputGlobal *output, const QRect &geometry)
+{
+    output->setGeometry(geometry);
+    foreach (Surface *surface, m_surfaces)
+        updateSurfaceOutputs(surface);
+}
+
+// Surfaces outside of all outputs are paced by the first one
+OutputGlobal *Compositor::outputForSurface(Surface *surface) const
+{
+    OutputGlobal *output = surface->primaryOutput();
+    return output ? output : m_outputs.first();
+}
+
+// The primary output of a surface is the one showing most of it. Sub
+// surfaces go with the output of their window.
+void Compositor::updateSurfaceOutputs(Surface *surface)
+{
+    if (surface->subSurface() && surface->subSurface()->parent())
+        return;
+
+    const QRect rect(surface->pos().toPoint(), surface->size());
+    QList<OutputGlobal *> outputs;
+    OutputGlobal *primary = 0;
+    int primaryArea = 0;
+    foreach (OutputGlobal *output, m_outputs) {
+        const QRect intersection = rect & output->geometry();
+        if (intersection.isEmpty())
+            continue;
+        outputs.append(output);
+        const int area = intersection.width() * intersection.height();
+        if (area > primaryArea) {
+            primary = output;
+            primaryArea = area;
+        }
+    }
+    surface->setOutputs(outputs, primary);
 }
 
 void Compositor::setClientFullScreenHint(bool value)
@@ -389,6 +599,21 @@ InputDevice* Compositor::defaultInputDevice()
     return m_default_input_device;
 }
 
+void Compositor::registerInputDevice(InputDevice *device)
+{
+    m_inputDevices.append(device);
+}
+
+void Compositor::unregisterInputDevice(InputDevice *device)
+{
+    m_inputDevices.removeOne(device);
+    if (m_default_input_device == device) {
+        m_default_input_device = 0;
+        m_default_wayland_input_device = 0;
+    }
+    emit inputDeviceUnregistered(device->handle());
+}
+
 QList<Wayland::Surface *> Compositor::surfacesForClient(wl_client *client)
 {
     QList<Wayland::Surface *> ret;
@@ -444,21 +669,32 @@ void Compositor::overrideSelection(QMimeData *data)
 
 bool Compositor::isDragging() const
 {
+    foreach (InputDevice *device, m_inputDevices) {
+        if (device->dragDevice())
+            return true;
+    }
     return false;
 }
 
+// Drags are pointer grabs, so the regular mouse events drive them as
+// well. These are for compositors delivering drag motion separately.
 void Compositor::sendDragMoveEvent(const QPoint &global, const QPoint &local,
                                             Surface *surface)
 {
-    Q_UNUSED(global);
     Q_UNUSED(local);
     Q_UNUSED(surface);
-//    Drag::instance()->dragMove(global, local, surface);
+    foreach (InputDevice *device, m_inputDevices) {
+        if (DataDevice *dragDevice = device->dragDevice())
+            dragDevice->motion(global);
+    }
 }
 
 void Compositor::sendDragEndEvent()
 {
-//    Drag::instance()->dragEnd();
+    foreach (InputDevice *device, m_inputDevices) {
+        if (DataDevice *dragDevice = device->dragDevice())
+            dragDevice->drop();
+    }
 }
 
 } // namespace Wayland
@@ -43,11 +43,15 @@
 
 #include "waylandexport.h"
 
+#include <QtCore/QHash>
 #include <QtCore/QSet>
+#include <QtCore/QTimer>
 
 #include "wloutput.h"
 #include "wldisplay.h"
 #include "wlshmbuffer.h"
+#include "wlsurfaceindex.h"
+#include "wllatencyprobe.h"
 
 #include <wayland-server.h>
 
@@ -58,6 +62,7 @@ class WindowManagerServerIntegration;
 class QMimeData;
 class QPlatformScreenPageFlipper;
 class QPlatformScreenBuffer;
+class QScreen;
 
 namespace Wayland {
 
@@ -67,6 +72,7 @@ class InputDevice;
 class DataDeviceManager;
 class OutputExtensionGlobal;
 class SurfaceExtensionGlobal;
+class ExtendedSurface;
 class SubSurfaceExtensionGlobal;
 class Shell;
 class TouchExtensionGlobal;
@@ -80,13 +86,18 @@ public:
     ~Compositor();
 
     void frameFinished(Surface *surface = 0);
+    void outputFrameFinished(OutputGlobal *output);
+    void sendFrameCallbacks(OutputGlobal *output);
 
     //these 3 functions will be removed if noone steps up soon.
     Surface *getSurfaceFromWinId(uint winId) const;
     struct wl_client *getClientFromWinId(uint winId) const;
     QImage image(uint winId) const;
 
-    InputDevice *defaultInputDevice(); //we just have 1 default device for now (since QPA doesn't give us anything else)
+    InputDevice *defaultInputDevice(); //the seat QPA input goes to, more can be added with WaylandInputDevice
+    QList<InputDevice *> inputDevices() const { return m_inputDevices; }
+    void registerInputDevice(InputDevice *device);
+    void unregisterInputDevice(InputDevice *device);
 
     void createSurface(struct wl_client *client, uint32_t id);
     void surfaceDestroyed(Surface *surface);
@@ -95,6 +106,7 @@ public:
     void destroyClientForSurface(Surface *surface);
 
     static uint currentTimeMsecs();
+    static qint64 monotonicTimeUsecs();
 
     QWindow *window() const;
 
@@ -109,6 +121,9 @@ public:
 
     QList<Surface*> surfacesForClient(wl_client* client);
 
+    SurfaceIndex *surfaceIndex() { return &m_surfaceIndex; }
+    LatencyProbe *latencyProbe() { return &m_latencyProbe; }
+
     WaylandCompositor *waylandCompositor() const { return m_qt_compositor; }
 
     struct wl_display *wl_display() const { return m_display->handle(); }
@@ -124,10 +139,17 @@ public:
     void setOutputGeometry(const QRect &geometry);
     QRect outputGeometry() const;
 
+    QList<OutputGlobal *> outputs() const { return m_outputs; }
+    OutputGlobal *addOutput(const QRect &geometry, int refreshRate, QScreen *screen = 0);
+    void setOutputGeometry(OutputGlobal *output, const QRect &geometry);
+    OutputGlobal *outputForSurface(Surface *surface) const;
+    void updateSurfaceOutputs(Surface *surface);
+
     void setClientFullScreenHint(bool value);
 
     void enableTouchExtension();
     TouchExtensionGlobal *touchExtension() { return m_touchExtension; }
+    DataDeviceManager *dataDeviceManager() const { return m_data_device_manager; }
     void configureTouchExtension(int flags);
 
     bool isDragging() const;
@@ -142,7 +164,24 @@ public:
     void feedRetainedSelectionData(QMimeData *data);
 
     void scheduleReleaseBuffer(SurfaceBuffer *screenBuffer);
+
+    void scheduleMotionFlush(int msecs);
+
+    void schedulePropertyFlush(ExtendedSurface *surface);
+    void unschedulePropertyFlush(ExtendedSurface *surface);
+
+    void setInputResamplingLatency(int msecs);
+    int inputResamplingLatency() const { return m_inputResamplingLatency; }
+
+signals:
+    void inputDeviceUnregistered(WaylandInputDevice *device);
+
 private slots:
+    void flushPendingMotion();
+    void flushPendingProperties();
+
+    void screenAdded(QScreen *screen);
+    void screenDestroyed(QObject *screen);
 
     void releaseBuffer(SurfaceBuffer *screenBuffer);
     void processWaylandEvents();
@@ -153,10 +192,12 @@ private:
     /* Input */
     WaylandInputDevice *m_default_wayland_input_device;
     InputDevice *m_default_input_device;
+    QList<InputDevice *> m_inputDevices;
 
     /* Output */
-    //make this a list of the available screens
-    OutputGlobal m_output_global;
+    // One per screen and configured virtual output, the first one is the
+    // output of setOutputGeometry() and of surfaces outside all outputs
+    QList<OutputGlobal *> m_outputs;
     //This one should be part of the outputs
     QPlatformScreenPageFlipper *m_pageFlipper;
 
@@ -167,6 +208,9 @@ private:
 
     QList<Surface *> m_surfaces;
     QSet<Surface *> m_dirty_surfaces;
+    QHash<OutputGlobal *, QSet<Surface *> > m_finishedSurfaces;
+    SurfaceIndex m_surfaceIndex;
+    LatencyProbe m_latencyProbe;
 
     /* Render state */
     uint32_t m_current_frame;
@@ -198,6 +242,14 @@ private:
 
     RetainedSelectionFunc m_retainNotify;
     void *m_retainNotifyParam;
+
+    QTimer m_motionFlushTimer;
+    QTimer m_propertyFlushTimer;
+    QSet<ExtendedSurface *> m_pendingPropertySurfaces;
+    int m_inputResamplingLatency;
+
+    void resampleInput();
+    void finishOutputFrame(OutputGlobal *output);
 };
 
 }
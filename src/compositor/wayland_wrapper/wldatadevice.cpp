@@ -43,6 +43,7 @@
 #include "wldatasource.h"
 #include "wldataoffer.h"
 #include "wldatadevicemanager.h"
+#include "wlsurface.h"
 
 #include <stdlib.h>
 
@@ -57,14 +58,13 @@ void DataDevice::start_drag(struct wl_client *client,
                    uint32_t time)
 {
     Q_UNUSED(client);
-    Q_UNUSED(surface);
     Q_UNUSED(time);
 
     DataDevice *data_device = static_cast<DataDevice *>(resource->data);
     DataSource *data_source = static_cast<DataSource *>(source->data);
+    Surface *icon = surface ? resolve<Surface>(surface) : 0;
 
-    Q_UNUSED(data_device);
-    Q_UNUSED(data_source);
+    data_device->startDrag(data_source, icon);
 }
 
 void DataDevice::attach(struct wl_client *client,
@@ -75,11 +75,10 @@ void DataDevice::attach(struct wl_client *client,
                int32_t y)
 {
     Q_UNUSED(client);
-    Q_UNUSED(resource);
     Q_UNUSED(time);
-    Q_UNUSED(buffer);
-    Q_UNUSED(x);
-    Q_UNUSED(y);
+
+    DataDevice *data_device = static_cast<DataDevice *>(resource->data);
+    data_device->setDragIcon(buffer ? reinterpret_cast<struct wl_buffer *>(buffer->data) : 0, QPoint(x, y));
 }
 
 void DataDevice::set_selection(struct wl_client *client,
@@ -102,9 +101,15 @@ const struct wl_data_device_interface DataDevice::data_device_interface = {
     DataDevice::set_selection
 };
 
-DataDevice::DataDevice(DataDeviceManager *data_device_manager, struct wl_client *client, uint32_t id)
+DataDevice::DataDevice(DataDeviceManager *data_device_manager, InputDevice *input_device, struct wl_client *client, uint32_t id)
     : m_data_device_manager(data_device_manager)
+    , m_input_device(input_device)
     , m_sent_selection_time(0)
+    , m_sent_selection_serial(0)
+    , m_drag_source(0)
+    , m_drag_icon(0)
+    , m_drag_focus(0)
+    , m_drag_motion_pending(false)
 {
 
     static int i = 0;
@@ -113,8 +118,21 @@ DataDevice::DataDevice(DataDeviceManager *data_device_manager, struct wl_client
             wl_client_add_object(client,&wl_data_device_interface,&data_device_interface,id, this);
 }
 
+DataDevice::~DataDevice()
+{
+    if (m_drag_source)
+        m_input_device->endPointerGrab();
+}
+
 void DataDevice::sendSelectionFocus()
 {
+    // Nothing changed since the last offer this client got, so the
+    // selection it already has is still valid.
+    uint serial = m_data_device_manager->selectionSerial();
+    if (serial == m_sent_selection_serial)
+        return;
+    m_sent_selection_serial = serial;
+
     if (m_data_device_manager->offerFromCompositorToClient(m_data_device_resource))
         return;
 
@@ -140,4 +158,183 @@ struct wl_resource *DataDevice::dataDeviceResource() const
     return m_data_device_resource;
 }
 
+void DataDevice::startDrag(DataSource *source, Surface *icon)
+{
+    // Only the client having the pointer can start a drag, typically in
+    // response to a button press, and only one drag per seat at a time
+    if (!source)
+        return;
+    // A rejected drag is cancelled right away, the client is waiting for it
+    Surface *focus = m_input_device->mouseFocus();
+    if (m_input_device->dragDevice()
+            || !focus || focus->base()->resource.client != m_data_device_resource->client) {
+        source->cancel();
+        return;
+    }
+
+    m_input_device->startPointerGrab(this);
+    m_input_device->setDragDevice(this);
+    m_drag_source = source;
+    m_drag_source->setDragDevice(this);
+
+    // The icon follows the pointer without any commits from the client,
+    // and never is a drop target itself
+    m_drag_icon = icon;
+    m_drag_icon_hotspot = QPoint();
+    if (m_drag_icon)
+        m_drag_icon->setInputRegion(QRegion());
+
+    motion(m_input_device->pointerPos());
+}
+
+void DataDevice::setDragIcon(struct wl_buffer *buffer, const QPoint &hotspot)
+{
+    if (!m_drag_source || !m_drag_icon)
+        return;
+    m_drag_icon_hotspot = hotspot;
+    m_drag_icon->setPos(m_drag_pos - hotspot);
+    if (buffer)
+        m_drag_icon->attachBuffer(buffer);
+}
+
+void DataDevice::motion(const QPoint &globalPos)
+{
+    m_drag_pos = globalPos;
+    if (m_drag_icon)
+        m_drag_icon->setPos(globalPos - m_drag_icon_hotspot);
+
+    // Targets only see the position the pointer has when the frame is
+    // done, the timer catches an idle compositor
+    if (!m_drag_motion_pending) {
+        m_drag_motion_pending = true;
+        int latency = m_input_device->motionCoalescingLatency();
+        m_input_device->compositor()->scheduleMotionFlush(latency > 0 ? latency : 16);
+    }
+}
+
+void DataDevice::button(Qt::MouseButton button, bool pressed)
+{
+    Q_UNUSED(button);
+    if (!pressed)
+        drop();
+}
+
+void DataDevice::flushDragMotion()
+{
+    if (!m_drag_motion_pending)
+        return;
+    m_drag_motion_pending = false;
+
+    QPointF local;
+    Surface *target = m_input_device->compositor()->surfaceIndex()->surfaceAt(m_drag_pos, &local);
+    if (target != m_drag_focus) {
+        setDragFocus(target, local);
+        return;
+    }
+    if (!m_drag_focus)
+        return;
+
+    DataDevice *target_device = m_input_device->dataDevice(m_drag_focus->base()->resource.client);
+    if (target_device) {
+        wl_resource_post_event(target_device->dataDeviceResource(), WL_DATA_DEVICE_MOTION,
+                               Compositor::currentTimeMsecs(), int(local.x()), int(local.y()));
+    }
+}
+
+// Offers go to the client of the surface under the pointer only, and are
+// created on enter; nothing is transferred before the drop.
+void DataDevice::setDragFocus(Surface *surface, const QPointF &localPos)
+{
+    if (m_drag_focus) {
+        DataDevice *target_device = m_input_device->dataDevice(m_drag_focus->base()->resource.client);
+        if (target_device)
+            wl_resource_post_event(target_device->dataDeviceResource(), WL_DATA_DEVICE_LEAVE);
+        m_drag_source->accept(QByteArray());
+        m_drag_focus = 0;
+    }
+
+    if (!surface)
+        return;
+
+    struct wl_client *client = surface->base()->resource.client;
+    DataDevice *target_device = m_input_device->dataDevice(client);
+    if (!target_device)
+        return;
+
+    // Going back to a client in the same drag reuses its offer
+    DataOffer *offer = m_drag_source->dataOffer();
+    struct wl_resource *offer_resource = offer->resourceForClient(client);
+    if (!offer_resource)
+        offer_resource = offer->addDataDeviceResource(target_device->dataDeviceResource());
+
+    m_drag_focus = surface;
+    wl_resource_post_event(target_device->dataDeviceResource(), WL_DATA_DEVICE_ENTER,
+                           Compositor::currentTimeMsecs(), surface->base(),
+                           int(localPos.x()), int(localPos.y()), offer_resource);
+}
+
+void DataDevice::drop()
+{
+    if (!m_drag_source)
+        return;
+
+    // The target has to see where the drop happens
+    flushDragMotion();
+
+    DataDevice *target_device = 0;
+    if (m_drag_focus && !m_drag_source->acceptedType().isEmpty())
+        target_device = m_input_device->dataDevice(m_drag_focus->base()->resource.client);
+
+    if (target_device) {
+        wl_resource_post_event(target_device->dataDeviceResource(), WL_DATA_DEVICE_DROP);
+        m_drag_source->dropped(target_device->dataDeviceResource()->client);
+        m_data_device_manager->dropStarted(m_drag_source);
+        // The target is done with the drag, no leave
+        m_drag_focus = 0;
+    }
+
+    m_input_device->endPointerGrab();
+}
+
+void DataDevice::end()
+{
+    DataSource *source = m_drag_source;
+    if (source) {
+        setDragFocus(0, QPointF());
+        source->setDragDevice(0);
+        if (!source->isDropped())
+            source->cancel();
+    }
+
+    m_drag_source = 0;
+    m_drag_icon = 0;
+    m_drag_focus = 0;
+    m_drag_motion_pending = false;
+    if (m_input_device->dragDevice() == this)
+        m_input_device->setDragDevice(0);
+}
+
+void DataDevice::dragSourceDestroyed()
+{
+    if (m_drag_focus) {
+        DataDevice *target_device = m_input_device->dataDevice(m_drag_focus->base()->resource.client);
+        if (target_device)
+            wl_resource_post_event(target_device->dataDeviceResource(), WL_DATA_DEVICE_LEAVE);
+        m_drag_focus = 0;
+    }
+    m_drag_source = 0;
+    m_input_device->endPointerGrab();
+}
+
+void DataDevice::surfaceDestroyed(Surface *surface)
+{
+    if (surface == m_drag_icon)
+        m_drag_icon = 0;
+    // The client is getting rid of the window, no leave for it
+    if (surface == m_drag_focus) {
+        m_drag_focus = 0;
+        m_drag_source->accept(QByteArray());
+    }
+}
+
 }
@@ -42,16 +42,22 @@
 #define WLDATADEVICE_H
 
 #include "wldatadevicemanager.h"
+#include "wlinputdevice.h"
+
+#include <QtCore/QPoint>
 
 namespace Wayland {
 
 class DataSource;
 class DataDeviceManager;
+class Surface;
 
-class DataDevice
+// Also acts as the pointer grab of drags started by its client
+class DataDevice : public PointerGrab
 {
 public:
-    DataDevice(DataDeviceManager *data_device_manager, struct wl_client *client, uint32_t id);
+    DataDevice(DataDeviceManager *data_device_manager, InputDevice *input_device, struct wl_client *client, uint32_t id);
+    ~DataDevice();
 
     void createAndSetSelectionSource(struct wl_client *client, uint32_t id, const char *name, uint32_t time);
     void sendSelectionFocus();
@@ -59,11 +65,35 @@ public:
     struct wl_resource *dataDeviceResource() const;
 
     struct wl_display *display() const { return m_data_device_manager->display(); }
+
+    bool isDragging() const { return m_drag_source != 0; }
+    void flushDragMotion();
+    void drop();
+    void dragSourceDestroyed();
+    void surfaceDestroyed(Surface *surface);
+
+    void motion(const QPoint &globalPos);
+    void button(Qt::MouseButton button, bool pressed);
+    void end();
+
 private:
+    void startDrag(DataSource *source, Surface *icon);
+    void setDragIcon(struct wl_buffer *buffer, const QPoint &hotspot);
+    void setDragFocus(Surface *surface, const QPointF &localPos);
+
     DataDeviceManager *m_data_device_manager;
+    InputDevice *m_input_device;
     uint32_t m_sent_selection_time;
+    uint m_sent_selection_serial;
     struct wl_resource *m_data_device_resource;
 
+    DataSource *m_drag_source;
+    Surface *m_drag_icon;
+    QPoint m_drag_icon_hotspot;
+    Surface *m_drag_focus;
+    QPoint m_drag_pos;
+    bool m_drag_motion_pending;
+
     static const struct wl_data_device_interface data_device_interface;
     static void start_drag(struct wl_client *client,
                        struct wl_resource *resource,
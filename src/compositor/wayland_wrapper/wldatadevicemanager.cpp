@@ -50,22 +50,52 @@
 
 #include <QtCore/QDebug>
 #include <QtCore/QSocketNotifier>
+#include <QtCore/QTimer>
 #include <fcntl.h>
+#include <sys/ioctl.h>
 #include <QtCore/private/qcore_unix_p.h>
-#include <QtCore/QFile>
 #include <QtCore/QStringList>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
 
 namespace Wayland {
 
+// Enough for all the types a toolkit typically offers
+static const int maxConcurrentRetainReads = 8;
+static const int retainReadChunkSize = 64 * 1024;
+static const int selectionWriteChunkSize = 64 * 1024;
+// How long a drop target may keep the source busy after the drop
+static const int dropGracePeriod = 5000;
+
 DataDeviceManager::DataDeviceManager(Compositor *compositor)
     : m_compositor(compositor)
     , m_current_selection_source(0)
-    , m_retainedReadNotifier(0)
+    , m_selection_serial(1)
+    , m_retainedBytes(0)
+    , m_retainPolicy(RetainPreferredTypes)
+    , m_retainLimit(0)
     , m_compositorOwnsSelection(false)
 {
+    m_retainPreferredTypes << QByteArray("text/plain;charset=utf-8")
+                           << QByteArray("text/plain")
+                           << QByteArray("UTF8_STRING")
+                           << QByteArray("text/uri-list")
+                           << QByteArray("text/html");
+
+    m_conversionCache.setMimeData(&m_retainedData);
+    connect(&m_conversionCache, SIGNAL(converted(QString,QByteArray)),
+            SLOT(selectionConverted(QString,QByteArray)));
+
     wl_display_add_global(compositor->wl_display(), &wl_data_device_manager_interface, this, DataDeviceManager::bind_func_drag);
 }
 
+DataDeviceManager::~DataDeviceManager()
+{
+    foreach (int fd, m_selectionWrites.keys())
+        finishWriteToClient(fd);
+}
+
 void DataDeviceManager::setCurrentSelectionSource(DataSource *source)
 {
     if (m_current_selection_source
@@ -80,36 +110,106 @@ void DataDeviceManager::setCurrentSelectionSource(DataSource *source)
 
     m_current_selection_source = source;
     source->setManager(this);
+    ++m_selection_serial;
 
-    // When retained selection is enabled, the compositor will query all the data from the client.
+    // When retained selection is enabled, the compositor will query data from the client.
     // This makes it possible to
     //    1. supply the selection after the offering client is gone
     //    2. make it possible for the compositor to participate in copy-paste
     // The downside is decreased performance, therefore this mode has to be enabled
-    // explicitly in the compositors.
+    // explicitly in the compositors. By default only the preferred (text) types are
+    // copied, anything else has to be asked for with requestRetainedType().
     if (m_compositor->wantsRetainedSelection()) {
+        resetConversions();
         m_retainedData.clear();
-        m_retainedReadIndex = 0;
+        m_retainedBytes = 0;
+        m_retainQueue.clear();
+        const QList<QByteArray> offers = source->offerList();
+        switch (m_retainPolicy) {
+        case RetainAllTypes:
+            m_retainQueue = offers;
+            break;
+        case RetainPreferredTypes:
+            foreach (const QByteArray &mimeType, m_retainPreferredTypes) {
+                if (offers.contains(mimeType))
+                    m_retainQueue.append(mimeType);
+            }
+            break;
+        case RetainRequestedTypes:
+            break;
+        }
         retain();
     }
 }
 
+void DataDeviceManager::requestRetainedType(const QByteArray &mimeType)
+{
+    DataSource *source = m_current_selection_source;
+    if (!m_compositor->wantsRetainedSelection() || !source || !source->client())
+        return;
+    if (!source->offerList().contains(mimeType)
+            || m_retainedData.hasFormat(QString::fromLatin1(mimeType))
+            || m_retainQueue.contains(mimeType))
+        return;
+    foreach (const RetainRead &read, m_retainReads) {
+        if (read.mimeType == mimeType)
+            return;
+    }
+
+    m_retainQueue.append(mimeType);
+    retain();
+}
+
 void DataDeviceManager::sourceDestroyed(DataSource *source)
 {
-    if (m_current_selection_source == source)
+    if (m_current_selection_source == source) {
         finishReadFromClient();
+        m_current_selection_source = 0;
+        m_retainQueue.clear();
+        // Clients get the retained copy, if any, on their next focus
+        ++m_selection_serial;
+    }
+    delete m_dropTimers.take(source);
+}
+
+// Targets normally end a drop by destroying their offer, but one that
+// keeps it around must not keep the source client waiting forever
+void DataDeviceManager::dropStarted(DataSource *source)
+{
+    source->setManager(this);
+    QTimer *timer = m_dropTimers.value(source);
+    if (!timer) {
+        timer = new QTimer(this);
+        timer->setSingleShot(true);
+        connect(timer, SIGNAL(timeout()), SLOT(dropTimedOut()));
+        m_dropTimers.insert(source, timer);
+    }
+    timer->start(dropGracePeriod);
+}
+
+void DataDeviceManager::dropTimedOut()
+{
+    QTimer *timer = static_cast<QTimer *>(sender());
+    DataSource *source = m_dropTimers.key(timer);
+    m_dropTimers.remove(source);
+    timer->deleteLater();
+    if (source)
+        source->finishDrop();
 }
 
+// Asks for all queued types at once, so the source client can answer
+// them in a single pass instead of one wakeup per type.
 void DataDeviceManager::retain()
 {
-    QList<QByteArray> offers = m_current_selection_source->offerList();
-    finishReadFromClient();
-    if (m_retainedReadIndex >= offers.count()) {
+    while (!m_retainQueue.isEmpty() && m_retainReads.count() < maxConcurrentRetainReads)
+        startRetainRead(m_retainQueue.takeFirst());
+
+    if (m_retainReads.isEmpty())
         m_compositor->feedRetainedSelectionData(&m_retainedData);
-        return;
-    }
-    QByteArray mimeType = offers.at(m_retainedReadIndex);
-    m_retainedReadBuf.clear();
+}
+
+void DataDeviceManager::startRetainRead(const QByteArray &mimeType)
+{
     int fd[2];
     if (pipe(fd) == -1) {
         qWarning("Clipboard: Failed to create pipe");
@@ -118,29 +218,25 @@ void DataDeviceManager::retain()
     fcntl(fd[0], F_SETFL, fcntl(fd[0], F_GETFL, 0) | O_NONBLOCK);
     m_current_selection_source->postSendEvent(mimeType, fd[1]);
     close(fd[1]);
-    m_retainedReadNotifier = new QSocketNotifier(fd[0], QSocketNotifier::Read, this);
-    connect(m_retainedReadNotifier, SIGNAL(activated(int)), SLOT(readFromClient(int)));
+
+    RetainRead read;
+    read.mimeType = mimeType;
+    read.notifier = new QSocketNotifier(fd[0], QSocketNotifier::Read, this);
+    connect(read.notifier, SIGNAL(activated(int)), SLOT(readFromClient(int)));
+    m_retainReads.insert(fd[0], read);
 }
 
-void DataDeviceManager::finishReadFromClient(bool exhausted)
+void DataDeviceManager::finishReadFromClient()
 {
-    if (m_retainedReadNotifier) {
-        if (exhausted) {
-            int fd = m_retainedReadNotifier->socket();
-            delete m_retainedReadNotifier;
-            close(fd);
-        } else {
-            // Do not close the handle or destroy the read notifier here
-            // or else clients may SIGPIPE.
-            m_obsoleteRetainedReadNotifiers.append(m_retainedReadNotifier);
-        }
-        m_retainedReadNotifier = 0;
-    }
+    // Do not close the handles or destroy the read notifiers here
+    // or else clients may SIGPIPE.
+    foreach (const RetainRead &read, m_retainReads)
+        m_obsoleteRetainedReadNotifiers.append(read.notifier);
+    m_retainReads.clear();
 }
 
 void DataDeviceManager::readFromClient(int fd)
 {
-    static char buf[4096];
     int obsCount = m_obsoleteRetainedReadNotifiers.count();
     for (int i = 0; i < obsCount; ++i) {
         QSocketNotifier *sn = m_obsoleteRetainedReadNotifiers.at(i);
@@ -148,6 +244,7 @@ void DataDeviceManager::readFromClient(int fd)
             // Read and drop the data, stopping to read and closing the handle
             // is not yet safe because that could kill the client with SIGPIPE
             // when it still tries to write.
+            static char buf[4096];
             int n;
             do {
                 n = QT_READ(fd, buf, sizeof buf);
@@ -160,19 +257,61 @@ void DataDeviceManager::readFromClient(int fd)
             return;
         }
     }
-    int n = QT_READ(fd, buf, sizeof buf);
-    if (n <= 0) {
-        if (n != -1 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
-            finishReadFromClient(true);
-            QList<QByteArray> offers = m_current_selection_source->offerList();
-            QString mimeType = QString::fromLatin1(offers.at(m_retainedReadIndex));
-            m_retainedData.setData(mimeType, m_retainedReadBuf);
-            ++m_retainedReadIndex;
-            retain();
+
+    QHash<int, RetainRead>::iterator it = m_retainReads.find(fd);
+    if (it == m_retainReads.end())
+        return;
+
+    // Read straight into the payload, sized by what the pipe holds, until
+    // it is drained. QByteArray grows geometrically, so this does not
+    // reallocate per chunk.
+    int n;
+    do {
+        int available = 0;
+        if (ioctl(fd, FIONREAD, &available) == -1 || available <= 0)
+            available = retainReadChunkSize;
+        QByteArray &data = it->data;
+        const int size = data.size();
+        data.resize(size + available);
+        n = QT_READ(fd, data.data() + size, available);
+        data.resize(size + qMax(n, 0));
+        m_retainedBytes += qMax(n, 0);
+        if (m_retainLimit > 0 && m_retainedBytes > m_retainLimit) {
+            abortRetain(it->mimeType);
+            return;
         }
+    } while (n > 0);
+
+    if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return;
+
+    RetainRead read = *it;
+    m_retainReads.erase(it);
+    delete read.notifier;
+    close(fd);
+    // The payload is handed over as is, implicitly shared and not copied
+    if (n == 0) {
+        resetConversions();
+        m_retainedData.setData(QString::fromLatin1(read.mimeType), read.data);
     } else {
-        m_retainedReadBuf.append(buf, n);
+        qWarning("Clipboard: Failed to read %s from the selection owner", read.mimeType.constData());
     }
+    retain();
+}
+
+// The selection is larger than the compositor is willing to hold. Keep
+// the types read completely so far and stop asking for more. The partial
+// reads are dropped and no longer count against the limit, so a smaller
+// type can still be requested later.
+void DataDeviceManager::abortRetain(const QByteArray &mimeType)
+{
+    qWarning("Clipboard: retained selection exceeds %d bytes, not retaining %s",
+             m_retainLimit, mimeType.constData());
+    foreach (const RetainRead &read, m_retainReads)
+        m_retainedBytes -= read.data.size();
+    finishReadFromClient();
+    m_retainQueue.clear();
+    m_compositor->feedRetainedSelectionData(&m_retainedData);
 }
 
 DataSource *DataDeviceManager::currentSelectionSource()
@@ -228,6 +367,11 @@ void DataDeviceManager::overrideSelection(const QMimeData &mimeData)
     if (formats.isEmpty())
         return;
 
+    // Whatever was still being read from the previous owner is stale now
+    finishReadFromClient();
+    m_retainQueue.clear();
+
+    resetConversions();
     m_retainedData.clear();
     foreach (const QString &format, formats)
         m_retainedData.setData(format, mimeData.data(format));
@@ -235,12 +379,10 @@ void DataDeviceManager::overrideSelection(const QMimeData &mimeData)
     m_compositor->feedRetainedSelectionData(&m_retainedData);
 
     m_compositorOwnsSelection = true;
+    ++m_selection_serial;
 
-    InputDevice *dev = m_compositor->defaultInputDevice();
-    Surface *focusSurface = dev->keyboardFocus();
-    if (focusSurface)
-        offerFromCompositorToClient(
-                    dev->dataDevice(focusSurface->base()->resource.client)->dataDeviceResource());
+    foreach (InputDevice *dev, m_compositor->inputDevices())
+        dev->sendSelectionFocus(dev->keyboardFocus());
 }
 
 bool DataDeviceManager::offerFromCompositorToClient(wl_resource *clientDataDeviceResource)
@@ -280,12 +422,113 @@ void DataDeviceManager::comp_receive(wl_client *client, wl_resource *resource, c
 {
     DataDeviceManager *self = static_cast<DataDeviceManager *>(resource->data);
     qDebug("client %p wants data for type %s from compositor", client, mime_type);
-    QByteArray content = QWaylandMimeHelper::getByteArray(&self->m_retainedData, QString::fromLatin1(mime_type));
-    if (!content.isEmpty()) {
-        QFile f;
-        if (f.open(fd, QIODevice::WriteOnly))
-            f.write(content);
+    self->serveSelection(QString::fromLatin1(mime_type), fd);
+}
+
+// Nothing here may block: the client reads at its own pace, and a client
+// that never reads must not stall the compositor.
+void DataDeviceManager::serveSelection(const QString &mimeType, int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    SelectionWrite write;
+    write.offset = 0;
+    write.notifier = 0;
+    m_selectionWrites.insert(fd, write);
+
+    QByteArray content;
+    if (m_conversionCache.lookup(mimeType, &content))
+        startWriteToClient(fd, content);
+    else
+        m_waitingWrites.insert(mimeType, fd);
+}
+
+void DataDeviceManager::selectionConverted(const QString &mimeType, const QByteArray &content)
+{
+    foreach (int fd, m_waitingWrites.values(mimeType))
+        startWriteToClient(fd, content);
+    m_waitingWrites.remove(mimeType);
+}
+
+// Must precede every change of the retained data: conversions read it from
+// a worker thread. Pastes still waiting for the old data get nothing.
+void DataDeviceManager::resetConversions()
+{
+    m_conversionCache.setMimeData(&m_retainedData);
+    foreach (int fd, m_waitingWrites)
+        finishWriteToClient(fd);
+    m_waitingWrites.clear();
+}
+
+void DataDeviceManager::startWriteToClient(int fd, const QByteArray &content)
+{
+    if (content.isEmpty()) {
+        finishWriteToClient(fd);
+        return;
     }
+
+    SelectionWrite &write = m_selectionWrites[fd];
+    write.data = content;
+    write.notifier = new QSocketNotifier(fd, QSocketNotifier::Write, this);
+    connect(write.notifier, SIGNAL(activated(int)), SLOT(writeToClient(int)));
+    writeToClient(fd);
+}
+
+// A client closing its end early must not take the compositor down. The
+// signal disposition belongs to the application, so SIGPIPE is only blocked
+// for the calling thread while writing, and a SIGPIPE raised by the write is
+// consumed before it is unblocked again.
+static int writeWithoutSigpipe(int fd, const char *data, int size)
+{
+    sigset_t sigpipeMask;
+    sigemptyset(&sigpipeMask);
+    sigaddset(&sigpipeMask, SIGPIPE);
+
+    sigset_t pending;
+    sigemptyset(&pending);
+    sigpending(&pending);
+    bool sigpipePending = sigismember(&pending, SIGPIPE);
+
+    sigset_t oldMask;
+    pthread_sigmask(SIG_BLOCK, &sigpipeMask, &oldMask);
+
+    int n = QT_WRITE(fd, data, size);
+    int writeErrno = errno;
+
+    if (n == -1 && writeErrno == EPIPE && !sigpipePending) {
+        struct timespec noWait = { 0, 0 };
+        while (sigtimedwait(&sigpipeMask, 0, &noWait) == -1 && errno == EINTR)
+            ;
+    }
+
+    pthread_sigmask(SIG_SETMASK, &oldMask, 0);
+    errno = writeErrno;
+    return n;
+}
+
+void DataDeviceManager::writeToClient(int fd)
+{
+    QHash<int, SelectionWrite>::iterator it = m_selectionWrites.find(fd);
+    if (it == m_selectionWrites.end() || !it->notifier)
+        return;
+
+    while (it->offset < it->data.size()) {
+        int n = writeWithoutSigpipe(fd, it->data.constData() + it->offset,
+                                    qMin(selectionWriteChunkSize, it->data.size() - it->offset));
+        if (n == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return;
+            // The client went away or stopped reading, drop the transfer
+            break;
+        }
+        it->offset += n;
+    }
+    finishWriteToClient(fd);
+}
+
+void DataDeviceManager::finishWriteToClient(int fd)
+{
+    SelectionWrite write = m_selectionWrites.take(fd);
+    delete write.notifier;
     close(fd);
 }
 
@@ -43,12 +43,16 @@
 
 #include "wlcompositor.h"
 
+#include <QtCore/QHash>
 #include <QtCore/QList>
 #include <QtCore/QMap>
 #include <QtGui/QClipboard>
 #include <QtCore/QMimeData>
 
+#include "qwaylandmimehelper.h"
+
 class QSocketNotifier;
+class QTimer;
 
 namespace Wayland {
 
@@ -62,14 +66,33 @@ class DataDeviceManager : public QObject
     Q_OBJECT
 
 public:
+    // Which of the offered types are copied into the compositor when
+    // retained selection is enabled.
+    enum RetainPolicy {
+        RetainAllTypes,
+        RetainPreferredTypes,
+        RetainRequestedTypes
+    };
+
     DataDeviceManager(Compositor *compositor);
+    ~DataDeviceManager();
+
+    void setRetainPolicy(RetainPolicy policy) { m_retainPolicy = policy; }
+    RetainPolicy retainPolicy() const { return m_retainPolicy; }
+    void setRetainPreferredTypes(const QList<QByteArray> &mimeTypes) { m_retainPreferredTypes = mimeTypes; }
+    QList<QByteArray> retainPreferredTypes() const { return m_retainPreferredTypes; }
+    void setRetainLimit(int bytes) { m_retainLimit = bytes; }
+    int retainLimit() const { return m_retainLimit; }
+    void requestRetainedType(const QByteArray &mimeType);
 
     void setCurrentSelectionSource(DataSource *source);
     DataSource *currentSelectionSource();
+    uint selectionSerial() const { return m_selection_serial; }
 
     struct wl_display *display() const;
 
     void sourceDestroyed(DataSource *source);
+    void dropStarted(DataSource *source);
 
     void overrideSelection(const QMimeData &mimeData);
     bool offerFromCompositorToClient(wl_resource *clientDataDeviceResource);
@@ -77,15 +100,28 @@ public:
 
 private slots:
     void readFromClient(int fd);
+    void writeToClient(int fd);
+    void selectionConverted(const QString &mimeType, const QByteArray &content);
+    void dropTimedOut();
 
 private:
     void retain();
-    void finishReadFromClient(bool exhausted = false);
+    void startRetainRead(const QByteArray &mimeType);
+    void finishReadFromClient();
+    void abortRetain(const QByteArray &mimeType);
+    void serveSelection(const QString &mimeType, int fd);
+    void startWriteToClient(int fd, const QByteArray &content);
+    void finishWriteToClient(int fd);
+    void resetConversions();
 
     Compositor *m_compositor;
     QList<DataDevice *> m_data_device_list;
 
     DataSource *m_current_selection_source;
+    uint m_selection_serial;
+
+    // Drops whose target has not let go of the offer yet
+    QHash<DataSource *, QTimer *> m_dropTimers;
 
     static void bind_func_drag(struct wl_client *client, void *data,
                      uint32_t version, uint32_t id);
@@ -101,13 +137,34 @@ private:
     static struct wl_data_device_manager_interface drag_interface;
 
     QMimeData m_retainedData;
-    QSocketNotifier *m_retainedReadNotifier;
+    // One pipe per type being retained, keyed by the read end
+    struct RetainRead {
+        QByteArray mimeType;
+        QByteArray data;
+        QSocketNotifier *notifier;
+    };
+    QHash<int, RetainRead> m_retainReads;
     QList<QSocketNotifier *> m_obsoleteRetainedReadNotifiers;
-    int m_retainedReadIndex;
-    QByteArray m_retainedReadBuf;
+    QList<QByteArray> m_retainQueue;
+    int m_retainedBytes;
+
+    RetainPolicy m_retainPolicy;
+    QList<QByteArray> m_retainPreferredTypes;
+    int m_retainLimit;
 
     bool m_compositorOwnsSelection;
 
+    // Pastes of the compositor's own selection, keyed by the client's fd
+    struct SelectionWrite {
+        QByteArray data;
+        int offset;
+        QSocketNotifier *notifier;
+    };
+    QHash<int, SelectionWrite> m_selectionWrites;
+    // Pastes waiting for their type to be converted
+    QMultiHash<QString, int> m_waitingWrites;
+    QWaylandMimeCache m_conversionCache;
+
 
     static void comp_accept(struct wl_client *client,
                             struct wl_resource *resource,
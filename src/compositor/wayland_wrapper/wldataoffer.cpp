@@ -41,6 +41,7 @@
 #include "wldataoffer.h"
 
 #include "wldatadevice.h"
+#include "wlcompositor.h"
 
 #include <wayland-server.h>
 
@@ -72,6 +73,8 @@ struct wl_resource *DataOffer::addDataDeviceResource(struct wl_resource *data_de
     wl_resource_post_event(data_device_resource,WL_DATA_DEVICE_DATA_OFFER,new_object);
 
     registerResource(new_object);
+    if (!m_data_source)
+        return new_object;
     QList<QByteArray> offer_list = m_data_source->offerList();
     for (int i = 0; i < offer_list.size(); i++) {
         wl_resource_post_event(new_object, WL_DATA_OFFER_OFFER, offer_list.at(i).constData());
@@ -79,6 +82,13 @@ struct wl_resource *DataOffer::addDataDeviceResource(struct wl_resource *data_de
     return new_object;
 }
 
+void DataOffer::sourceDestroyed()
+{
+    m_data_source = 0;
+    if (resourceListIsEmpty())
+        delete this;
+}
+
 const struct wl_data_offer_interface DataOffer::data_interface = {
     DataOffer::accept,
     DataOffer::receive,
@@ -88,9 +98,10 @@ const struct wl_data_offer_interface DataOffer::data_interface = {
 void DataOffer::accept(wl_client *client, wl_resource *resource, uint32_t time, const char *type)
 {
     Q_UNUSED(client);
-    Q_UNUSED(resource);
     Q_UNUSED(time);
-    Q_UNUSED(type);
+    DataOffer *offer = static_cast<DataOffer *>(resource->data);
+    if (offer->m_data_source)
+        offer->m_data_source->accept(QByteArray(type));
 }
 
 void DataOffer::receive(wl_client *client, wl_resource *resource, const char *mime_type, int32_t fd)
@@ -98,17 +109,21 @@ void DataOffer::receive(wl_client *client, wl_resource *resource, const char *mi
     Q_UNUSED(client);
 
     DataOffer *offer = static_cast<DataOffer *>(resource->data);
-    offer->m_data_source->postSendEvent(mime_type,fd);
+    // Closing the fd right away tells the receiver there is nothing to read
+    if (offer->m_data_source)
+        offer->m_data_source->postSendEvent(mime_type,fd);
     close(fd);
 }
 
 void DataOffer::destroy(wl_client *client, wl_resource *resource)
 {
-    Q_UNUSED(client);
     qDebug() << "dataOFFER DESTROY!";
     DataOffer *data_offer = static_cast<DataOffer *>(resource->data);
+    if (data_offer->m_data_source)
+        data_offer->m_data_source->offerDestroyed(client);
+    wl_resource_destroy(resource, Compositor::currentTimeMsecs());
 
-    if (data_offer->resourceListIsEmpty()) {
+    if (data_offer->resourceListIsEmpty() && !data_offer->m_data_source) {
         delete data_offer;
     }
 }
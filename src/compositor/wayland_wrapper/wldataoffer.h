@@ -55,6 +55,9 @@ public:
     ~DataOffer();
 
     struct wl_resource *addDataDeviceResource(struct wl_resource *client_resource);
+
+    // Offers outlive their source as long as a client holds on to them
+    void sourceDestroyed();
 private:
     DataSource *m_data_source;
 
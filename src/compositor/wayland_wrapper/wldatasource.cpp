@@ -41,6 +41,7 @@
 #include "wldatasource.h"
 #include "wldataoffer.h"
 #include "wldatadevicemanager.h"
+#include "wldatadevice.h"
 #include "wlcompositor.h"
 #include <wayland-server.h>
 #include <QtCore/QDebug>
@@ -54,6 +55,8 @@ DataSource::DataSource(struct wl_client *client, uint32_t id, uint32_t time)
     m_data_source_resource->destroy = resource_destroy;
     m_data_offer = new DataOffer(this);
     m_manager = 0;
+    m_drag_device = 0;
+    m_drop_target = 0;
 }
 
 DataSource::~DataSource()
@@ -61,6 +64,9 @@ DataSource::~DataSource()
     qDebug() << "destroying source";
     if (m_manager)
         m_manager->sourceDestroyed(this);
+    if (m_drag_device)
+        m_drag_device->dragSourceDestroyed();
+    m_data_offer->sourceDestroyed();
     wl_resource_destroy(m_data_source_resource,Compositor::currentTimeMsecs());
 }
 
@@ -128,4 +134,44 @@ void DataSource::setManager(DataDeviceManager *mgr)
     m_manager = mgr;
 }
 
+// Targets tend to accept on every motion, the source only hears about
+// changes
+void DataSource::accept(const QByteArray &mimeType)
+{
+    if (!m_drag_device || mimeType == m_accepted_type)
+        return;
+    m_accepted_type = mimeType;
+    if (m_data_source_resource) {
+        wl_resource_post_event(m_data_source_resource, WL_DATA_SOURCE_TARGET,
+                               m_accepted_type.isEmpty() ? 0 : m_accepted_type.constData());
+    }
+}
+
+void DataSource::dropped(struct wl_client *target)
+{
+    m_drop_target = target;
+}
+
+// A drop is done once the target has let go of its offer, the source
+// learns about it through cancelled, as for a drag that was not dropped
+void DataSource::offerDestroyed(struct wl_client *client)
+{
+    if (m_drop_target && client == m_drop_target)
+        finishDrop();
+}
+
+void DataSource::finishDrop()
+{
+    if (!m_drop_target)
+        return;
+    m_drop_target = 0;
+    cancel();
+}
+
+void DataSource::cancel()
+{
+    if (m_data_source_resource)
+        wl_resource_post_event(m_data_source_resource, WL_DATA_SOURCE_CANCELLED);
+}
+
 }
@@ -49,6 +49,7 @@
 namespace Wayland {
 
 class DataOffer;
+class DataDevice;
 class DataDeviceManager;
 
 class DataSource
@@ -66,6 +67,15 @@ public:
 
     void setManager(DataDeviceManager *mgr);
 
+    void setDragDevice(DataDevice *device) { m_drag_device = device; }
+    void accept(const QByteArray &mimeType);
+    QByteArray acceptedType() const { return m_accepted_type; }
+    void dropped(struct wl_client *target);
+    bool isDropped() const { return m_drop_target != 0; }
+    void offerDestroyed(struct wl_client *client);
+    void finishDrop();
+    void cancel();
+
 private:
     uint32_t m_time;
     QList<QByteArray> m_offers;
@@ -75,6 +85,10 @@ private:
 
     DataDeviceManager *m_manager;
 
+    DataDevice *m_drag_device;
+    QByteArray m_accepted_type;
+    struct wl_client *m_drop_target;
+
     static struct wl_data_source_interface data_source_interface;
     static void offer(struct wl_client *client,
                   struct wl_resource *resource,
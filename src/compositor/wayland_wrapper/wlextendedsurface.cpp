@@ -43,6 +43,8 @@
 #include "wlcompositor.h"
 #include "wlsurface.h"
 
+#include <stdlib.h>
+
 namespace Wayland {
 
 SurfaceExtensionGlobal::SurfaceExtensionGlobal(Compositor *compositor)
@@ -57,8 +59,18 @@ SurfaceExtensionGlobal::SurfaceExtensionGlobal(Compositor *compositor)
 void SurfaceExtensionGlobal::bind_func(struct wl_client *client, void *data,
                       uint32_t version, uint32_t id)
 {
-    Q_UNUSED(version);
-    wl_client_add_object(client, &wl_surface_extension_interface,&surface_extension_interface,id,data);
+    SurfaceExtensionGlobal *extension_global = static_cast<SurfaceExtensionGlobal *>(data);
+    struct wl_resource *resource =
+            wl_client_add_object(client, &wl_surface_extension_interface,&surface_extension_interface,id,data);
+    resource->destroy = destroy_resource;
+    extension_global->m_versions.insert(resource, version);
+}
+
+void SurfaceExtensionGlobal::destroy_resource(struct wl_resource *resource)
+{
+    SurfaceExtensionGlobal *extension_global = static_cast<SurfaceExtensionGlobal *>(resource->data);
+    extension_global->m_versions.remove(resource);
+    free(resource);
 }
 
 const struct wl_surface_extension_interface SurfaceExtensionGlobal::surface_extension_interface = {
@@ -70,13 +82,14 @@ void SurfaceExtensionGlobal::get_extended_surface(struct wl_client *client,
                              uint32_t id,
                              struct wl_resource *surface_resource)
 {
-    Q_UNUSED(surface_extension_resource);
+    SurfaceExtensionGlobal *extension_global = static_cast<SurfaceExtensionGlobal *>(surface_extension_resource->data);
     Surface *surface = resolve<Surface>(surface_resource);
-    new ExtendedSurface(client,id,surface);
+    new ExtendedSurface(client,id,extension_global->m_versions.value(surface_extension_resource, 1),surface);
 }
 
-ExtendedSurface::ExtendedSurface(struct wl_client *client, uint32_t id, Surface *surface)
+ExtendedSurface::ExtendedSurface(struct wl_client *client, uint32_t id, uint32_t version, Surface *surface)
     : m_surface(surface)
+    , m_version(version)
     , m_windowOrientation(Qt::PrimaryOrientation)
     , m_contentOrientation(Qt::PrimaryOrientation)
     , m_windowFlags(0)
@@ -92,7 +105,7 @@ ExtendedSurface::ExtendedSurface(struct wl_client *client, uint32_t id, Surface
 
 ExtendedSurface::~ExtendedSurface()
 {
-
+    m_surface->compositor()->unschedulePropertyFlush(this);
 }
 
 void ExtendedSurface::sendGenericProperty(const QString &name, const QVariant &variant)
@@ -108,6 +121,28 @@ void ExtendedSurface::sendGenericProperty(const QString &name, const QVariant &v
 
 }
 
+void ExtendedSurface::flushPendingProperties()
+{
+    if (m_pendingProperties.isEmpty())
+        return;
+
+    // Properties too large for a batch go out on their own
+    foreach (const QString &name, m_pendingProperties) {
+        const QVariant value = m_windowProperties.value(name);
+        if (!m_propertyEncoder.add(name, value))
+            sendGenericProperty(name, value);
+    }
+    m_pendingProperties.clear();
+
+    foreach (const QByteArray &batch, m_propertyEncoder.takeBatches()) {
+        wl_array data;
+        data.size = batch.size();
+        data.data = (void*) batch.constData();
+        data.alloc = 0;
+        wl_resource_post_event(m_extended_surface_resource, WL_EXTENDED_SURFACE_SET_GENERIC_PROPERTIES, &data);
+    }
+}
+
 void ExtendedSurface::sendOnScreenVisibility(bool visible)
 {
     int32_t visibleInt = visible;
@@ -127,6 +162,19 @@ void ExtendedSurface::update_generic_property(wl_client *client, wl_resource *ex
 
 }
 
+void ExtendedSurface::update_generic_properties(wl_client *client, wl_resource *extended_surface_resource, wl_array *batch)
+{
+    Q_UNUSED(client);
+    ExtendedSurface *extended_surface = static_cast<ExtendedSurface *>(extended_surface_resource->data);
+
+    QWaylandPropertyDecoder::PropertyList properties;
+    if (!extended_surface->m_propertyDecoder.decode(batch->data, batch->size, &properties))
+        qWarning("Surface extension: malformed property batch from client");
+
+    for (int i = 0; i < properties.size(); ++i)
+        extended_surface->setWindowProperty(properties.at(i).first, properties.at(i).second, false);
+}
+
 static Qt::ScreenOrientation screenOrientationFromWaylandOrientation(int32_t orientation)
 {
     switch (orientation) {
@@ -182,23 +230,44 @@ void ExtendedSurface::setWindowFlags(WaylandSurface::WindowFlags flags)
     emit m_surface->waylandSurface()->windowFlagsChanged(flags);
 }
 
-QVariantMap ExtendedSurface::windowProperties() const
-{
-    return m_windowProperties;
-}
-
 QVariant ExtendedSurface::windowProperty(const QString &propertyName) const
 {
-    QVariantMap props = m_windowProperties;
-    return props.value(propertyName);
+    return m_windowProperties.value(propertyName);
 }
 
+// Updates coming from the client pass writeUpdateToClient false, the client
+// already has the value and must not get it echoed back.
 void ExtendedSurface::setWindowProperty(const QString &name, const QVariant &value, bool writeUpdateToClient)
 {
-    Q_UNUSED(writeUpdateToClient);
-    m_windowProperties.insert(name, value);
-    m_surface->waylandSurface()->windowPropertyChanged(name,value);
-    sendGenericProperty(name, value);
+    QVariantMap::iterator it = m_windowProperties.find(name);
+
+    if (!writeUpdateToClient && m_pendingProperties.contains(name)) {
+        // The client's change crossed one of ours that did not go out yet,
+        // ours is kept and sent unless both are the same
+        if (it.value() == value)
+            m_pendingProperties.removeOne(name);
+        return;
+    }
+
+    if (it != m_windowProperties.end() && it.value() == value)
+        return;
+
+    if (it != m_windowProperties.end())
+        it.value() = value;
+    else
+        m_windowProperties.insert(name, value);
+
+    if (writeUpdateToClient) {
+        if (m_version >= 2) {
+            if (!m_pendingProperties.contains(name))
+                m_pendingProperties.append(name);
+            m_surface->compositor()->schedulePropertyFlush(this);
+        } else {
+            sendGenericProperty(name, value);
+        }
+    }
+
+    emit m_surface->waylandSurface()->windowPropertyChanged(name,value);
 }
 
 void ExtendedSurface::set_window_flags(wl_client *client, wl_resource *resource, int32_t flags)
@@ -208,11 +277,35 @@ void ExtendedSurface::set_window_flags(wl_client *client, wl_resource *resource,
     extended_surface->setWindowFlags(WaylandSurface::WindowFlags(flags));
 }
 
+void ExtendedSurface::set_input_region(wl_client *client, wl_resource *resource, wl_array *rects)
+{
+    Q_UNUSED(client);
+    ExtendedSurface *extended_surface = static_cast<ExtendedSurface *>(resource->data);
+    Surface *surface = extended_surface->m_surface;
+
+    const int32_t *data = static_cast<const int32_t *>(rects->data);
+    const int count = rects->size / (4 * sizeof(int32_t));
+    QRegion region;
+    for (int i = 0; i < count; ++i, data += 4)
+        region += QRect(data[0], data[1], data[2], data[3]);
+    surface->setInputRegion(region);
+}
+
+void ExtendedSurface::reset_input_region(wl_client *client, wl_resource *resource)
+{
+    Q_UNUSED(client);
+    ExtendedSurface *extended_surface = static_cast<ExtendedSurface *>(resource->data);
+    extended_surface->m_surface->resetInputRegion();
+}
+
 const struct wl_extended_surface_interface ExtendedSurface::extended_surface_interface = {
     ExtendedSurface::update_generic_property,
     ExtendedSurface::set_window_orientation,
     ExtendedSurface::set_content_orientation,
-    ExtendedSurface::set_window_flags
+    ExtendedSurface::set_window_flags,
+    ExtendedSurface::set_input_region,
+    ExtendedSurface::update_generic_properties,
+    ExtendedSurface::reset_input_region
 };
 
 }
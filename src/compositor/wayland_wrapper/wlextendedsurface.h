@@ -45,9 +45,11 @@
 
 #include "wlsurface.h"
 #include "waylandsurface.h"
+#include "qwaylandpropertybatch.h"
 
 #include <QtCore/QVariant>
-#include <QtCore/QLinkedList>
+#include <QtCore/QHash>
+#include <QtCore/QStringList>
 
 class WaylandSurface;
 
@@ -62,9 +64,11 @@ public:
 
 private:
     Compositor *m_compositor;
+    QHash<struct wl_resource *, uint32_t> m_versions;
 
     static void bind_func(struct wl_client *client, void *data,
                           uint32_t version, uint32_t id);
+    static void destroy_resource(struct wl_resource *resource);
     static void get_extended_surface(struct wl_client *client,
                                  struct wl_resource *resource,
                                  uint32_t id,
@@ -76,18 +80,13 @@ private:
 class ExtendedSurface
 {
 public:
-    ExtendedSurface(struct wl_client *client, uint32_t id, Surface *surface);
+    ExtendedSurface(struct wl_client *client, uint32_t id, uint32_t version, Surface *surface);
     ~ExtendedSurface();
 
     void sendGenericProperty(const QString &name, const QVariant &variant);
+    void flushPendingProperties();
     void sendOnScreenVisibility(bool visible);
 
-    void setSubSurface(ExtendedSurface *subSurface,int x, int y);
-    void removeSubSurface(ExtendedSurface *subSurfaces);
-    ExtendedSurface *parent() const;
-    void setParent(ExtendedSurface *parent);
-    QLinkedList<WaylandSurface *> subSurfaces() const;
-
     Qt::ScreenOrientation windowOrientation() const;
     Qt::ScreenOrientation contentOrientation() const;
 
@@ -96,13 +95,14 @@ public:
     qint64 processId() const;
     void setProcessId(qint64 processId);
 
-    QVariantMap windowProperties() const;
+    const QVariantMap &windowProperties() const { return m_windowProperties; }
     QVariant windowProperty(const QString &propertyName) const;
     void setWindowProperty(const QString &name, const QVariant &value, bool writeUpdateToClient = true);
 
 private:
     struct wl_resource *m_extended_surface_resource;
     Surface *m_surface;
+    uint32_t m_version;
 
     Qt::ScreenOrientation m_windowOrientation;
     Qt::ScreenOrientation m_contentOrientation;
@@ -112,12 +112,21 @@ private:
     QByteArray m_authenticationToken;
     QVariantMap m_windowProperties;
 
+    // Names of the properties set since the last batch went out, their
+    // values are read from m_windowProperties when it is sent
+    QStringList m_pendingProperties;
+    QWaylandPropertyEncoder m_propertyEncoder;
+    QWaylandPropertyDecoder m_propertyDecoder;
 
     static void update_generic_property(struct wl_client *client,
                                     struct wl_resource *resource,
                                     const char *name,
                                     struct wl_array *value);
 
+    static void update_generic_properties(struct wl_client *client,
+                                          struct wl_resource *resource,
+                                          struct wl_array *batch);
+
     static void set_window_orientation(struct wl_client *client,
                                        struct wl_resource *resource,
                                        int32_t orientation);
@@ -131,6 +140,12 @@ private:
                                  int32_t flags);
     void setWindowFlags(WaylandSurface::WindowFlags flags);
 
+    static void set_input_region(struct wl_client *client,
+                                 struct wl_resource *resource,
+                                 struct wl_array *rects);
+    static void reset_input_region(struct wl_client *client,
+                                   struct wl_resource *resource);
+
     static const struct wl_extended_surface_interface extended_surface_interface;
 };
 
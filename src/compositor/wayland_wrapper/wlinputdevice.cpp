@@ -51,24 +51,61 @@
 
 namespace Wayland {
 
-static ShmBuffer *currentCursor;
-
 InputDevice::InputDevice(WaylandInputDevice *handle, Compositor *compositor)
     : m_handle(handle)
     , m_compositor(compositor)
+    , m_drag_device(0)
+    , m_motionCoalescingLatency(qgetenv("QT_COMPOSITOR_COALESCE_MOTION").toInt())
+    , m_pendingMotionResource(0)
+    , m_pendingMotionTime(0)
+    , m_pendingMotionResampled(false)
+    , m_recorder(0)
+    , m_pointerGrab(0)
 {
     wl_input_device_init(base());
-    wl_display_add_global(compositor->wl_display(),&wl_input_device_interface,this,InputDevice::bind_func);
+    m_global = wl_display_add_global(compositor->wl_display(),&wl_input_device_interface,this,InputDevice::bind_func);
+    compositor->registerInputDevice(this);
 }
 
 InputDevice::~InputDevice()
 {
+    if (m_compositor) {
+        m_compositor->unregisterInputDevice(this);
+        wl_input_device_set_keyboard_focus(base(), 0, m_compositor->currentTimeMsecs());
+        wl_input_device_set_pointer_focus(base(), 0, m_compositor->currentTimeMsecs(), 0, 0, 0, 0);
+        wl_display_remove_global(m_compositor->wl_display(), m_global);
+    }
+    endPointerGrab();
+    qDeleteAll(m_data_devices);
+
+    // Clients may still hold the device, their objects stay around until
+    // they destroy them but no longer refer to it
+    struct wl_resource *resource, *next;
+    wl_list_for_each_safe(resource, next, &base()->resource_list, link) {
+        resource->data = 0;
+        wl_list_remove(&resource->link);
+        wl_list_init(&resource->link);
+    }
+}
+
+// Everything referring to the display goes away with the compositor, the
+// seat itself stays until the application deletes it
+void InputDevice::compositorDestroyed()
+{
+    endPointerGrab();
     qDeleteAll(m_data_devices);
+    m_data_devices.clear();
+    m_compositor = 0;
 }
 
 void InputDevice::sendMousePressEvent(Qt::MouseButton button, const QPoint &localPos, const QPoint &globalPos)
 {
     sendMouseMoveEvent(localPos,globalPos);
+    if (m_pointerGrab) {
+        m_pointerGrab->button(button, true);
+        return;
+    }
+    flushPendingMotion();
 
     uint32_t time = m_compositor->currentTimeMsecs();
     struct wl_resource *pointer_focus_resource = base()->pointer_focus_resource;
@@ -81,6 +118,14 @@ void InputDevice::sendMousePressEvent(Qt::MouseButton button, const QPoint &loca
 void InputDevice::sendMouseReleaseEvent(Qt::MouseButton button, const QPoint &localPos, const QPoint &globalPos)
 {
     sendMouseMoveEvent(localPos,globalPos);
+    // The release ending a grab still goes to the client, so that its
+    // button state stays consistent
+    if (m_pointerGrab) {
+        m_pointerGrab->button(button, false);
+        if (m_pointerGrab)
+            return;
+    }
+    flushPendingMotion();
 
     uint32_t time = m_compositor->currentTimeMsecs();
     struct wl_resource *pointer_focus_resource = base()->pointer_focus_resource;
@@ -92,10 +137,39 @@ void InputDevice::sendMouseReleaseEvent(Qt::MouseButton button, const QPoint &lo
 
 void InputDevice::sendMouseMoveEvent(const QPoint &localPos, const QPoint &globalPos)
 {
+    QPoint validGlobalPos = globalPos.isNull()?localPos:globalPos;
+    m_pointerPos = validGlobalPos;
+    if (m_pointerGrab) {
+        m_pointerGrab->motion(validGlobalPos);
+        return;
+    }
+
     uint32_t time = m_compositor->currentTimeMsecs();
     struct wl_resource *pointer_focus_resource = base()->pointer_focus_resource;
     if (pointer_focus_resource) {
-        QPoint validGlobalPos = globalPos.isNull()?localPos:globalPos;
+        int resamplingLatency = m_compositor->inputResamplingLatency();
+        if (m_motionCoalescingLatency > 0 || resamplingLatency > 0) {
+            // Only keep the latest position, it is sent when anything else
+            // is sent to the client, at the end of the frame, or when the
+            // latency limit is reached, whichever comes first.
+            if (m_pendingMotionResource && m_pendingMotionResource != pointer_focus_resource)
+                flushPendingMotion();
+            if (!m_pendingMotionResource) {
+                // When resampling, frames normally flush; the timer only
+                // catches an idle compositor
+                m_compositor->scheduleMotionFlush(m_motionCoalescingLatency > 0
+                                                  ? m_motionCoalescingLatency
+                                                  : resamplingLatency * 4);
+            }
+            if (resamplingLatency > 0)
+                m_pointerResampler.addSample(m_compositor->monotonicTimeUsecs(), validGlobalPos);
+            m_pendingMotionResource = pointer_focus_resource;
+            m_pendingMotionTime = time;
+            m_pendingMotionLocalPos = localPos;
+            m_pendingMotionGlobalPos = validGlobalPos;
+            m_pendingMotionResampled = false;
+            return;
+        }
         wl_resource_post_event(pointer_focus_resource,
                                WL_INPUT_DEVICE_MOTION,
                                time,
@@ -104,8 +178,101 @@ void InputDevice::sendMouseMoveEvent(const QPoint &localPos, const QPoint &globa
     }
 }
 
+void InputDevice::flushPendingMotion()
+{
+    if (m_drag_device)
+        m_drag_device->flushDragMotion();
+
+    struct wl_resource *resource = m_pendingMotionResource;
+    if (!resource)
+        return;
+
+    m_pendingMotionResource = 0;
+    // Motion is only meaningful to the surface it was meant for
+    if (resource != base()->pointer_focus_resource) {
+        m_pointerResampler.reset();
+        return;
+    }
+
+    wl_resource_post_event(resource,
+                           WL_INPUT_DEVICE_MOTION,
+                           m_pendingMotionTime,
+                           m_pendingMotionGlobalPos.x(), m_pendingMotionGlobalPos.y(),
+                           m_pendingMotionLocalPos.x(), m_pendingMotionLocalPos.y());
+}
+
+// Sends the pointer position at \a usecs instead of the newest one. The
+// newest position is still owed to the client then; it goes out with the
+// next frame or event unless more motion arrives before.
+void InputDevice::resamplePendingMotion(qint64 usecs)
+{
+    if (m_drag_device)
+        m_drag_device->flushDragMotion();
+
+    struct wl_resource *resource = m_pendingMotionResource;
+    if (!resource)
+        return;
+
+    QPointF globalPos;
+    bool extrapolate = usecs >= m_pointerResampler.latestTime();
+    if (resource != base()->pointer_focus_resource
+            || (extrapolate && m_pendingMotionResampled)
+            || !m_pointerResampler.resample(usecs, &globalPos)) {
+        flushPendingMotion();
+        return;
+    }
+
+    m_pendingMotionResampled = true;
+    m_compositor->scheduleMotionFlush(m_compositor->inputResamplingLatency() * 4);
+
+    QPoint global = globalPos.toPoint();
+    QPoint local = global - m_pendingMotionGlobalPos + m_pendingMotionLocalPos;
+    wl_resource_post_event(resource,
+                           WL_INPUT_DEVICE_MOTION,
+                           m_pendingMotionTime,
+                           global.x(), global.y(),
+                           local.x(), local.y());
+}
+
+void InputDevice::setMotionCoalescingLatency(int msecs)
+{
+    flushPendingMotion();
+    m_motionCoalescingLatency = msecs;
+}
+
+int InputDevice::motionCoalescingLatency() const
+{
+    return m_motionCoalescingLatency;
+}
+
+void InputDevice::startPointerGrab(PointerGrab *grab)
+{
+    if (m_pointerGrab == grab)
+        return;
+    endPointerGrab();
+    flushPendingMotion();
+    m_pointerGrab = grab;
+}
+
+void InputDevice::endPointerGrab()
+{
+    PointerGrab *grab = m_pointerGrab;
+    if (!grab)
+        return;
+    m_pointerGrab = 0;
+    grab->end();
+}
+
 void InputDevice::sendMouseMoveEvent(Surface *surface, const QPoint &localPos, const QPoint &globalPos)
 {
+    // The focus stays where it is while grabbed
+    if (m_pointerGrab) {
+        QPoint validGlobalPos = globalPos;
+        if (globalPos.isNull())
+            validGlobalPos = surface ? localPos + surface->pos().toPoint() : localPos;
+        sendMouseMoveEvent(localPos, validGlobalPos);
+        return;
+    }
     if (mouseFocus() != surface) {
         setMouseFocus(surface,localPos,globalPos);
     }
@@ -114,6 +281,7 @@ void InputDevice::sendMouseMoveEvent(Surface *surface, const QPoint &localPos, c
 
 void InputDevice::sendKeyPressEvent(uint code)
 {
+    flushPendingMotion();
     if (base()->keyboard_focus_resource != NULL) {
         uint32_t time = m_compositor->currentTimeMsecs();
         wl_resource_post_event(base()->keyboard_focus_resource,
@@ -123,6 +291,7 @@ void InputDevice::sendKeyPressEvent(uint code)
 
 void InputDevice::sendKeyReleaseEvent(uint code)
 {
+    flushPendingMotion();
     if (base()->keyboard_focus_resource != NULL) {
         uint32_t time = m_compositor->currentTimeMsecs();
         wl_resource_post_event(base()->keyboard_focus_resource,
@@ -132,6 +301,7 @@ void InputDevice::sendKeyReleaseEvent(uint code)
 
 void InputDevice::sendTouchPointEvent(int id, int x, int y, Qt::TouchPointState state)
 {
+    flushPendingMotion();
     uint32_t time = m_compositor->currentTimeMsecs();
     struct wl_resource *resource = base()->pointer_focus_resource;
     if (!resource)
@@ -165,6 +335,9 @@ void InputDevice::sendTouchFrameEvent()
 
 void InputDevice::sendTouchCancelEvent()
 {
+    if (TouchExtensionGlobal *ext = m_compositor->touchExtension())
+        ext->cancelTouch();
+
     struct wl_resource *resource = base()->pointer_focus_resource;
     if (resource) {
         wl_resource_post_event(resource,
@@ -174,6 +347,8 @@ void InputDevice::sendTouchCancelEvent()
 
 void InputDevice::sendFullTouchEvent(QTouchEvent *event)
 {
+    flushPendingMotion();
+
     if (!mouseFocus()) {
         qWarning("Cannot send touch event, no pointer focus, fix the compositor");
         return;
@@ -185,6 +360,7 @@ void InputDevice::sendFullTouchEvent(QTouchEvent *event)
     }
 
     TouchExtensionGlobal *ext = m_compositor->touchExtension();
+
     if (ext) {
         ext->postTouchEvent(event, mouseFocus());
         return;
@@ -212,6 +388,10 @@ Surface *InputDevice::keyboardFocus() const
 
 void InputDevice::setKeyboardFocus(Surface *surface)
 {
+    // Refocusing the same surface would only resend enter and selection
+    if (surface && surface == keyboardFocus())
+        return;
+    flushPendingMotion();
     sendSelectionFocus(surface);
     wl_input_device_set_keyboard_focus(base(), surface ? surface->base() : 0, m_compositor->currentTimeMsecs());
 }
@@ -223,6 +403,7 @@ Surface *InputDevice::mouseFocus() const
 
 void InputDevice::setMouseFocus(Surface *surface, const QPoint &globalPos, const QPoint &localPos)
 {
+    flushPendingMotion();
     wl_input_device_set_pointer_focus(base(),
                                       surface ? surface->base() : 0,
                                       m_compositor->currentTimeMsecs(),
@@ -232,23 +413,16 @@ void InputDevice::setMouseFocus(Surface *surface, const QPoint &globalPos, const
 
 void InputDevice::cleanupDataDeviceForClient(struct wl_client *client, bool destroyDev)
 {
-    for (int i = 0; i < m_data_devices.size(); i++) {
-        struct wl_resource *data_device_resource =
-                m_data_devices.at(i)->dataDeviceResource();
-        if (data_device_resource->client == client) {
-            if (destroyDev)
-                delete m_data_devices.at(i);
-            m_data_devices.removeAt(i);
-            break;
-        }
-    }
+    DataDevice *dataDevice = m_data_devices.take(client);
+    if (destroyDev)
+        delete dataDevice;
 }
 
 void InputDevice::clientRequestedDataDevice(DataDeviceManager *data_device_manager, struct wl_client *client, uint32_t id)
 {
     cleanupDataDeviceForClient(client, false);
-    DataDevice *dataDevice = new DataDevice(data_device_manager,client,id);
-    m_data_devices.append(dataDevice);
+    DataDevice *dataDevice = new DataDevice(data_device_manager,this,client,id);
+    m_data_devices.insert(client, dataDevice);
 }
 
 void InputDevice::sendSelectionFocus(Surface *surface)
@@ -302,12 +476,7 @@ uint32_t InputDevice::toWaylandButton(Qt::MouseButton button)
 
 DataDevice *InputDevice::dataDevice(struct wl_client *client) const
 {
-    for (int i = 0; i < m_data_devices.size();i++) {
-        if (m_data_devices.at(i)->dataDeviceResource()->client == client) {
-            return m_data_devices.at(i);
-        }
-    }
-    return 0;
+    return m_data_devices.value(client);
 }
 
 void InputDevice::bind_func(struct wl_client *client, void *data,
@@ -331,13 +500,14 @@ void InputDevice::input_device_attach(struct wl_client *client,
 
     struct wl_input_device *device_base = reinterpret_cast<struct wl_input_device *>(device_resource->data);
     struct wl_buffer *buffer = reinterpret_cast<struct wl_buffer *>(buffer_resource);
+    if (!device_base)
+        return;
 
     InputDevice *inputDevice = wayland_cast<InputDevice>(device_base);
     if (wl_buffer_is_shm(buffer)) {
         ShmBuffer *shmBuffer = static_cast<ShmBuffer *>(buffer->user_data);
         if (shmBuffer) {
-            inputDevice->m_compositor->waylandCompositor()->changeCursor(shmBuffer->image(), x, y);
-            currentCursor = shmBuffer;
+            inputDevice->m_compositor->waylandCompositor()->changeInputDeviceCursor(inputDevice->handle(), shmBuffer->image(), x, y);
         }
     }
 }
@@ -349,12 +519,18 @@ const struct wl_input_device_interface InputDevice::input_device_interface = {
 void InputDevice::destroy_resource(wl_resource *resource)
 {
     InputDevice *input_device = static_cast<InputDevice *>(resource->data);
+    if (!input_device) {
+        free(resource);
+        return;
+    }
     if (input_device->base()->keyboard_focus_resource == resource) {
         input_device->base()->keyboard_focus_resource = 0;
     }
     if (input_device->base()->pointer_focus_resource == resource) {
         input_device->base()->pointer_focus_resource = 0;
     }
+    if (input_device->m_pendingMotionResource == resource)
+        input_device->m_pendingMotionResource = 0;
 
     input_device->cleanupDataDeviceForClient(resource->client, true);
 
@@ -42,14 +42,17 @@
 #define WLINPUTDEVICE_H
 
 #include "waylandobject.h"
+#include "wlmotionresampler.h"
 
 #include <stdint.h>
 
+#include <QtCore/QHash>
 #include <QtCore/QList>
 #include <QtCore/QPoint>
 
 class QTouchEvent;
 class WaylandInputDevice;
+class WaylandInputRecorder;
 
 namespace Wayland {
 
@@ -58,17 +61,40 @@ class DataDevice;
 class Surface;
 class DataDeviceManager;
 
+// Takes over the pointer while active, e.g. for interactive move and
+// resize. Motion and button presses are not sent to clients then.
+class PointerGrab
+{
+public:
+    virtual ~PointerGrab() {}
+    virtual void motion(const QPoint &globalPos) = 0;
+    virtual void button(Qt::MouseButton button, bool pressed) = 0;
+    virtual void end() = 0;
+};
+
 class InputDevice : public Object<struct wl_input_device>
 {
 public:
     InputDevice(WaylandInputDevice *handle, Compositor *compositor);
     ~InputDevice();
 
+    void compositorDestroyed();
+
     void sendMousePressEvent(Qt::MouseButton button, const QPoint &localPos, const QPoint &globalPos = QPoint());
     void sendMouseReleaseEvent(Qt::MouseButton button, const QPoint &localPos, const QPoint &globalPos = QPoint());
     void sendMouseMoveEvent(const QPoint &localPos, const QPoint &globalPos = QPoint());
     void sendMouseMoveEvent(Surface *surface, const QPoint &localPos, const QPoint &globalPos = QPoint());
 
+    void startPointerGrab(PointerGrab *grab);
+    void endPointerGrab();
+    PointerGrab *pointerGrab() const { return m_pointerGrab; }
+    QPoint pointerPos() const { return m_pointerPos; }
+
+    void flushPendingMotion();
+    void resamplePendingMotion(qint64 usecs);
+    void setMotionCoalescingLatency(int msecs);
+    int motionCoalescingLatency() const;
+
     void sendKeyPressEvent(uint code);
     void sendKeyReleaseEvent(uint code);
 
@@ -88,6 +114,12 @@ public:
     DataDevice *dataDevice(struct wl_client *client) const;
     void sendSelectionFocus(Surface *surface);
 
+    void setDragDevice(DataDevice *device) { m_drag_device = device; }
+    DataDevice *dragDevice() const { return m_drag_device; }
+
+    void setRecorder(WaylandInputRecorder *recorder) { m_recorder = recorder; }
+    WaylandInputRecorder *recorder() const { return m_recorder; }
+
     Compositor *compositor() const;
     WaylandInputDevice *handle() const;
 
@@ -96,7 +128,22 @@ private:
 
     WaylandInputDevice *m_handle;
     Compositor *m_compositor;
-    QList<DataDevice *>m_data_devices;
+    struct wl_global *m_global;
+    QHash<struct wl_client *, DataDevice *> m_data_devices;
+    DataDevice *m_drag_device;
+
+    int m_motionCoalescingLatency;
+    struct wl_resource *m_pendingMotionResource;
+    uint32_t m_pendingMotionTime;
+    QPoint m_pendingMotionLocalPos;
+    QPoint m_pendingMotionGlobalPos;
+    MotionResampler m_pointerResampler;
+    bool m_pendingMotionResampled;
+
+    WaylandInputRecorder *m_recorder;
+
+    PointerGrab *m_pointerGrab;
+    QPoint m_pointerPos;
 
     uint32_t toWaylandButton(Qt::MouseButton button);
 
@@ -0,0 +1,108 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the Qt Compositor.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Nokia Corporation and its Subsidiary(-ies) nor
+**     the names of its contributors may be used to endorse or promote
+**     products derived from this software without specific prior written
+**     permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "wllatencyprobe.h"
+
+#include <QtCore/QDebug>
+
+namespace Wayland {
+
+LatencyProbe::LatencyProbe()
+    : m_enabled(!qgetenv("QT_COMPOSITOR_LATENCY_PROBE").isEmpty())
+{
+    if (m_enabled)
+        m_clock.start();
+}
+
+LatencyProbe::~LatencyProbe()
+{
+    if (m_enabled && m_inputToDisplay.count())
+        report();
+}
+
+void LatencyProbe::inputSent(Surface *surface)
+{
+    if (!m_enabled || !surface)
+        return;
+    // Only the oldest input not yet answered by a commit is of interest
+    if (!m_pending.contains(surface)) {
+        Pending pending = { now(), 0 };
+        m_pending.insert(surface, pending);
+    }
+}
+
+void LatencyProbe::committed(Surface *surface)
+{
+    if (!m_enabled)
+        return;
+    QHash<Surface *, Pending>::iterator it = m_pending.find(surface);
+    if (it == m_pending.end() || it->commit)
+        return;
+    it->commit = now();
+    m_inputToCommit.add(it->commit - it->input);
+}
+
+void LatencyProbe::displayed(Surface *surface)
+{
+    if (!m_enabled)
+        return;
+    QHash<Surface *, Pending>::iterator it = m_pending.find(surface);
+    if (it == m_pending.end() || !it->commit)
+        return;
+    m_inputToDisplay.add(now() - it->input);
+    m_pending.erase(it);
+
+    if (m_inputToDisplay.count() % 1000 == 0)
+        report();
+}
+
+void LatencyProbe::surfaceDestroyed(Surface *surface)
+{
+    if (m_enabled)
+        m_pending.remove(surface);
+}
+
+void LatencyProbe::report() const
+{
+    qDebug() << "Input to commit: " << qPrintable(m_inputToCommit.summary());
+    qDebug() << "Input to display:" << qPrintable(m_inputToDisplay.summary());
+}
+
+}
@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the Qt Compositor.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Nokia Corporation and its Subsidiary(-ies) nor
+**     the names of its contributors may be used to endorse or promote
+**     products derived from this software without specific prior written
+**     permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef WLLATENCYPROBE_H
+#define WLLATENCYPROBE_H
+
+#include "qwaylandlatencyhistogram.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+
+namespace Wayland {
+
+class Surface;
+
+// Measures, per surface, the time from the first input event sent to it
+// while it had focus until its next commit, and until that commit has
+// been displayed.
+// Enabled by setting QT_COMPOSITOR_LATENCY_PROBE, the histograms are
+// written to the debug output every 1000 frames and on exit.
+class LatencyProbe
+{
+public:
+    LatencyProbe();
+    ~LatencyProbe();
+
+    bool isEnabled() const { return m_enabled; }
+
+    void inputSent(Surface *surface);
+    void committed(Surface *surface);
+    void displayed(Surface *surface);
+    void surfaceDestroyed(Surface *surface);
+
+    void report() const;
+
+private:
+    struct Pending {
+        qint64 input;
+        qint64 commit;
+    };
+
+    qint64 now() const { return m_clock.nsecsElapsed() / 1000; }
+
+    bool m_enabled;
+    QElapsedTimer m_clock;
+    QHash<Surface *, Pending> m_pending;
+    QWaylandLatencyHistogram m_inputToCommit;
+    QWaylandLatencyHistogram m_inputToDisplay;
+};
+
+}
+
+#endif // WLLATENCYPROBE_H
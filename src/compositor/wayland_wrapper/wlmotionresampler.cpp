@@ -0,0 +1,109 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the Qt Compositor.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Nokia Corporation and its Subsidiary(-ies) nor
+**     the names of its contributors may be used to endorse or promote
+**     products derived from this software without specific prior written
+**     permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "wlmotionresampler.h"
+
+namespace Wayland {
+
+// Samples closer together than this make the velocity too noisy to
+// extrapolate from, ones further apart mean the motion has stopped.
+static const qint64 minExtrapolationInterval = 2000;
+static const qint64 maxExtrapolationInterval = 20000;
+static const qint64 maxExtrapolation = 8000;
+
+MotionResampler::MotionResampler()
+    : m_head(0)
+    , m_count(0)
+{
+}
+
+void MotionResampler::addSample(qint64 usecs, const QPointF &pos)
+{
+    m_head = (m_head + 1) % MaxSamples;
+    m_samples[m_head].time = usecs;
+    m_samples[m_head].pos = pos;
+    if (m_count < MaxSamples)
+        ++m_count;
+}
+
+qint64 MotionResampler::latestTime() const
+{
+    return m_count ? at(0).time : 0;
+}
+
+QPointF MotionResampler::latestPos() const
+{
+    return m_count ? at(0).pos : QPointF();
+}
+
+bool MotionResampler::resample(qint64 usecs, QPointF *pos) const
+{
+    if (m_count < 2)
+        return false;
+
+    const Sample &latest = at(0);
+    if (usecs >= latest.time) {
+        const Sample &previous = at(1);
+        qint64 interval = latest.time - previous.time;
+        if (interval < minExtrapolationInterval || interval > maxExtrapolationInterval)
+            return false;
+        // Never predict further than half the distance between samples
+        qint64 ahead = qMin(usecs - latest.time, qMin(maxExtrapolation, interval / 2));
+        qreal alpha = qreal(ahead) / interval;
+        *pos = latest.pos + (latest.pos - previous.pos) * alpha;
+        return true;
+    }
+
+    for (int i = 1; i < m_count; ++i) {
+        const Sample &older = at(i);
+        if (older.time <= usecs) {
+            const Sample &newer = at(i - 1);
+            qreal alpha = qreal(usecs - older.time) / (newer.time - older.time);
+            *pos = older.pos + (newer.pos - older.pos) * alpha;
+            return true;
+        }
+    }
+
+    // Older than anything kept
+    *pos = at(m_count - 1).pos;
+    return true;
+}
+
+}
@@ -0,0 +1,85 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the Qt Compositor.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Nokia Corporation and its Subsidiary(-ies) nor
+**     the names of its contributors may be used to endorse or promote
+**     products derived from this software without specific prior written
+**     permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef WLMOTIONRESAMPLER_H
+#define WLMOTIONRESAMPLER_H
+
+#include <QtCore/QPointF>
+
+namespace Wayland {
+
+// Keeps the most recent positions of a pointer or touch point and gives
+// the position at an arbitrary time, so that clients get one sample per
+// frame taken at the same distance from the frame deadline instead of
+// whatever the input device delivered last.
+class MotionResampler
+{
+public:
+    MotionResampler();
+
+    void addSample(qint64 usecs, const QPointF &pos);
+    void reset() { m_count = 0; }
+
+    bool isEmpty() const { return m_count == 0; }
+    qint64 latestTime() const;
+    QPointF latestPos() const;
+
+    // Interpolates between the samples around \a usecs, or extrapolates a
+    // little past the newest one. Returns false when there is not enough
+    // data and the newest sample should be used as is.
+    bool resample(qint64 usecs, QPointF *pos) const;
+
+private:
+    struct Sample {
+        qint64 time;
+        QPointF pos;
+    };
+    enum { MaxSamples = 8 };
+
+    const Sample &at(int i) const { return m_samples[(m_head + MaxSamples - i) % MaxSamples]; }
+
+    Sample m_samples[MaxSamples];
+    int m_head;
+    int m_count;
+};
+
+}
+
+#endif // WLMOTIONRESAMPLER_H
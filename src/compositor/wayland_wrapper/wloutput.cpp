@@ -40,18 +40,24 @@
 
 #include "wloutput.h"
 #include "wlextendedoutput.h"
-#include <QGuiApplication>
+#include "wlcompositor.h"
 #include <QtGui/QScreen>
 #include <QRect>
 
 namespace Wayland {
 
-OutputGlobal::OutputGlobal()
-    : m_displayId(-1)
+OutputGlobal::OutputGlobal(Compositor *compositor, const QRect &geometry, int refreshRate, QScreen *screen)
+    : m_compositor(compositor)
+    , m_screen(screen)
+    , m_geometry(geometry)
+    , m_refreshRate(refreshRate > 0 ? refreshRate : 60000)
+    , m_displayId(-1)
     , m_numQueued(0)
 {
-    QScreen *screen = QGuiApplication::primaryScreen();
-    m_geometry = QRect(QPoint(0, 0), screen->availableGeometry().size());
+    m_frameTimer.setSingleShot(true);
+    connect(&m_frameTimer, SIGNAL(timeout()), this, SLOT(sendFrameCallbacks()));
+
+    m_global = wl_display_add_global(compositor->wl_display(), &wl_output_interface, this, OutputGlobal::output_bind_func);
 }
 
 OutputGlobal::~OutputGlobal()
@@ -59,14 +65,75 @@ OutputGlobal::~OutputGlobal()
     qDeleteAll(m_outputs);
 }
 
+// Clients lose the output, bound ones keep their objects until they
+// destroy them. The frame clock keeps running.
+void OutputGlobal::screenRemoved()
+{
+    if (!m_global)
+        return;
+    wl_display_remove_global(m_compositor->wl_display(), m_global);
+    m_global = 0;
+
+    struct wl_resource *resource, *next;
+    wl_list_for_each_safe(resource, next, &client_resources, link) {
+        wl_list_remove(&resource->link);
+        wl_list_init(&resource->link);
+    }
+    m_screen = 0;
+    m_geometry = QRect();
+}
+
 void OutputGlobal::setGeometry(const QRect &geometry)
 {
+    if (geometry == m_geometry)
+        return;
     m_geometry = geometry;
+    sendOutputConfiguration();
+}
+
+void OutputGlobal::setRefreshRate(int refreshRate)
+{
+    if (refreshRate <= 0 || refreshRate == m_refreshRate)
+        return;
+    m_refreshRate = refreshRate;
+    sendOutputConfiguration();
+}
+
+void OutputGlobal::sendOutputConfiguration()
+{
+    // Bound outputs of clients that are gone have no resource in the list
+    struct wl_resource *resource;
+    wl_list_for_each(resource, &client_resources, link)
+        static_cast<Output *>(resource->data)->sendConfiguration();
 }
 
 Output *OutputGlobal::outputForClient(wl_client *client) const
 {
-    return static_cast<Output *>(resourceForClient(client)->data);
+    struct wl_resource *resource = resourceForClient(client);
+    return resource ? static_cast<Output *>(resource->data) : 0;
+}
+
+// Called whenever the compositor has finished a frame. The callbacks are
+// sent right away unless the last ones went out less than one refresh
+// interval ago, then they wait for the next tick of this output.
+void OutputGlobal::frameFinished()
+{
+    if (m_frameTimer.isActive())
+        return;
+
+    const qint64 interval = 1000000 / m_refreshRate;
+    const qint64 elapsed = m_lastFrame.isValid() ? m_lastFrame.elapsed() : interval;
+    if (elapsed >= interval)
+        sendFrameCallbacks();
+    else
+        m_frameTimer.start(int(interval - elapsed));
+}
+
+void OutputGlobal::sendFrameCallbacks()
+{
+    m_frameTimer.stop();
+    m_lastFrame.start();
+    m_compositor->sendFrameCallbacks(this);
 }
 
 void OutputGlobal::output_bind_func(struct wl_client *client, void *data,
@@ -88,12 +155,7 @@ Output::Output(OutputGlobal *outputGlobal, wl_client *client, uint32_t version,
 {
     Q_UNUSED(version);
     m_output_resource = wl_client_add_object(client,&wl_output_interface,0,id,this);
-    wl_resource_post_event(m_output_resource, WL_OUTPUT_GEOMETRY, 0, 0,
-                         m_output_global->size().width(), m_output_global->size().height(),0,"","");
-
-    wl_resource_post_event(m_output_resource,WL_OUTPUT_MODE, WL_OUTPUT_MODE_CURRENT|WL_OUTPUT_MODE_PREFERRED,
-                           m_output_global->size().width(),m_output_global->size().height());
-
+    sendConfiguration();
 }
 
 Output::~Output()
@@ -101,6 +163,21 @@ Output::~Output()
     delete m_extended_output;
 }
 
+void Output::sendConfiguration()
+{
+    const QRect geometry = m_output_global->geometry();
+    wl_resource_post_event(m_output_resource, WL_OUTPUT_GEOMETRY, geometry.x(), geometry.y(),
+                         geometry.width(), geometry.height(),0,"","");
+
+    wl_resource_post_event(m_output_resource,WL_OUTPUT_MODE, WL_OUTPUT_MODE_CURRENT|WL_OUTPUT_MODE_PREFERRED,
+                           geometry.width(),geometry.height(),m_output_global->refreshRate());
+}
+
+OutputGlobal *Output::outputGlobal() const
+{
+    return m_output_global;
+}
+
 ExtendedOutput *Output::extendedOutput() const
 {
     return m_extended_output;
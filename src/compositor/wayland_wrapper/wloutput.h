@@ -43,18 +43,28 @@
 
 #include "waylandresourcecollection.h"
 
+#include <QtCore/QObject>
 #include <QtCore/QRect>
 #include <QtCore/QList>
+#include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
+
+class QScreen;
 
 namespace Wayland {
 
+class Compositor;
 class Output;
 class ExtendedOutput;
 
-class OutputGlobal : public ResourceCollection
+// One wl_output global. Besides the geometry and mode sent to clients, it
+// runs the frame clock of the output: the frame callbacks of the surfaces
+// shown mainly on this output go out at most once per refresh interval.
+class OutputGlobal : public QObject, public ResourceCollection
 {
+    Q_OBJECT
 public:
-    OutputGlobal();
+    OutputGlobal(Compositor *compositor, const QRect &geometry, int refreshRate, QScreen *screen = 0);
     ~OutputGlobal();
 
     void setGeometry(const QRect &geometry);
@@ -64,15 +74,38 @@ public:
     int y() const { return m_geometry.y(); }
     QSize size() const { return m_geometry.size(); }
 
+    // In mHz, like the refresh of wl_output.mode
+    void setRefreshRate(int refreshRate);
+    int refreshRate() const { return m_refreshRate; }
+
+    QScreen *screen() const { return m_screen; }
+    void screenRemoved();
+
     Output *outputForClient(struct wl_client *client) const;
+    QList<Output *> outputs() const { return m_outputs; }
+
+    void frameFinished();
 
     static void output_bind_func(struct wl_client *client, void *data,
                           uint32_t version, uint32_t id);
+
+private slots:
+    void sendFrameCallbacks();
+
 private:
+    Compositor *m_compositor;
+    struct wl_global *m_global;
+    QScreen *m_screen;
     QRect m_geometry;
+    int m_refreshRate;
     int m_displayId;
     int m_numQueued;
     QList<Output *> m_outputs;
+
+    QTimer m_frameTimer;
+    QElapsedTimer m_lastFrame;
+
+    void sendOutputConfiguration();
 };
 
 
@@ -87,6 +120,8 @@ public:
     ExtendedOutput *extendedOutput() const;
     void setExtendedOutput(ExtendedOutput *extendedOutput);
 
+    void sendConfiguration();
+
     struct wl_resource *handle() const;
 private:
     struct wl_resource *m_output_resource;
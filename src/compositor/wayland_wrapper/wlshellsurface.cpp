@@ -75,22 +75,117 @@ const struct wl_shell_interface Shell::shell_interface = {
 };
 
 ShellSurface::ShellSurface(wl_client *client, uint32_t id, Surface *surface)
+    : m_surface(surface)
+    , m_grabDevice(0)
+    , m_grabMode(NoGrab)
+    , m_resizeEdges(0)
+    , m_configurePending(false)
 {
     m_shellSurface = wl_client_add_object(client,&wl_shell_surface_interface,&shell_surface_interface,id,this);
     surface->setShellSurface(this);
+}
+
+ShellSurface::~ShellSurface()
+{
+    if (m_grabDevice)
+        m_grabDevice->endPointerGrab();
+}
+
+void ShellSurface::startGrab(InputDevice *inputDevice, GrabMode mode, uint32_t edges)
+{
+    // Only the client having the pointer can start a grab, and only on
+    // its own surface, typically in response to a button press
+    if (inputDevice->mouseFocus() != m_surface)
+        return;
+
+    inputDevice->startPointerGrab(this);
+    m_grabDevice = inputDevice;
+    m_grabMode = mode;
+    m_resizeEdges = edges;
+    m_grabPointerPos = inputDevice->pointerPos();
+    m_grabSurfacePos = m_surface->pos();
+    m_grabSurfaceSize = m_surface->size();
+    m_pendingSize = m_sentSize = m_grabSurfaceSize;
+}
 
+void ShellSurface::motion(const QPoint &globalPos)
+{
+    const QPoint delta = globalPos - m_grabPointerPos;
+
+    if (m_grabMode == MoveGrab) {
+        // Position changes are picked up by the next compositor frame,
+        // the client is not involved at all
+        m_surface->setPos(m_grabSurfacePos + delta);
+    } else if (m_grabMode == ResizeGrab) {
+        int width = m_grabSurfaceSize.width();
+        int height = m_grabSurfaceSize.height();
+        if (m_resizeEdges & WL_SHELL_SURFACE_RESIZE_LEFT)
+            width -= delta.x();
+        else if (m_resizeEdges & WL_SHELL_SURFACE_RESIZE_RIGHT)
+            width += delta.x();
+        if (m_resizeEdges & WL_SHELL_SURFACE_RESIZE_TOP)
+            height -= delta.y();
+        else if (m_resizeEdges & WL_SHELL_SURFACE_RESIZE_BOTTOM)
+            height += delta.y();
+        m_pendingSize = QSize(qMax(width, 1), qMax(height, 1));
+
+        // At most one configure in flight, the next one is sent when
+        // the client has committed a frame for the previous one
+        if (!m_configurePending && m_pendingSize != m_sentSize)
+            sendConfigure(m_pendingSize);
+    }
+}
+
+void ShellSurface::button(Qt::MouseButton button, bool pressed)
+{
+    Q_UNUSED(button);
+    if (!pressed && m_grabDevice)
+        m_grabDevice->endPointerGrab();
 }
 
+void ShellSurface::end()
+{
+    m_grabDevice = 0;
+    m_grabMode = NoGrab;
+}
+
+void ShellSurface::sendConfigure(const QSize &size)
+{
+    wl_resource_post_event(m_shellSurface, WL_SHELL_SURFACE_CONFIGURE,
+                           m_surface->compositor()->currentTimeMsecs(),
+                           m_resizeEdges, size.width(), size.height());
+    m_sentSize = size;
+    m_configurePending = true;
+}
+
+void ShellSurface::frameCommitted()
+{
+    if (!m_configurePending)
+        return;
+    m_configurePending = false;
+
+    // Keep the edges opposite to the dragged ones in place
+    QPointF pos = m_surface->pos();
+    if (m_resizeEdges & WL_SHELL_SURFACE_RESIZE_LEFT)
+        pos.setX(m_grabSurfacePos.x() + m_grabSurfaceSize.width() - m_surface->size().width());
+    if (m_resizeEdges & WL_SHELL_SURFACE_RESIZE_TOP)
+        pos.setY(m_grabSurfacePos.y() + m_grabSurfaceSize.height() - m_surface->size().height());
+    m_surface->setPos(pos);
+
+    if (m_pendingSize != m_sentSize)
+        sendConfigure(m_pendingSize);
+}
 
 void ShellSurface::move(struct wl_client *client,
                 struct wl_resource *shell_surface_resource,
-                struct wl_resource *input_device,
+                struct wl_resource *input_device_super,
                 uint32_t time)
 {
     Q_UNUSED(client);
-    Q_UNUSED(shell_surface_resource);
-    Q_UNUSED(input_device);
     Q_UNUSED(time);
+    ShellSurface *shell_surface = static_cast<ShellSurface *>(shell_surface_resource->data);
+    InputDevice *input_device = static_cast<InputDevice *>(input_device_super->data);
+    shell_surface->startGrab(input_device, MoveGrab, 0);
 }
 
 void ShellSurface::resize(struct wl_client *client,
@@ -99,15 +194,11 @@ void ShellSurface::resize(struct wl_client *client,
                   uint32_t time,
                   uint32_t edges)
 {
-    Q_UNUSED(shell_surface_resource);
     Q_UNUSED(client);
     Q_UNUSED(time);
-    Q_UNUSED(edges);
     ShellSurface *shell_surface = static_cast<ShellSurface *>(shell_surface_resource->data);
-    Q_UNUSED(shell_surface);
     InputDevice *input_device = static_cast<InputDevice *>(input_device_super->data);
-    Q_UNUSED(input_device);
-
+    shell_surface->startGrab(input_device, ResizeGrab, edges);
 }
 
 void ShellSurface::set_toplevel(struct wl_client *client,
@@ -41,8 +41,13 @@
 #ifndef WLSHELLSURFACE_H
 #define WLSHELLSURFACE_H
 
+#include "wlinputdevice.h"
+
 #include <wayland-server.h>
 
+#include <QtCore/QPointF>
+#include <QtCore/QSize>
+
 namespace Wayland {
 
 class Compositor;
@@ -64,15 +69,41 @@ private:
 
 };
 
-class ShellSurface
+class ShellSurface : public PointerGrab
 {
 public:
     ShellSurface(struct wl_client *client, uint32_t id, Surface *surface);
+    ~ShellSurface();
+
+    void frameCommitted();
+
+    void motion(const QPoint &globalPos);
+    void button(Qt::MouseButton button, bool pressed);
+    void end();
 
 private:
+    enum GrabMode {
+        NoGrab,
+        MoveGrab,
+        ResizeGrab
+    };
+
+    void startGrab(InputDevice *inputDevice, GrabMode mode, uint32_t edges);
+    void sendConfigure(const QSize &size);
+
     struct wl_resource *m_shellSurface;
     Surface *m_surface;
 
+    InputDevice *m_grabDevice;
+    GrabMode m_grabMode;
+    uint32_t m_resizeEdges;
+    QPoint m_grabPointerPos;
+    QPointF m_grabSurfacePos;
+    QSize m_grabSurfaceSize;
+    QSize m_pendingSize;
+    QSize m_sentSize;
+    bool m_configurePending;
+
     static void move(struct wl_client *client,
                      struct wl_resource *shell_surface_resource,
                      struct wl_resource *input_device_super,
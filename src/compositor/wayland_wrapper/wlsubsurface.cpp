@@ -73,6 +73,8 @@ const struct wl_sub_surface_extension_interface SubSurfaceExtensionGlobal::sub_s
 SubSurface::SubSurface(wl_client *client, uint32_t id, Surface *surface)
     : m_surface(surface)
     , m_parent(0)
+    , m_treeOffsetValid(false)
+    , m_renderListValid(false)
 {
     surface->setSubSurface(this);
     m_sub_surface_resource = wl_client_add_object(client,
@@ -84,23 +86,57 @@ SubSurface::SubSurface(wl_client *client, uint32_t id, Surface *surface)
 
 SubSurface::~SubSurface()
 {
+    // The children become top level surfaces again
+    while (!m_sub_surfaces.isEmpty())
+        m_sub_surfaces.last()->handle()->subSurface()->setParent(0);
+
+    // The surface itself is going away, it must not be indexed again
     if (m_parent) {
+        WaylandSurface *oldParent = m_parent->waylandSurface();
         m_parent->removeSubSurface(this);
+        m_parent = 0;
+        m_surface->waylandSurface()->parentChanged(0, oldParent);
     }
 }
 
 void SubSurface::setSubSurface(SubSurface *subSurface, int x, int y)
 {
-    Q_ASSERT(!m_sub_surfaces.contains(subSurface->m_surface->waylandSurface()));
-    m_sub_surfaces.append(subSurface->m_surface->waylandSurface());
+    if (subSurface == this)
+        return;
     subSurface->setParent(this);
     subSurface->m_surface->setPos(QPointF(x,y));
 }
 
 void SubSurface::removeSubSurface(SubSurface *subSurfaces)
 {
-    Q_ASSERT(m_sub_surfaces.contains(subSurfaces->m_surface->waylandSurface()));
-    m_sub_surfaces.removeOne(subSurfaces->m_surface->waylandSurface());
+    Q_ASSERT(m_sub_surfaces.contains(subSurfaces->waylandSurface()));
+    m_sub_surfaces.removeOne(subSurfaces->waylandSurface());
+    treeChanged();
+}
+
+void SubSurface::moveSubSurface(SubSurface *subSurface, int x, int y)
+{
+    if (subSurface->m_parent != this)
+        return;
+    subSurface->m_surface->setPos(QPointF(x,y));
+}
+
+void SubSurface::raiseSubSurface(SubSurface *subSurface)
+{
+    if (subSurface->m_parent != this || m_sub_surfaces.last() == subSurface->waylandSurface())
+        return;
+    m_sub_surfaces.removeOne(subSurface->waylandSurface());
+    m_sub_surfaces.append(subSurface->waylandSurface());
+    treeChanged();
+}
+
+void SubSurface::lowerSubSurface(SubSurface *subSurface)
+{
+    if (subSurface->m_parent != this || m_sub_surfaces.first() == subSurface->waylandSurface())
+        return;
+    m_sub_surfaces.removeOne(subSurface->waylandSurface());
+    m_sub_surfaces.prepend(subSurface->waylandSurface());
+    treeChanged();
 }
 
 SubSurface *SubSurface::parent() const
@@ -113,24 +149,93 @@ void SubSurface::setParent(SubSurface *parent)
     if (m_parent == parent)
         return;
 
+    // A surface can not become a child of its own descendant
+    for (SubSurface *ancestor = parent; ancestor; ancestor = ancestor->m_parent) {
+        if (ancestor == this)
+            return;
+    }
+
     WaylandSurface *oldParent = 0;
     WaylandSurface *newParent = 0;
 
     if (m_parent) {
-        oldParent = m_parent->m_surface->waylandSurface();
+        oldParent = m_parent->waylandSurface();
         m_parent->removeSubSurface(this);
     }
+    m_parent = parent;
     if (parent) {
-        newParent = parent->m_surface->waylandSurface();
+        newParent = parent->waylandSurface();
+        parent->m_sub_surfaces.append(waylandSurface());
+        parent->treeChanged();
     }
-    m_parent = parent;
+    m_surface->parentChanged();
+    invalidateTreeOffset();
+    if (!parent)
+        m_surface->compositor()->updateSurfaceOutputs(m_surface);
 
     m_surface->waylandSurface()->parentChanged(newParent,oldParent);
 }
 
-QLinkedList<WaylandSurface *> SubSurface::subSurfaces() const
+QPointF SubSurface::treeOffset() const
 {
-    return m_sub_surfaces;
+    if (!m_treeOffsetValid) {
+        m_treeOffset = m_parent ? m_parent->treeOffset() + m_surface->pos() : QPointF();
+        m_treeOffsetValid = true;
+    }
+    return m_treeOffset;
+}
+
+// Called by the surface whenever its position changes
+void SubSurface::positionChanged()
+{
+    if (!m_parent)
+        return;
+    invalidateTreeOffset();
+    m_parent->invalidateRenderList();
+}
+
+void SubSurface::invalidateTreeOffset()
+{
+    // Offsets are computed top down, nothing below is valid either
+    if (!m_treeOffsetValid)
+        return;
+    m_treeOffsetValid = false;
+    for (int i = 0; i < m_sub_surfaces.size(); ++i)
+        m_sub_surfaces.at(i)->handle()->subSurface()->invalidateTreeOffset();
+}
+
+void SubSurface::invalidateRenderList()
+{
+    for (SubSurface *surface = this; surface; surface = surface->m_parent)
+        surface->m_renderListValid = false;
+}
+
+void SubSurface::treeChanged()
+{
+    invalidateRenderList();
+    m_surface->compositor()->surfaceIndex()->invalidate(m_surface);
+    emit waylandSurface()->subSurfacesChanged();
+}
+
+// This surface first, then each child with its own children, bottom first
+const QList<WaylandSurface::RenderItem> &SubSurface::renderList() const
+{
+    if (!m_renderListValid) {
+        m_renderList.clear();
+        appendToRenderList(&m_renderList, treeOffset());
+        m_renderListValid = true;
+    }
+    return m_renderList;
+}
+
+void SubSurface::appendToRenderList(QList<WaylandSurface::RenderItem> *list, const QPointF &origin) const
+{
+    WaylandSurface::RenderItem item;
+    item.surface = waylandSurface();
+    item.pos = treeOffset() - origin;
+    list->append(item);
+    for (int i = 0; i < m_sub_surfaces.size(); ++i)
+        m_sub_surfaces.at(i)->handle()->subSurface()->appendToRenderList(list, origin);
 }
 
 void SubSurface::attach_sub_surface(wl_client *client, wl_resource *sub_surface_parent_resource, wl_resource *sub_surface_child_resource, int32_t x, int32_t y)
@@ -144,26 +249,25 @@ void SubSurface::attach_sub_surface(wl_client *client, wl_resource *sub_surface_
 void SubSurface::move_sub_surface(wl_client *client, wl_resource *sub_surface_parent_resource, wl_resource *sub_surface_child_resource, int32_t x, int32_t y)
 {
     Q_UNUSED(client);
-    Q_UNUSED(x);
-    Q_UNUSED(y);
     SubSurface *parent_sub_surface = static_cast<SubSurface *>(sub_surface_parent_resource->data);
     SubSurface *child_sub_surface = static_cast<SubSurface *>(sub_surface_child_resource->data);
-    Q_UNUSED(parent_sub_surface);
-    Q_UNUSED(child_sub_surface);
+    parent_sub_surface->moveSubSurface(child_sub_surface,x,y);
 }
 
 void SubSurface::raise(wl_client *client, wl_resource *sub_surface_parent_resource, wl_resource *sub_surface_child_resource)
 {
     Q_UNUSED(client);
-    Q_UNUSED(sub_surface_parent_resource);
-    Q_UNUSED(sub_surface_child_resource);
+    SubSurface *parent_sub_surface = static_cast<SubSurface *>(sub_surface_parent_resource->data);
+    SubSurface *child_sub_surface = static_cast<SubSurface *>(sub_surface_child_resource->data);
+    parent_sub_surface->raiseSubSurface(child_sub_surface);
 }
 
 void SubSurface::lower(wl_client *client, wl_resource *sub_surface_parent_resource, wl_resource *sub_surface_child_resource)
 {
     Q_UNUSED(client);
-    Q_UNUSED(sub_surface_parent_resource);
-    Q_UNUSED(sub_surface_child_resource);
+    SubSurface *parent_sub_surface = static_cast<SubSurface *>(sub_surface_parent_resource->data);
+    SubSurface *child_sub_surface = static_cast<SubSurface *>(sub_surface_child_resource->data);
+    parent_sub_surface->lowerSubSurface(child_sub_surface);
 }
 
 const struct wl_sub_surface_interface SubSurface::sub_surface_interface = {
@@ -45,7 +45,8 @@
 
 #include "wayland-sub-surface-extension-server-protocol.h"
 
-#include <QtCore/QLinkedList>
+#include <QtCore/QList>
+#include <QtCore/QPointF>
 
 class Compositor;
 class WaylandSurface;
@@ -78,11 +79,22 @@ public:
 
     void setSubSurface(SubSurface *subSurface, int x, int y);
     void removeSubSurface(SubSurface *subSurfaces);
+    void moveSubSurface(SubSurface *subSurface, int x, int y);
+    void raiseSubSurface(SubSurface *subSurface);
+    void lowerSubSurface(SubSurface *subSurface);
 
     SubSurface *parent() const;
     void setParent(SubSurface *parent);
 
-    QLinkedList<WaylandSurface *> subSurfaces() const;
+    // Bottom first, all of them stacked above this surface
+    const QList<WaylandSurface *> &subSurfaces() const { return m_sub_surfaces; }
+
+    // Position relative to the top of the tree, cached until a surface on
+    // the path to the top is moved or reparented
+    QPointF treeOffset() const;
+    void positionChanged();
+
+    const QList<WaylandSurface::RenderItem> &renderList() const;
 
     Surface *surface() const;
     WaylandSurface *waylandSurface() const;
@@ -92,7 +104,17 @@ private:
     Surface *m_surface;
 
     SubSurface *m_parent;
-    QLinkedList<WaylandSurface *> m_sub_surfaces;
+    QList<WaylandSurface *> m_sub_surfaces;
+
+    mutable QPointF m_treeOffset;
+    mutable bool m_treeOffsetValid;
+    mutable QList<WaylandSurface::RenderItem> m_renderList;
+    mutable bool m_renderListValid;
+
+    void invalidateTreeOffset();
+    void invalidateRenderList();
+    void appendToRenderList(QList<WaylandSurface::RenderItem> *list, const QPointF &origin) const;
+    void treeChanged();
 
     static void attach_sub_surface(struct wl_client *client,
                                    struct wl_resource *sub_surface_parent_resource,
@@ -83,6 +83,8 @@ Surface::Surface(struct wl_client *client, uint32_t id, Compositor *compositor)
     , m_extendedSurface(0)
     , m_subSurface(0)
     , m_shellSurface(0)
+    , m_primaryOutput(0)
+    , m_hasInputRegion(false)
 {
     wl_list_init(&m_frame_callback_list);
     addClientResource(client, &base()->resource, id, &wl_surface_interface,
@@ -94,9 +96,10 @@ Surface::Surface(struct wl_client *client, uint32_t id, Compositor *compositor)
 
 Surface::~Surface()
 {
+    // Tells the rest of the tree, which still uses the WaylandSurface
+    delete m_subSurface;
     delete m_waylandSurface;
     delete m_extendedSurface;
-    delete m_subSurface;
     delete m_shellSurface;
 
     for (int i = 0; i < buffer_pool_size; i++) {
@@ -153,8 +156,13 @@ void Surface::setPos(const QPointF &pos)
 {
     bool emitChange = pos != m_position;
     m_position = pos;
-    if (emitChange)
+    if (emitChange) {
+        if (m_subSurface)
+            m_subSurface->positionChanged();
+        m_compositor->surfaceIndex()->invalidate(this);
+        m_compositor->updateSurfaceOutputs(this);
         m_waylandSurface->posChanged();
+    }
 }
 
 QSize Surface::size() const
@@ -166,8 +174,47 @@ void Surface::setSize(const QSize &size)
 {
     bool emitChange = size != m_size;
     m_size = size;
-    if (emitChange)
+    if (emitChange) {
+        m_compositor->surfaceIndex()->invalidate(this);
+        m_compositor->updateSurfaceOutputs(this);
         m_waylandSurface->sizeChanged();
+    }
+}
+
+OutputGlobal *Surface::primaryOutput() const
+{
+    if (m_subSurface && m_subSurface->parent()) {
+        SubSurface *window = m_subSurface->parent();
+        while (window->parent())
+            window = window->parent();
+        return window->surface()->m_primaryOutput;
+    }
+    return m_primaryOutput;
+}
+
+void Surface::setOutputs(const QList<OutputGlobal *> &outputs, OutputGlobal *primaryOutput)
+{
+    m_outputs = outputs;
+    m_primaryOutput = primaryOutput;
+}
+
+QRegion Surface::inputRegion() const
+{
+    if (m_hasInputRegion)
+        return m_inputRegion;
+    return QRegion(QRect(QPoint(), m_size));
+}
+
+void Surface::setInputRegion(const QRegion &region)
+{
+    m_hasInputRegion = true;
+    m_inputRegion = region;
+}
+
+void Surface::resetInputRegion()
+{
+    m_hasInputRegion = false;
+    m_inputRegion = QRegion();
 }
 
 QImage Surface::image() const
@@ -248,6 +295,21 @@ void Surface::setSubSurface(SubSurface *subSurface)
     m_subSurface = subSurface;
 }
 
+// Sub surfaces are picked through their parent, a surface that becomes
+// top level again is indexed, and mapped if it already has content
+void Surface::parentChanged()
+{
+    if (m_subSurface && m_subSurface->parent()) {
+        m_compositor->surfaceIndex()->remove(this);
+    } else if (m_surfaceMapped) {
+        m_compositor->surfaceIndex()->insert(this);
+    } else if (m_backBuffer && m_backBuffer->waylandBufferHandle()) {
+        m_surfaceMapped = true;
+        m_compositor->surfaceIndex()->insert(this);
+        emit m_waylandSurface->mapped();
+    }
+}
+
 SubSurface *Surface::subSurface() const
 {
     return m_subSurface;
@@ -300,9 +362,11 @@ bool Surface::advanceBufferQueue()
 
         if (m_backBuffer &&  (!m_subSurface || !m_subSurface->parent()) && !m_surfaceMapped) {
             m_surfaceMapped = true;
+            m_compositor->surfaceIndex()->insert(this);
             emit m_waylandSurface->mapped();
         } else if (m_backBuffer && !m_backBuffer->waylandBufferHandle() && m_surfaceMapped) {
             m_surfaceMapped = false;
+            m_compositor->surfaceIndex()->remove(this);
             emit m_waylandSurface->unmapped();
         }
 
@@ -378,21 +442,37 @@ void Surface::attach(struct wl_buffer *buffer)
     m_bufferQueue <<  createSurfaceBuffer(buffer);
 }
 
+// Shows a buffer the client handed over some other way, e.g. the drag
+// icon, as if the client had attached and damaged it
+void Surface::attachBuffer(struct wl_buffer *buffer)
+{
+    attach(buffer);
+    damage(QRect(0, 0, buffer->width, buffer->height));
+}
+
 void Surface::damage(const QRect &rect)
 {
+    // Only the first damage of a buffer commits a new frame
+    bool newFrame = false;
     if (m_bufferQueue.size()) {
         SurfaceBuffer *surfaceBuffer = m_bufferQueue.last();
-        if (surfaceBuffer)
+        if (surfaceBuffer) {
+            newFrame = !surfaceBuffer->damageRect().isValid();
             surfaceBuffer->setDamage(rect);
-        else
+        } else {
             qWarning() << "Surface::damage() null buffer";
+        }
         if (!m_backBuffer)
             advanceBufferQueue();
     } else {
         // we've receicved a second damage for the same buffer
         currentSurfaceBuffer()->setDamage(rect);
     }
+    if (newFrame)
+        m_compositor->latencyProbe()->committed(this);
     doUpdate();
+    if (m_shellSurface)
+        m_shellSurface->frameCommitted();
 }
 
 const struct wl_surface_interface Surface::surface_interface = {
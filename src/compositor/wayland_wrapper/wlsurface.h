@@ -51,6 +51,7 @@
 
 #include <QtCore/QRect>
 #include <QtGui/QImage>
+#include <QtGui/QRegion>
 
 #include <QtCore/QTextStream>
 #include <QtCore/QMetaType>
@@ -71,6 +72,7 @@ class Buffer;
 class ExtendedSurface;
 class SubSurface;
 class ShellSurface;
+class OutputGlobal;
 
 class Q_COMPOSITOR_EXPORT Surface : public Object<struct wl_surface>
 {
@@ -91,14 +93,27 @@ public:
     QSize size() const;
     void setSize(const QSize &size);
 
+    // The outputs a top level surface intersects, kept up to date by the
+    // compositor. Sub surfaces report the primary output of their window.
+    QList<OutputGlobal *> outputs() const { return m_outputs; }
+    OutputGlobal *primaryOutput() const;
+    void setOutputs(const QList<OutputGlobal *> &outputs, OutputGlobal *primaryOutput);
+
     QImage image() const;
 
+    bool hasInputRegion() const { return m_hasInputRegion; }
+    QRegion inputRegion() const;
+    void setInputRegion(const QRegion &region);
+    void resetInputRegion();
+
 #ifdef QT_COMPOSITOR_WAYLAND_GL
     GLuint textureId(QOpenGLContext *context) const;
 #endif
 
     void sendFrameCallback();
 
+    void attachBuffer(struct wl_buffer *buffer);
+
     void frameFinished();
 
     WaylandSurface *waylandSurface() const;
@@ -110,6 +125,7 @@ public:
 
     void setSubSurface(SubSurface *subSurface);
     SubSurface *subSurface() const;
+    void parentChanged();
 
     void setShellSurface(ShellSurface *shellSurface);
     ShellSurface *shellSurface() const;
@@ -144,6 +160,12 @@ private:
     QPointF m_position;
     QSize m_size;
 
+    QList<OutputGlobal *> m_outputs;
+    OutputGlobal *m_primaryOutput;
+
+    bool m_hasInputRegion;
+    QRegion m_inputRegion;
+
     inline SurfaceBuffer *currentSurfaceBuffer() const;
     bool advanceBufferQueue();
     void doUpdate();
@@ -0,0 +1,226 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the Qt Compositor.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Nokia Corporation and its Subsidiary(-ies) nor
+**     the names of its contributors may be used to endorse or promote
+**     products derived from this software without specific prior written
+**     permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "wlsurfaceindex.h"
+
+#include "wlsurface.h"
+#include "wlsubsurface.h"
+
+#include <QtCore/QMap>
+
+#include <math.h>
+
+namespace Wayland {
+
+static const int cellSize = 128;
+
+SurfaceIndex::SurfaceIndex()
+    : m_alphaTest(false)
+{
+}
+
+void SurfaceIndex::insert(Surface *surface)
+{
+    if (m_stack.contains(surface))
+        return;
+    m_stackPositions.insert(surface, m_stack.size());
+    m_stack.append(surface);
+    m_dirtySurfaces.insert(surface);
+}
+
+void SurfaceIndex::remove(Surface *surface)
+{
+    if (!m_stack.removeOne(surface))
+        return;
+    setCells(surface, QRect());
+    m_surfaceCells.remove(surface);
+    m_dirtySurfaces.remove(surface);
+    updateStackPositions();
+}
+
+void SurfaceIndex::raise(Surface *surface)
+{
+    if (m_stack.removeOne(surface)) {
+        m_stack.append(surface);
+        updateStackPositions();
+    }
+}
+
+void SurfaceIndex::lower(Surface *surface)
+{
+    if (m_stack.removeOne(surface)) {
+        m_stack.prepend(surface);
+        updateStackPositions();
+    }
+}
+
+void SurfaceIndex::invalidate(Surface *surface)
+{
+    // Sub surfaces are covered by the cells of their top level surface
+    while (SubSurface *subSurface = surface->subSurface()) {
+        if (!subSurface->parent())
+            break;
+        surface = subSurface->parent()->surface();
+    }
+    if (m_stackPositions.contains(surface))
+        m_dirtySurfaces.insert(surface);
+}
+
+void SurfaceIndex::updateStackPositions()
+{
+    m_stackPositions.clear();
+    for (int i = 0; i < m_stack.size(); ++i)
+        m_stackPositions.insert(m_stack.at(i), i);
+}
+
+QRectF SurfaceIndex::treeBounds(Surface *surface)
+{
+    QRectF bounds(surface->pos(), surface->size());
+    if (SubSurface *subSurface = surface->subSurface()) {
+        const QList<WaylandSurface *> &children = subSurface->subSurfaces();
+        for (int i = 0; i < children.size(); ++i)
+            bounds |= treeBounds(children.at(i)->handle()).translated(surface->pos());
+    }
+    return bounds;
+}
+
+void SurfaceIndex::updateCells(Surface *surface)
+{
+    const QRectF bounds = treeBounds(surface);
+    QRect cells;
+    if (!bounds.isEmpty()) {
+        cells.setCoords(int(floor(bounds.left() / cellSize)),
+                        int(floor(bounds.top() / cellSize)),
+                        int(floor((bounds.right() - 1) / cellSize)),
+                        int(floor((bounds.bottom() - 1) / cellSize)));
+    }
+    setCells(surface, cells);
+}
+
+// Moves the surface from the cells it covered to the given ones
+void SurfaceIndex::setCells(Surface *surface, const QRect &cells)
+{
+    const QRect oldCells = m_surfaceCells.value(surface);
+    if (cells == oldCells)
+        return;
+
+    for (int y = oldCells.top(); y <= oldCells.bottom(); ++y) {
+        for (int x = oldCells.left(); x <= oldCells.right(); ++x) {
+            if (cells.contains(x, y))
+                continue;
+            QHash<qint64, QVector<Surface *> >::iterator it = m_cells.find(cellKey(x, y));
+            if (it == m_cells.end())
+                continue;
+            it.value().remove(it.value().indexOf(surface));
+            if (it.value().isEmpty())
+                m_cells.erase(it);
+        }
+    }
+    for (int y = cells.top(); y <= cells.bottom(); ++y) {
+        for (int x = cells.left(); x <= cells.right(); ++x) {
+            if (!oldCells.contains(x, y))
+                m_cells[cellKey(x, y)].append(surface);
+        }
+    }
+    m_surfaceCells.insert(surface, cells);
+}
+
+bool SurfaceIndex::acceptsInput(Surface *surface, const QPointF &local) const
+{
+    const QPoint p = local.toPoint();
+    if (!QRect(QPoint(), surface->size()).contains(p))
+        return false;
+    if (surface->hasInputRegion() && !surface->inputRegion().contains(p))
+        return false;
+    if (m_alphaTest && surface->type() == WaylandSurface::Shm) {
+        const QImage image = surface->image();
+        if (image.hasAlphaChannel() && image.rect().contains(p) && qAlpha(image.pixel(p)) == 0)
+            return false;
+    }
+    return true;
+}
+
+// pos is in the coordinate system of the surface's parent
+Surface *SurfaceIndex::pick(Surface *surface, const QPointF &pos, QPointF *local) const
+{
+    const QPointF surfacePos = pos - surface->pos();
+
+    // Sub surfaces are stacked above their parent, last one on top
+    if (SubSurface *subSurface = surface->subSurface()) {
+        const QList<WaylandSurface *> &children = subSurface->subSurfaces();
+        for (int i = children.size() - 1; i >= 0; --i) {
+            if (Surface *hit = pick(children.at(i)->handle(), surfacePos, local))
+                return hit;
+        }
+    }
+
+    if (acceptsInput(surface, surfacePos)) {
+        if (local)
+            *local = surfacePos;
+        return surface;
+    }
+    return 0;
+}
+
+Surface *SurfaceIndex::surfaceAt(const QPointF &pos, QPointF *local)
+{
+    if (!m_dirtySurfaces.isEmpty()) {
+        foreach (Surface *surface, m_dirtySurfaces)
+            updateCells(surface);
+        m_dirtySurfaces.clear();
+    }
+
+    const QVector<Surface *> candidates = m_cells.value(cellKey(int(floor(pos.x() / cellSize)),
+                                                               int(floor(pos.y() / cellSize))));
+
+    // Top most first
+    QMap<int, Surface *> stacked;
+    for (int i = 0; i < candidates.size(); ++i)
+        stacked.insert(m_stackPositions.value(candidates.at(i)), candidates.at(i));
+    QMap<int, Surface *>::const_iterator it = stacked.constEnd();
+    while (it != stacked.constBegin()) {
+        --it;
+        if (Surface *hit = pick(it.value(), pos, local))
+            return hit;
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,101 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the Qt Compositor.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Nokia Corporation and its Subsidiary(-ies) nor
+**     the names of its contributors may be used to endorse or promote
+**     products derived from this software without specific prior written
+**     permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef WLSURFACEINDEX_H
+#define WLSURFACEINDEX_H
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QPointF>
+#include <QtCore/QRect>
+#include <QtCore/QRectF>
+#include <QtCore/QSet>
+#include <QtCore/QVector>
+
+namespace Wayland {
+
+class Surface;
+
+// Keeps the mapped top level surfaces in stacking order, bottom first,
+// together with a grid of the screen areas covered by each surface tree.
+// Picking only has to look at the surfaces sharing the grid cell of the
+// point, instead of every surface.
+class SurfaceIndex
+{
+public:
+    SurfaceIndex();
+
+    void insert(Surface *surface);
+    void remove(Surface *surface);
+    void raise(Surface *surface);
+    void lower(Surface *surface);
+
+    QList<Surface *> stackingOrder() const { return m_stack; }
+
+    // Marks the cells of the tree containing surface out of date, they are
+    // updated on the next lookup
+    void invalidate(Surface *surface);
+
+    void setAlphaTestEnabled(bool enabled) { m_alphaTest = enabled; }
+    bool alphaTestEnabled() const { return m_alphaTest; }
+
+    Surface *surfaceAt(const QPointF &pos, QPointF *local = 0);
+
+private:
+    void updateCells(Surface *surface);
+    void setCells(Surface *surface, const QRect &cells);
+    void updateStackPositions();
+    Surface *pick(Surface *surface, const QPointF &pos, QPointF *local) const;
+    bool acceptsInput(Surface *surface, const QPointF &local) const;
+
+    static QRectF treeBounds(Surface *surface);
+    static inline qint64 cellKey(int x, int y) { return (qint64(quint32(y)) << 32) | quint32(x); }
+
+    QList<Surface *> m_stack;
+    QHash<Surface *, int> m_stackPositions;
+    QHash<qint64, QVector<Surface *> > m_cells;
+    QHash<Surface *, QRect> m_surfaceCells;
+    QSet<Surface *> m_dirtySurfaces;
+    bool m_alphaTest;
+};
+
+}
+
+#endif // WLSURFACEINDEX_H
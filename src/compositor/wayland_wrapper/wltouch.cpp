@@ -54,13 +54,19 @@ const struct wl_touch_extension_interface TouchExtensionGlobal::touch_interface
 };
 
 static const int maxRawPos = 24;
+// Older libwayland versions marshal each message into a small fixed buffer,
+// touch_frame events are kept below this size, see touch-extension.xml
+static const int maxTouchFrameSize = 768;
 
 TouchExtensionGlobal::TouchExtensionGlobal(Compositor *compositor)
     : m_compositor(compositor),
-      m_flags(0)
+      m_flags(0),
+      m_pendingSurface(0),
+      m_pendingResampled(false)
 {
     wl_array_init(&m_rawdata_array);
     m_rawdata_ptr = static_cast<float *>(wl_array_add(&m_rawdata_array, maxRawPos * sizeof(float) * 2));
+    wl_array_init(&m_frame_array);
 
     wl_display_add_global(compositor->wl_display(),
                           &wl_touch_extension_interface,
@@ -71,22 +77,29 @@ TouchExtensionGlobal::TouchExtensionGlobal(Compositor *compositor)
 TouchExtensionGlobal::~TouchExtensionGlobal()
 {
     wl_array_release(&m_rawdata_array);
+    wl_array_release(&m_frame_array);
 }
 
 void TouchExtensionGlobal::destroy_resource(wl_resource *resource)
 {
     TouchExtensionGlobal *self = static_cast<TouchExtensionGlobal *>(resource->data);
-    self->m_resources.removeOne(resource);
+    QMultiHash<wl_client *, Binding>::iterator it = self->m_resources.find(resource->client);
+    while (it != self->m_resources.end() && it.key() == resource->client) {
+        if (it->resource == resource)
+            it = self->m_resources.erase(it);
+        else
+            ++it;
+    }
     free(resource);
 }
 
 void TouchExtensionGlobal::bind_func(wl_client *client, void *data, uint32_t version, uint32_t id)
 {
-    Q_UNUSED(version);
     wl_resource *resource = wl_client_add_object(client, &wl_touch_extension_interface, &touch_interface, id, data);
     resource->destroy = destroy_resource;
     TouchExtensionGlobal *self = static_cast<TouchExtensionGlobal *>(resource->data);
-    self->m_resources.append(resource);
+    Binding binding = { resource, version };
+    self->m_resources.insert(client, binding);
     wl_resource_post_event(resource, WL_TOUCH_EXTENSION_CONFIGURE, self->m_flags);
 }
 
@@ -98,75 +111,270 @@ static inline int toFixed(qreal f)
 void TouchExtensionGlobal::postTouchEvent(QTouchEvent *event, Surface *surface)
 {
     const QList<QTouchEvent::TouchPoint> points = event->touchPoints();
+    if (points.isEmpty())
+        return;
+
+    const int resamplingLatency = m_compositor->inputResamplingLatency();
+    if (resamplingLatency <= 0) {
+        // Resampling may just have been turned off with points still down
+        m_resamplers.clear();
+        sendTouchPoints(points, surface);
+        return;
+    }
+
+    // Only pure motion is held back for the next frame, presses and
+    // releases go out at once, after whatever motion was still pending.
+    const qint64 now = m_compositor->monotonicTimeUsecs();
+    bool motionOnly = true;
+    for (int i = 0; i < points.count(); ++i) {
+        const QTouchEvent::TouchPoint &tp(points.at(i));
+        switch (tp.state()) {
+        case Qt::TouchPointPressed:
+            m_resamplers[tp.id()].reset();
+            m_resamplers[tp.id()].addSample(now, tp.pos());
+            motionOnly = false;
+            break;
+        case Qt::TouchPointMoved:
+            m_resamplers[tp.id()].addSample(now, tp.pos());
+            break;
+        case Qt::TouchPointReleased:
+            motionOnly = false;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (motionOnly && (!m_pendingSurface || m_pendingSurface == surface)) {
+        QList<QTouchEvent::TouchPoint> merged = points;
+        if (m_pendingSurface) {
+            // A point that moved earlier in this frame must not be reported
+            // stationary, the client would never see where it went.
+            for (int i = 0; i < merged.count(); ++i) {
+                if (merged.at(i).state() != Qt::TouchPointStationary)
+                    continue;
+                for (int j = 0; j < m_pendingPoints.count(); ++j) {
+                    const QTouchEvent::TouchPoint &pending(m_pendingPoints.at(j));
+                    if (pending.id() == merged.at(i).id() && pending.state() == Qt::TouchPointMoved) {
+                        merged[i] = pending;
+                        break;
+                    }
+                }
+            }
+        } else {
+            m_compositor->scheduleMotionFlush(resamplingLatency * 4);
+        }
+        m_pendingPoints = merged;
+        m_pendingSurface = surface;
+        m_pendingResampled = false;
+        return;
+    }
+
+    flushPendingTouch();
+    sendTouchPoints(points, surface);
+
+    for (int i = 0; i < points.count(); ++i) {
+        if (points.at(i).state() == Qt::TouchPointReleased)
+            m_resamplers.remove(points.at(i).id());
+    }
+}
+
+// All points are gone, whatever motion is pending still goes out first
+void TouchExtensionGlobal::cancelTouch()
+{
+    flushPendingTouch();
+    m_resamplers.clear();
+}
+
+void TouchExtensionGlobal::flushPendingTouch()
+{
+    Surface *surface = m_pendingSurface;
+    if (!surface)
+        return;
+
+    m_pendingSurface = 0;
+    QList<QTouchEvent::TouchPoint> points;
+    points.swap(m_pendingPoints);
+    sendTouchPoints(points, surface);
+}
+
+// Like InputDevice::resamplePendingMotion(), the moving points are sent at
+// their position at \a usecs, the newest raw positions stay pending. The raw
+// arrays are not touched and still carry what the touch screen reported.
+void TouchExtensionGlobal::resamplePendingTouch(qint64 usecs)
+{
+    if (!m_pendingSurface)
+        return;
+
+    QList<QTouchEvent::TouchPoint> points = m_pendingPoints;
+    bool resampled = false;
+    for (int i = 0; i < points.count(); ++i) {
+        QTouchEvent::TouchPoint &tp(points[i]);
+        if (tp.state() != Qt::TouchPointMoved)
+            continue;
+        QHash<int, MotionResampler>::const_iterator it = m_resamplers.constFind(tp.id());
+        if (it == m_resamplers.constEnd())
+            continue;
+        if (usecs >= it->latestTime() && m_pendingResampled)
+            continue;
+        QPointF pos;
+        if (!it->resample(usecs, &pos))
+            continue;
+        const QPointF delta = pos - tp.pos();
+        tp.setPos(pos);
+        tp.setScenePos(tp.scenePos() + delta);
+        tp.setScreenPos(tp.screenPos() + delta);
+        resampled = true;
+    }
+
+    if (!resampled) {
+        flushPendingTouch();
+        return;
+    }
+
+    m_pendingResampled = true;
+    m_compositor->scheduleMotionFlush(m_compositor->inputResamplingLatency() * 4);
+    sendTouchPoints(points, m_pendingSurface);
+}
+
+void TouchExtensionGlobal::surfaceDestroyed(Surface *surface)
+{
+    if (m_pendingSurface == surface) {
+        m_pendingSurface = 0;
+        m_pendingPoints.clear();
+    }
+}
+
+void TouchExtensionGlobal::sendTouchPoints(const QList<QTouchEvent::TouchPoint> &points, Surface *surface)
+{
     const int pointCount = points.count();
-    if (!pointCount)
+
+    wl_client *surfaceClient = surface->base()->resource.client;
+    QMultiHash<wl_client *, Binding>::const_iterator it = m_resources.constFind(surfaceClient);
+    if (it == m_resources.constEnd())
         return;
 
     QPointF surfacePos = surface->pos();
-    wl_client *surfaceClient = surface->base()->resource.client;
     uint32_t time = m_compositor->currentTimeMsecs();
-    const int rescount = m_resources.count();
 
-    for (int res = 0; res < rescount; ++res) {
-        wl_resource *target = m_resources.at(res);
-        if (target->client != surfaceClient)
+    // Stationary points are never sent. They are cached on client side.
+    int sentPointCount = 0;
+    for (int i = 0; i < pointCount; ++i) {
+        if (points.at(i).state() != Qt::TouchPointStationary)
+            ++sentPointCount;
+    }
+    if (!sentPointCount)
+        return;
+
+    for (; it != m_resources.constEnd() && it.key() == surfaceClient; ++it) {
+        if (it->version >= 2)
+            postTouchFrame(it->resource, time, points, sentPointCount, surfacePos);
+        else
+            postTouchPoints(it->resource, time, points, sentPointCount, surfacePos);
+    }
+}
+
+// Version 1 clients get one event per point. There is no touch_frame type
+// of event for them; instead the number of points sent is included in the
+// touch point events.
+void TouchExtensionGlobal::postTouchPoints(wl_resource *target, uint32_t time,
+                                           const QList<QTouchEvent::TouchPoint> &points,
+                                           int sentPointCount, const QPointF &surfacePos)
+{
+    for (int i = 0; i < points.count(); ++i) {
+        const QTouchEvent::TouchPoint &tp(points.at(i));
+        if (tp.state() == Qt::TouchPointStationary)
             continue;
 
-        // We will use no touch_frame type of event, to reduce the number of
-        // events flowing through the wire. Instead, the number of points sent is
-        // included in the touch point events.
-        int sentPointCount = 0;
-        for (int i = 0; i < pointCount; ++i) {
-            if (points.at(i).state() != Qt::TouchPointStationary)
-                ++sentPointCount;
-        }
+        uint32_t id = tp.id();
+        uint32_t state = (tp.state() & 0xFFFF) | (sentPointCount << 16);
+        uint32_t flags = tp.flags();
 
-        for (int i = 0; i < pointCount; ++i) {
-            const QTouchEvent::TouchPoint &tp(points.at(i));
-            // Stationary points are never sent. They are cached on client side.
-            if (tp.state() == Qt::TouchPointStationary)
-                continue;
-
-            uint32_t id = tp.id();
-            uint32_t state = (tp.state() & 0xFFFF) | (sentPointCount << 16);
-            uint32_t flags = tp.flags();
-
-            QPointF p = tp.pos() - surfacePos; // surface-relative
-            int x = toFixed(p.x());
-            int y = toFixed(p.y());
-            int nx = toFixed(tp.normalizedPos().x());
-            int ny = toFixed(tp.normalizedPos().y());
-            int w = toFixed(tp.rect().width());
-            int h = toFixed(tp.rect().height());
-            int vx = toFixed(tp.velocity().x());
-            int vy = toFixed(tp.velocity().y());
-            uint32_t pressure = uint32_t(tp.pressure() * 255);
-
-            wl_array *rawData = 0;
-            QVector<QPointF> rawPosList = tp.rawScreenPositions();
-            int rawPosCount = rawPosList.count();
-            if (rawPosCount) {
-                rawPosCount = qMin(maxRawPos, rawPosCount);
-                rawData = &m_rawdata_array;
-                rawData->size = rawPosCount * sizeof(float) * 2;
-                float *p = m_rawdata_ptr;
-                for (int rpi = 0; rpi < rawPosCount; ++rpi) {
-                    const QPointF &rawPos(rawPosList.at(rpi));
-                    // This will stay in screen coordinates for performance
-                    // reasons, clients using this data will presumably know
-                    // what they are doing.
-                    *p++ = float(rawPos.x());
-                    *p++ = float(rawPos.y());
-                }
+        QPointF p = tp.pos() - surfacePos; // surface-relative
+        int x = toFixed(p.x());
+        int y = toFixed(p.y());
+        int nx = toFixed(tp.normalizedPos().x());
+        int ny = toFixed(tp.normalizedPos().y());
+        int w = toFixed(tp.rect().width());
+        int h = toFixed(tp.rect().height());
+        int vx = toFixed(tp.velocity().x());
+        int vy = toFixed(tp.velocity().y());
+        uint32_t pressure = uint32_t(tp.pressure() * 255);
+
+        wl_array *rawData = 0;
+        QVector<QPointF> rawPosList = tp.rawScreenPositions();
+        int rawPosCount = rawPosList.count();
+        if (rawPosCount) {
+            rawPosCount = qMin(maxRawPos, rawPosCount);
+            rawData = &m_rawdata_array;
+            rawData->size = rawPosCount * sizeof(float) * 2;
+            float *p = m_rawdata_ptr;
+            for (int rpi = 0; rpi < rawPosCount; ++rpi) {
+                const QPointF &rawPos(rawPosList.at(rpi));
+                // This will stay in screen coordinates for performance
+                // reasons, clients using this data will presumably know
+                // what they are doing.
+                *p++ = float(rawPos.x());
+                *p++ = float(rawPos.y());
             }
+        }
+
+        wl_resource_post_event(target, WL_TOUCH_EXTENSION_TOUCH,
+                               time, id, state,
+                               x, y, nx, ny, w, h,
+                               pressure, vx, vy,
+                               flags, rawData);
+    }
+}
 
-            wl_resource_post_event(target, WL_TOUCH_EXTENSION_TOUCH,
-                                   time, id, state,
-                                   x, y, nx, ny, w, h,
-                                   pressure, vx, vy,
-                                   flags, rawData);
+// Packs the points into as few touch_frame events as fit the message size,
+// see touch-extension.xml for the layout. Like for version 1, the state of
+// every point carries the number of points of the whole frame.
+void TouchExtensionGlobal::postTouchFrame(wl_resource *target, uint32_t time,
+                                          const QList<QTouchEvent::TouchPoint> &points,
+                                          int sentPointCount, const QPointF &surfacePos)
+{
+    m_frame_array.size = 0;
+
+    for (int i = 0; i < points.count(); ++i) {
+        const QTouchEvent::TouchPoint &tp(points.at(i));
+        if (tp.state() == Qt::TouchPointStationary)
+            continue;
+
+        const QVector<QPointF> rawPosList = tp.rawScreenPositions();
+        const int rawPosCount = qMin(maxRawPos, rawPosList.count());
+        const size_t recordSize = (13 + rawPosCount * 2) * sizeof(int32_t);
+
+        if (m_frame_array.size && m_frame_array.size + recordSize > size_t(maxTouchFrameSize)) {
+            wl_resource_post_event(target, WL_TOUCH_EXTENSION_TOUCH_FRAME, time, &m_frame_array);
+            m_frame_array.size = 0;
+        }
+
+        int32_t *rec = static_cast<int32_t *>(wl_array_add(&m_frame_array, recordSize));
+        const QPointF p = tp.pos() - surfacePos; // surface-relative
+        *rec++ = tp.id();
+        *rec++ = (tp.state() & 0xFFFF) | (sentPointCount << 16);
+        *rec++ = toFixed(p.x());
+        *rec++ = toFixed(p.y());
+        *rec++ = toFixed(tp.normalizedPos().x());
+        *rec++ = toFixed(tp.normalizedPos().y());
+        *rec++ = toFixed(tp.rect().width());
+        *rec++ = toFixed(tp.rect().height());
+        *rec++ = uint32_t(tp.pressure() * 255);
+        *rec++ = toFixed(tp.velocity().x());
+        *rec++ = toFixed(tp.velocity().y());
+        *rec++ = tp.flags();
+        *rec++ = rawPosCount;
+
+        float *raw = reinterpret_cast<float *>(rec);
+        for (int rpi = 0; rpi < rawPosCount; ++rpi) {
+            const QPointF &rawPos(rawPosList.at(rpi));
+            *raw++ = float(rawPos.x());
+            *raw++ = float(rawPos.y());
         }
     }
+
+    wl_resource_post_event(target, WL_TOUCH_EXTENSION_TOUCH_FRAME, time, &m_frame_array);
 }
 
 }
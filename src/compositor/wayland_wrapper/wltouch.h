@@ -42,12 +42,15 @@
 #define WLTOUCH_H
 
 #include "wlcompositor.h"
+#include "wlmotionresampler.h"
 #include "wayland-touch-extension-server-protocol.h"
 #include "wayland-util.h"
 
+#include <QtCore/QMultiHash>
+#include <QTouchEvent>
+
 class Compositor;
 class Surface;
-class QTouchEvent;
 
 namespace Wayland {
 
@@ -59,9 +62,25 @@ public:
 
     void postTouchEvent(QTouchEvent *event, Surface *surface);
 
+    void flushPendingTouch();
+    void cancelTouch();
+    void resamplePendingTouch(qint64 usecs);
+    void surfaceDestroyed(Surface *surface);
+
     void setFlags(int flags) { m_flags = flags; }
 
 private:
+    struct Binding {
+        wl_resource *resource;
+        uint32_t version;
+    };
+
+    void sendTouchPoints(const QList<QTouchEvent::TouchPoint> &points, Surface *surface);
+    void postTouchPoints(wl_resource *target, uint32_t time, const QList<QTouchEvent::TouchPoint> &points,
+                         int sentPointCount, const QPointF &surfacePos);
+    void postTouchFrame(wl_resource *target, uint32_t time, const QList<QTouchEvent::TouchPoint> &points,
+                        int sentPointCount, const QPointF &surfacePos);
+
     static void bind_func(struct wl_client *client, void *data,
                           uint32_t version, uint32_t id);
 
@@ -71,9 +90,16 @@ private:
 
     Compositor *m_compositor;
     int m_flags;
-    QList<wl_resource *> m_resources;
+    QMultiHash<wl_client *, Binding> m_resources;
     wl_array m_rawdata_array;
     float *m_rawdata_ptr;
+    wl_array m_frame_array;
+
+    // Motion held back for resampling, see Compositor::setInputResamplingLatency()
+    QHash<int, MotionResampler> m_resamplers;
+    QList<QTouchEvent::TouchPoint> m_pendingPoints;
+    Surface *m_pendingSurface;
+    bool m_pendingResampled;
 };
 
 }
@@ -47,29 +47,7 @@
 #include <QtGui/QWindowContext>
 
 #include "qwaylandshmsurface.h"
-
-
-static inline void qgl_byteSwapImage(QImage &img, GLenum pixel_type)
-{
-    const int width = img.width();
-    const int height = img.height();
-
-    if (pixel_type == GL_UNSIGNED_INT_8_8_8_8_REV
-        || (pixel_type == GL_UNSIGNED_BYTE && QSysInfo::ByteOrder == QSysInfo::LittleEndian))
-    {
-        for (int i = 0; i < height; ++i) {
-            uint *p = (uint *) img.scanLine(i);
-            for (int x = 0; x < width; ++x)
-                p[x] = ((p[x] << 16) & 0xff0000) | ((p[x] >> 16) & 0xff) | (p[x] & 0xff00ff00);
-        }
-    } else {
-        for (int i = 0; i < height; ++i) {
-            uint *p = (uint *) img.scanLine(i);
-            for (int x = 0; x < width; ++x)
-                p[x] = (p[x] << 8) | ((p[x] >> 24) & 0xff);
-        }
-    }
-}
+#include "qwaylandreadbackpixels.h"
 
 QWaylandReadbackEglContext::QWaylandReadbackEglContext(QWaylandReadbackEglIntegration *eglIntegration, QWaylandReadbackEglWindow *window)
     : mEglIntegration(eglIntegration)
@@ -116,23 +94,18 @@ void QWaylandReadbackEglContext::swapBuffers()
     }
 
     QSize size = mWindow->geometry().size();
+    QRect rect(QPoint(0,0),size);
 
-    QImage img(size,QImage::Format_ARGB32);
-    const uchar *constBits = img.bits();
-    void *pixels = const_cast<uchar *>(constBits);
-
-    glReadPixels(0,0, size.width(), size.height(), GL_RGBA,GL_UNSIGNED_BYTE, pixels);
-
-    img = img.mirrored();
-    qgl_byteSwapImage(img,GL_UNSIGNED_INT_8_8_8_8_REV);
-    constBits = img.bits();
-
-    const uchar *constDstBits = mBuffer->image()->bits();
-    uchar *dstBits = const_cast<uchar *>(constDstBits);
-    memcpy(dstBits,constBits,(img.width()*4) * img.height());
+    // OpenGL ES 2 has neither pixel buffer objects nor a guaranteed BGRA
+    // read format, so read RGBA into a reused scratch buffer and let the
+    // copy into the shm buffer flip and swizzle in a single pass.
+    mReadbackData.resize(size.width() * size.height() * 4);
+    glReadPixels(0,0, size.width(), size.height(), GL_RGBA,GL_UNSIGNED_BYTE, mReadbackData.data());
 
+    qt_wayland_copyReadbackPixels(reinterpret_cast<const uchar *>(mReadbackData.constData()),
+                                  size.width() * 4, mBuffer->image(), rect, true);
 
-    mWindow->damage(QRegion(QRect(QPoint(0,0),size)));
+    mWindow->damage(QRegion(rect));
 }
 
 void * QWaylandReadbackEglContext::getProcAddress(const QString &procName)
@@ -74,6 +74,8 @@ private:
     EGLConfig mConfig;
     EGLContext mContext;
     EGLSurface mPixmapSurface;
+
+    QByteArray mReadbackData;
 };
 
 #endif // QWAYLANDREADBACKEGLGLCONTEXT_H
@@ -1,3 +1,5 @@
+include (../readback_share/readback_share.pri)
+
 LIBS += -lX11 -lXext -lEGL
 
 load(qpa/egl/convenience)
@@ -43,43 +43,62 @@
 
 #include "qwaylandshmbackingstore.h"
 #include "qwaylandreadbackglxwindow.h"
+#include "qwaylandreadbackpixels.h"
 
 #include <QtGui/QOpenGLContext>
 #include <QtCore/QDebug>
 
-static inline void qgl_byteSwapImage(QImage &img, GLenum pixel_type)
-{
-    const int width = img.width();
-    const int height = img.height();
-
-    if (pixel_type == GL_UNSIGNED_INT_8_8_8_8_REV
-        || (pixel_type == GL_UNSIGNED_BYTE && QSysInfo::ByteOrder == QSysInfo::LittleEndian))
-    {
-        for (int i = 0; i < height; ++i) {
-            uint *p = (uint *) img.scanLine(i);
-            for (int x = 0; x < width; ++x)
-                p[x] = ((p[x] << 16) & 0xff0000) | ((p[x] >> 16) & 0xff) | (p[x] & 0xff00ff00);
-        }
-    } else {
-        for (int i = 0; i < height; ++i) {
-            uint *p = (uint *) img.scanLine(i);
-            for (int x = 0; x < width; ++x)
-                p[x] = (p[x] << 8) | ((p[x] >> 24) & 0xff);
-        }
-    }
-}
-
 QWaylandReadbackGlxContext::QWaylandReadbackGlxContext(const QSurfaceFormat &format,
         QPlatformOpenGLContext *share, Display *display, int screen)
     : m_display(display)
+    , m_screen(screen)
+    , m_resolvedPixelBufferFunctions(false)
+    , m_glGenBuffers(0)
+    , m_glDeleteBuffers(0)
+    , m_glBindBuffer(0)
+    , m_glBufferData(0)
+    , m_glMapBuffer(0)
+    , m_glUnmapBuffer(0)
+    , m_pixelBuffer(0)
 {
-    GLXFBConfig config = qglx_findConfig(display, screen, format, GLX_PIXMAP_BIT);
+    m_config = qglx_findConfig(display, screen, format, GLX_PIXMAP_BIT);
 
     GLXContext shareContext = share ? static_cast<QWaylandReadbackGlxContext *>(share)->m_context : 0;
 
-    XVisualInfo *visualInfo = glXGetVisualFromFBConfig(display, config);
+    XVisualInfo *visualInfo = glXGetVisualFromFBConfig(display, m_config);
     m_context = glXCreateContext(display, visualInfo, shareContext, TRUE);
-    m_format = qglx_surfaceFormatFromGLXFBConfig(display, config, m_context);
+    m_format = qglx_surfaceFormatFromGLXFBConfig(display, m_config, m_context);
+}
+
+QWaylandReadbackGlxContext::~QWaylandReadbackGlxContext()
+{
+    // The pixel buffer can only be deleted with the context current. The
+    // windows it was current on may be gone, a 1x1 pixmap does as well.
+    if (m_pixelBuffer) {
+        GLXContext previousContext = glXGetCurrentContext();
+        GLXDrawable previousDrawable = glXGetCurrentDrawable();
+        Pixmap pixmap = 0;
+        GLXPixmap glxPixmap = 0;
+
+        bool current = previousContext == m_context;
+        if (!current) {
+            int depth = XDefaultDepth(m_display, m_screen);
+            pixmap = XCreatePixmap(m_display, RootWindow(m_display, m_screen), 1, 1, depth);
+            glxPixmap = glXCreatePixmap(m_display, m_config, pixmap, 0);
+            current = glxPixmap && glXMakeCurrent(m_display, glxPixmap, m_context);
+        }
+        if (current)
+            m_glDeleteBuffers(1, &m_pixelBuffer);
+
+        if (previousContext != m_context)
+            glXMakeCurrent(m_display, previousDrawable, previousContext);
+        if (glxPixmap)
+            glXDestroyPixmap(m_display, glxPixmap);
+        if (pixmap)
+            XFreePixmap(m_display, pixmap);
+    }
+
+    glXDestroyContext(m_display, m_context);
 }
 
 QSurfaceFormat QWaylandReadbackGlxContext::format() const
@@ -99,6 +118,41 @@ void QWaylandReadbackGlxContext::doneCurrent()
     glXMakeCurrent(m_display, 0, 0);
 }
 
+bool QWaylandReadbackGlxContext::ensurePixelBuffer(const QSize &size)
+{
+    if (!m_resolvedPixelBufferFunctions) {
+        m_resolvedPixelBufferFunctions = true;
+        const QByteArray extensions(reinterpret_cast<const char *>(glGetString(GL_EXTENSIONS)));
+        if (extensions.contains("GL_ARB_pixel_buffer_object")) {
+            m_glGenBuffers = (PFNGLGENBUFFERSARBPROC) getProcAddress("glGenBuffersARB");
+            m_glDeleteBuffers = (PFNGLDELETEBUFFERSARBPROC) getProcAddress("glDeleteBuffersARB");
+            m_glBindBuffer = (PFNGLBINDBUFFERARBPROC) getProcAddress("glBindBufferARB");
+            m_glBufferData = (PFNGLBUFFERDATAARBPROC) getProcAddress("glBufferDataARB");
+            m_glMapBuffer = (PFNGLMAPBUFFERARBPROC) getProcAddress("glMapBufferARB");
+            m_glUnmapBuffer = (PFNGLUNMAPBUFFERARBPROC) getProcAddress("glUnmapBufferARB");
+        }
+        if (!m_glGenBuffers || !m_glDeleteBuffers || !m_glBindBuffer
+                || !m_glBufferData || !m_glMapBuffer || !m_glUnmapBuffer) {
+            qDebug() << "QWaylandReadbackGlxContext: no pixel buffer objects, using synchronous readback";
+            m_glGenBuffers = 0;
+        }
+    }
+
+    if (!m_glGenBuffers)
+        return false;
+
+    if (!m_pixelBuffer)
+        m_glGenBuffers(1, &m_pixelBuffer);
+
+    m_glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, m_pixelBuffer);
+    if (m_pixelBufferSize != size) {
+        m_glBufferData(GL_PIXEL_PACK_BUFFER_ARB, size.width() * size.height() * 4, 0, GL_STREAM_READ_ARB);
+        m_pixelBufferSize = size;
+    }
+
+    return true;
+}
+
 void QWaylandReadbackGlxContext::swapBuffers(QPlatformSurface *surface)
 {
     // #### makeCurrent() directly on the platform context doesn't update QOpenGLContext::currentContext()
@@ -108,24 +162,33 @@ void QWaylandReadbackGlxContext::swapBuffers(QPlatformSurface *surface)
     QWaylandReadbackGlxWindow *w = static_cast<QWaylandReadbackGlxWindow *>(surface);
 
     QSize size = w->geometry().size();
+    QRect rect(QPoint(), size);
+
+    // GL_BGRA/GL_UNSIGNED_INT_8_8_8_8_REV is QImage::Format_ARGB32, so only
+    // the vertical flip is left to do when copying into the shm buffer.
+    if (ensurePixelBuffer(size)) {
+        // Start the transfer into the pixel buffer and let it run while we
+        // wait for the compositor to be done with the previous frame.
+        glReadPixels(0, 0, size.width(), size.height(), GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, 0);
+        glFlush();
+
+        w->waitForFrameSync();
+
+        const uchar *pixels = static_cast<const uchar *>(m_glMapBuffer(GL_PIXEL_PACK_BUFFER_ARB, GL_READ_ONLY_ARB));
+        if (pixels)
+            qt_wayland_copyReadbackPixels(pixels, size.width() * 4, w->bufferImage(), rect, false);
+        m_glUnmapBuffer(GL_PIXEL_PACK_BUFFER_ARB);
+        m_glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, 0);
+    } else {
+        w->waitForFrameSync();
 
-    QImage img(size, QImage::Format_ARGB32);
-    const uchar *constBits = img.bits();
-    void *pixels = const_cast<uchar *>(constBits);
-
-    glReadPixels(0, 0, size.width(), size.height(), GL_RGBA,GL_UNSIGNED_BYTE, pixels);
-
-    img = img.mirrored();
-    qgl_byteSwapImage(img, GL_UNSIGNED_INT_8_8_8_8_REV);
-    constBits = img.bits();
-
-    const uchar *constDstBits = w->buffer();
-    uchar *dstBits = const_cast<uchar *>(constDstBits);
-    memcpy(dstBits, constBits, (img.width() * 4) * img.height());
-
-    w->damage(QRect(QPoint(), size));
+        m_readbackData.resize(size.width() * size.height() * 4);
+        glReadPixels(0, 0, size.width(), size.height(), GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, m_readbackData.data());
+        qt_wayland_copyReadbackPixels(reinterpret_cast<const uchar *>(m_readbackData.constData()),
+                                      size.width() * 4, w->bufferImage(), rect, false);
+    }
 
-    w->waitForFrameSync();
+    w->damage(rect);
 }
 
 void (*QWaylandReadbackGlxContext::getProcAddress(const QByteArray &procName)) ()
@@ -49,6 +49,8 @@
 
 #include <QtPlatformSupport/private/qglxconvenience_p.h>
 
+#include <GL/glext.h>
+
 class QWaylandReadbackGlxWindow;
 class QWaylandShmBuffer;
 
@@ -56,6 +58,7 @@ class QWaylandReadbackGlxContext : public QPlatformOpenGLContext
 {
 public:
     QWaylandReadbackGlxContext(const QSurfaceFormat &format, QPlatformOpenGLContext *share, Display *display, int screen);
+    ~QWaylandReadbackGlxContext();
 
     QSurfaceFormat format() const;
 
@@ -67,10 +70,25 @@ public:
     void (*getProcAddress(const QByteArray &procName)) ();
 
 private:
+    bool ensurePixelBuffer(const QSize &size);
+
     GLXContext m_context;
 
     Display *m_display;
+    int m_screen;
+    GLXFBConfig m_config;
     QSurfaceFormat m_format;
+
+    bool m_resolvedPixelBufferFunctions;
+    PFNGLGENBUFFERSARBPROC m_glGenBuffers;
+    PFNGLDELETEBUFFERSARBPROC m_glDeleteBuffers;
+    PFNGLBINDBUFFERARBPROC m_glBindBuffer;
+    PFNGLBUFFERDATAARBPROC m_glBufferData;
+    PFNGLMAPBUFFERARBPROC m_glMapBuffer;
+    PFNGLUNMAPBUFFERARBPROC m_glUnmapBuffer;
+    GLuint m_pixelBuffer;
+    QSize m_pixelBufferSize;
+    QByteArray m_readbackData;
 };
 
 #endif // QWAYLANDREADBACKGLXCONTEXT_H
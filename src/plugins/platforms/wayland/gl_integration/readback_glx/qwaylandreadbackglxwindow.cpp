@@ -86,6 +86,11 @@ uchar *QWaylandReadbackGlxWindow::buffer()
     return m_buffer->image()->bits();
 }
 
+QImage *QWaylandReadbackGlxWindow::bufferImage()
+{
+    return m_buffer->image();
+}
+
 void QWaylandReadbackGlxWindow::createSurface()
 {
     QSize size(geometry().size());
@@ -57,6 +57,7 @@ public:
     Pixmap glxPixmap() const;
 
     uchar *buffer();
+    QImage *bufferImage();
 
 private:
     void createSurface();
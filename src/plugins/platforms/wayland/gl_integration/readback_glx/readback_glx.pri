@@ -1,3 +1,5 @@
+include (../readback_share/readback_share.pri)
+
 HEADERS += \
     $$PWD/qwaylandreadbackglxintegration.h \
     $$PWD/qwaylandreadbackglxwindow.h \
@@ -0,0 +1,92 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the plugins of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.LGPL included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights. These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU General
+** Public License version 3.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of this
+** file. Please review the following information to ensure the GNU General
+** Public License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** Other Usage
+** Alternatively, this file may be used in accordance with the terms and
+** conditions contained in a signed written agreement between you and Nokia.
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qwaylandreadbackpixels.h"
+
+#include <QtGui/QImage>
+
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Turns 0xAABBGGRR into 0xAARRGGBB
+static void swapRedBlue(quint32 *dst, const quint32 *src, int count)
+{
+    int x = 0;
+#ifdef __SSE2__
+    const __m128i greenAlphaMask = _mm_set1_epi32(0xff00ff00);
+    const __m128i redBlueMask = _mm_set1_epi32(0x000000ff);
+    for (; x + 4 <= count; x += 4) {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x));
+        __m128i ga = _mm_and_si128(p, greenAlphaMask);
+        __m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), redBlueMask);
+        __m128i b = _mm_slli_epi32(_mm_and_si128(p, redBlueMask), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm_or_si128(ga, _mm_or_si128(r, b)));
+    }
+#endif
+    for (; x < count; ++x) {
+        const quint32 p = src[x];
+        dst[x] = ((p << 16) & 0xff0000) | ((p >> 16) & 0xff) | (p & 0xff00ff00);
+    }
+}
+
+void qt_wayland_copyReadbackPixels(const uchar *src, int srcStride,
+                                   QImage *dst, const QRect &rect,
+                                   bool swap)
+{
+    Q_ASSERT(dst->rect().contains(rect));
+    const QRect &r = rect;
+
+    const int bytesPerLine = dst->bytesPerLine();
+    uchar *dstBits = dst->bits() + r.x() * 4;
+
+    for (int y = 0; y < r.height(); ++y) {
+        // Row 0 of the source is the bottom row of the rectangle
+        const uchar *srcLine = src + (r.height() - 1 - y) * srcStride;
+        uchar *dstLine = dstBits + (r.y() + y) * bytesPerLine;
+        if (swap)
+            swapRedBlue(reinterpret_cast<quint32 *>(dstLine), reinterpret_cast<const quint32 *>(srcLine), r.width());
+        else
+            memcpy(dstLine, srcLine, r.width() * 4);
+    }
+}
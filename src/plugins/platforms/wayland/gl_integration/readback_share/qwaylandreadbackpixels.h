@@ -0,0 +1,58 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the plugins of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.LGPL included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights. These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU General
+** Public License version 3.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of this
+** file. Please review the following information to ensure the GNU General
+** Public License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** Other Usage
+** Alternatively, this file may be used in accordance with the terms and
+** conditions contained in a signed written agreement between you and Nokia.
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QWAYLANDREADBACKPIXELS_H
+#define QWAYLANDREADBACKPIXELS_H
+
+#include <QtCore/QRect>
+
+class QImage;
+
+// Copies pixels returned by glReadPixels for the window rectangle 'rect'
+// into 'dst'. GL rows run bottom to top; the flip is done by addressing
+// the destination rows in reverse, so no intermediate image is needed.
+// With swapRedBlue set, GL_RGBA/GL_UNSIGNED_BYTE data is converted to
+// QImage::Format_ARGB32 on the way.
+void qt_wayland_copyReadbackPixels(const uchar *src, int srcStride,
+                                   QImage *dst, const QRect &rect,
+                                   bool swapRedBlue);
+
+#endif // QWAYLANDREADBACKPIXELS_H
@@ -0,0 +1,7 @@
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/qwaylandreadbackpixels.h
+
+SOURCES += \
+    $$PWD/qwaylandreadbackpixels.cpp
@@ -50,6 +50,7 @@
 
 QWaylandEglIntegration::QWaylandEglIntegration(struct wl_display *waylandDisplay)
     : m_waylandDisplay(waylandDisplay)
+    , m_eglDisplay(EGL_NO_DISPLAY)
 {
     qDebug() << "Using Wayland-EGL";
 }
@@ -57,7 +58,8 @@ QWaylandEglIntegration::QWaylandEglIntegration(struct wl_display *waylandDisplay
 
 QWaylandEglIntegration::~QWaylandEglIntegration()
 {
-    eglTerminate(m_eglDisplay);
+    if (m_eglDisplay != EGL_NO_DISPLAY)
+        eglTerminate(m_eglDisplay);
 }
 
 void QWaylandEglIntegration::initialize()
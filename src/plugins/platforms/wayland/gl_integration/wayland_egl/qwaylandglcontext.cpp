@@ -86,7 +86,11 @@ void QWaylandGLContext::doneCurrent()
 
 void QWaylandGLContext::swapBuffers(QPlatformSurface *surface)
 {
-    EGLSurface eglSurface = static_cast<QWaylandEglWindow *>(surface)->eglSurface();
+    QWaylandEglWindow *window = static_cast<QWaylandEglWindow *>(surface);
+    // Ask for our own frame callback so that requestUpdate() is paced
+    // by the compositor for GL windows as well.
+    window->requestFrameCallback();
+    EGLSurface eglSurface = window->eglSurface();
     eglSwapBuffers(m_eglDisplay, eglSurface);
 }
 
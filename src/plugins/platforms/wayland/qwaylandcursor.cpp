@@ -102,10 +102,19 @@ static const struct pointer_image {
     { DATADIR "/wayland/dnd-link.png",			13, 13 },
 };
 
+// Maximum number of distinct pixmap cursors kept around
+static const int maxCachedPixmapCursors = 16;
+
 QWaylandCursor::QWaylandCursor(QWaylandScreen *screen)
-    : mBuffer(0)
-    , mDisplay(screen->display())
+    : mDisplay(screen->display())
+    , mCurrentBuffer(0)
+{
+}
+
+QWaylandCursor::~QWaylandCursor()
 {
+    qDeleteAll(mShapeBuffers);
+    qDeleteAll(mPixmapBuffers);
 }
 
 void QWaylandCursor::changeCursor(QCursor *cursor, QWindow *window)
@@ -171,36 +180,62 @@ void QWaylandCursor::changeCursor(QCursor *cursor, QWindow *window)
     } else if (isBitmap && cursor->bitmap()) {
         qWarning("unsupported QBitmap cursor");
     } else {
-        QImageReader reader(p->filename);
-        if (!reader.canRead())
-            return;
-        if (mBuffer == NULL || mBuffer->size() != reader.size()) {
-            delete mBuffer;
-            mBuffer = new QWaylandShmBuffer(mDisplay, reader.size(),
-                                            QImage::Format_ARGB32);
+        // Decoded images are kept per pointer_images entry
+        int index = p - pointer_images;
+        QWaylandShmBuffer *buffer = mShapeBuffers.value(index);
+        if (!buffer) {
+            QImageReader reader(p->filename);
+            if (!reader.canRead())
+                return;
+            buffer = new QWaylandShmBuffer(mDisplay, reader.size(),
+                                           QImage::Format_ARGB32);
+            reader.read(buffer->image());
+            buffer->damage();
+            mShapeBuffers.insert(index, buffer);
         }
-        reader.read(mBuffer->image());
-        mBuffer->damage();
-        mDisplay->setCursor(mBuffer, p->hotspot_x, p->hotspot_y);
+        setCursor(buffer, QPoint(p->hotspot_x, p->hotspot_y));
     }
 }
 
 void QWaylandCursor::setupPixmapCursor(QCursor *cursor)
 {
-    if (!cursor) {
-        delete mBuffer;
-        mBuffer = 0;
+    if (!cursor)
         return;
+
+    const QPixmap pixmap = cursor->pixmap();
+    QWaylandShmBuffer *buffer = mPixmapBuffers.value(pixmap.cacheKey());
+    if (!buffer) {
+        if (mPixmapBuffers.size() >= maxCachedPixmapCursors) {
+            // Drop everything but the cursor currently shown, the
+            // compositor may still be using that buffer.
+            QHash<qint64, QWaylandShmBuffer *>::iterator it = mPixmapBuffers.begin();
+            while (it != mPixmapBuffers.end()) {
+                if (it.value() == mCurrentBuffer) {
+                    ++it;
+                } else {
+                    delete it.value();
+                    it = mPixmapBuffers.erase(it);
+                }
+            }
+        }
+
+        buffer = new QWaylandShmBuffer(mDisplay, pixmap.size(),
+                                       QImage::Format_ARGB32);
+        QImage src = pixmap.toImage().convertToFormat(QImage::Format_ARGB32);
+        for (int y = 0; y < src.height(); ++y)
+            memcpy(buffer->image()->scanLine(y), src.scanLine(y), src.bytesPerLine());
+        buffer->damage();
+        mPixmapBuffers.insert(pixmap.cacheKey(), buffer);
     }
-    if (!mBuffer || mBuffer->size() != cursor->pixmap().size()) {
-        delete mBuffer;
-        mBuffer = new QWaylandShmBuffer(mDisplay, cursor->pixmap().size(),
-                                        QImage::Format_ARGB32);
-    }
-    QImage src = cursor->pixmap().toImage().convertToFormat(QImage::Format_ARGB32);
-    for (int y = 0; y < src.height(); ++y)
-        memcpy(mBuffer->image()->scanLine(y), src.scanLine(y), src.bytesPerLine());
-    mDisplay->setCursor(mBuffer, cursor->hotSpot().x(), cursor->hotSpot().y());
+    setCursor(buffer, cursor->hotSpot());
+}
+
+void QWaylandCursor::setCursor(QWaylandShmBuffer *buffer, const QPoint &hotspot)
+{
+    // Always attach, another client may have changed the cursor since we
+    // last set it, and the buffer may have been redrawn.
+    mCurrentBuffer = buffer;
+    mDisplay->setCursor(buffer, hotspot.x(), hotspot.y());
 }
 
 void QWaylandDisplay::setCursor(QWaylandBuffer *buffer, int32_t x, int32_t y)
@@ -43,6 +43,7 @@
 #define QWAYLANDCURSOR_H
 
 #include <QtGui/QPlatformCursor>
+#include <QtCore/QHash>
 
 class QWaylandShmBuffer;
 class QWaylandDisplay;
@@ -52,6 +53,7 @@ class QWaylandCursor : public QPlatformCursor
 {
 public:
     QWaylandCursor(QWaylandScreen *screen);
+    ~QWaylandCursor();
 
     void changeCursor(QCursor *cursor, QWindow *window);
     void pointerEvent(const QMouseEvent &event);
@@ -60,10 +62,14 @@ public:
 
     void setupPixmapCursor(QCursor *cursor);
 
-    QWaylandShmBuffer *mBuffer;
     QWaylandDisplay *mDisplay;
 
 private:
+    void setCursor(QWaylandShmBuffer *buffer, const QPoint &hotspot);
+
+    QHash<int, QWaylandShmBuffer *> mShapeBuffers;
+    QHash<qint64, QWaylandShmBuffer *> mPixmapBuffers;
+    QWaylandShmBuffer *mCurrentBuffer;
     QPoint mLastPos;
 };
 
@@ -52,6 +52,7 @@
 #include <QtGui/QGuiApplication>
 #include <QtGui/private/qguiapplication_p.h>
 #include <QtGui/QPlatformClipboard>
+#include <QtGui/QPlatformDrag>
 #include <QtGui/QPainter>
 
 #include <QWindowSystemInterface>
@@ -89,25 +90,20 @@ void QWaylandDataDeviceManager::enter(void *data,
         return;
     data_device_manager->m_drag_last_event_time = time;
 
-    data_device_manager->m_drag_current_event_window = static_cast<QWaylandWindow *>(wl_surface_get_user_data(surface));
     if (!surface)
         return;
+    data_device_manager->m_drag_current_event_window = static_cast<QWaylandWindow *>(wl_surface_get_user_data(surface));
     QWaylandDataOffer *offer = static_cast<QWaylandDataOffer *>(wl_data_offer_get_user_data(id));
     if (!offer)
         return;
 
-    QPoint point(x,y);
-    Qt::DropActions allActions =  Qt::CopyAction | Qt::MoveAction | Qt::LinkAction;
-//    QPlatformDragQtResponse response = QWindowSystemInterface::handleDrag(data_device_manager->m_drag_current_event_window->window(),
-//                                                                          offer,point,allActions);
-//    data_device_manager->m_drag_can_drop = response.accepted();
+    // Coming back to a window during the same drag brings the same offer
+    if (data_device_manager->m_drag_data_offer != offer)
+        delete data_device_manager->m_drag_data_offer;
     data_device_manager->m_drag_data_offer = offer;
-    if (data_device_manager->m_drag_can_drop) {
-        const char *first_offer = qPrintable(offer->formats_sys().at(0));
-        wl_data_offer_accept(offer->handle(),QWaylandDisplay::currentTimeMillisec(),first_offer);
-    } else {
-        wl_data_offer_accept(offer->handle(),QWaylandDisplay::currentTimeMillisec(),0);
-    }
+    data_device_manager->m_drag_position = QPoint(x,y);
+    data_device_manager->m_drag_accepted_type = QByteArray();
+    data_device_manager->handleDragMotion();
 }
 
 void QWaylandDataDeviceManager::leave(void *data,
@@ -115,9 +111,10 @@ void QWaylandDataDeviceManager::leave(void *data,
 {
     Q_UNUSED(wl_data_device);
     QWaylandDataDeviceManager *data_device_manager = static_cast<QWaylandDataDeviceManager *>(data);
-//    QWindowSystemInterface::handleDrag(data_device_manager->m_drag_current_event_window->window(),0,QPoint(0,0),Qt::IgnoreAction);
+    if (data_device_manager->m_drag_current_event_window)
+        QWindowSystemInterface::handleDrag(data_device_manager->m_drag_current_event_window->window(),0,QPoint(0,0),Qt::IgnoreAction);
     data_device_manager->m_drag_can_drop = false;
-    data_device_manager->m_drag_data_offer = 0;
+    data_device_manager->m_drag_accepted_type = QByteArray();
     data_device_manager->m_drag_last_event_time = 0;
     data_device_manager->m_drag_current_event_window = 0;
     data_device_manager->m_drag_position = QPoint();
@@ -134,16 +131,7 @@ void QWaylandDataDeviceManager::motion(void *data,
     if (time < data_device_manager->m_drag_last_event_time)
         return;
     data_device_manager->m_drag_position = QPoint(x,y);
-
-    Qt::DropActions allActions =  Qt::CopyAction | Qt::MoveAction | Qt::LinkAction;
-//    QPlatformDragQtResponse response = QWindowSystemInterface::handleDrag(data_device_manager->m_drag_current_event_window->window(),
-//                                       data_device_manager->m_drag_data_offer, data_device_manager->m_drag_position ,allActions);
-//    data_device_manager->m_drag_can_drop = response.accepted();
-    const char *offerMime = 0;
-    if (data_device_manager->m_drag_can_drop) {
-        offerMime = qPrintable(data_device_manager->m_drag_data_offer->formats_sys().at(0));
-    }
-    wl_data_offer_accept(data_device_manager->m_drag_data_offer->handle(),QWaylandDisplay::currentTimeMillisec(),offerMime);
+    data_device_manager->handleDragMotion();
 }
 
 void QWaylandDataDeviceManager::drop(void *data,
@@ -151,16 +139,46 @@ void QWaylandDataDeviceManager::drop(void *data,
 {
     Q_UNUSED(wl_data_device);
     QWaylandDataDeviceManager *data_device_manager = static_cast<QWaylandDataDeviceManager *>(data);
-    QWindow *window = data_device_manager->m_drag_current_event_window->window();
-    QMimeData *mime = data_device_manager->m_drag_data_offer;
-    QPoint point = data_device_manager->m_drag_position;
-    Qt::DropActions allActions =  Qt::CopyAction | Qt::MoveAction | Qt::LinkAction;
+    QWaylandWindow *window = data_device_manager->m_drag_current_event_window;
+    QMimeData *mime = data_device_manager->dragMime();
+    if (window && mime) {
+        Qt::DropActions allActions =  Qt::CopyAction | Qt::MoveAction | Qt::LinkAction;
+        QWindowSystemInterface::handleDrop(window->window(),mime,data_device_manager->m_drag_position,allActions);
+    }
 
-    Q_UNUSED(window);
-    Q_UNUSED(mime);
-//    QWindowSystemInterface::handleDrop(window,mime,point,allActions);
+    // Whatever the window wanted has been read by now, letting go of the
+    // offer tells the source that the drag is over
+    delete data_device_manager->m_drag_data_offer;
+    data_device_manager->m_drag_data_offer = 0;
+    data_device_manager->m_drag_can_drop = false;
+    data_device_manager->m_drag_accepted_type = QByteArray();
+    data_device_manager->m_drag_last_event_time = 0;
+    data_device_manager->m_drag_current_event_window = 0;
 }
 
+// Asks the window under the drag whether it takes the data, the source
+// only hears about it when the answer changes.
+void QWaylandDataDeviceManager::handleDragMotion()
+{
+    QMimeData *mime = dragMime();
+    if (!m_drag_current_event_window || !mime || !m_drag_data_offer)
+        return;
+
+    Qt::DropActions allActions =  Qt::CopyAction | Qt::MoveAction | Qt::LinkAction;
+    QPlatformDragQtResponse response = QWindowSystemInterface::handleDrag(m_drag_current_event_window->window(),
+                                                                          mime,m_drag_position,allActions);
+    m_drag_can_drop = response.isAccepted();
+
+    QByteArray mimeType;
+    QStringList formats = m_drag_data_offer->formats_sys();
+    if (m_drag_can_drop && !formats.isEmpty())
+        mimeType = formats.first().toLatin1();
+    if (mimeType == m_drag_accepted_type)
+        return;
+    m_drag_accepted_type = mimeType;
+    wl_data_offer_accept(m_drag_data_offer->handle(),QWaylandDisplay::currentTimeMillisec(),
+                         mimeType.isEmpty() ? 0 : mimeType.constData());
+}
 
 void QWaylandDataDeviceManager::selection(void *data,
                                             struct wl_data_device *wl_data_device,
@@ -176,6 +194,9 @@ void QWaylandDataDeviceManager::selection(void *data,
 
     mime = static_cast<QWaylandDataOffer *>(wl_data_offer_get_user_data(id));
     handler->m_selection_data_offer = mime;
+    // The offered types were sent before the selection event
+    if (mime)
+        mime->startPrefetch();
 }
 
 const struct wl_data_device_listener QWaylandDataDeviceManager::transfer_device_listener = {
@@ -195,7 +216,9 @@ QWaylandDataDeviceManager::QWaylandDataDeviceManager(QWaylandDisplay *display, u
     , m_drag_data_source(0)
     , m_drag_surface(0)
     , m_drag_buffer(0)
+    , m_drag_current_event_window(0)
     , m_drag_can_drop(false)
+    , m_drag_last_event_time(0)
 {
     m_data_device_manager = static_cast<struct wl_data_device_manager *>(wl_display_bind(display->wl_display(),id,&wl_data_device_manager_interface));
 
@@ -239,7 +262,7 @@ void QWaylandDataDeviceManager::createAndSetDrag(QDrag *drag)
 {
     if (m_drag_data_source) {
         qDebug() << "QWaylandDndSelectionHandler::createAndSetDrag: Allready have a valid drag";
-        delete m_drag_data_source;
+        cancelDrag();
     }
 
     delete m_drag_data_offer;
@@ -249,28 +272,30 @@ void QWaylandDataDeviceManager::createAndSetDrag(QDrag *drag)
 
     struct wl_data_device *transfer_device = m_display->lastKeyboardFocusInputDevice()->transferDevice();
     m_drag_surface = m_display->createSurface(this);
+    wl_data_device_start_drag(transfer_device,m_drag_data_source->handle(),m_drag_surface,QWaylandDisplay::currentTimeMillisec());
+
+    // The icon is drawn once, the compositor moves it with the pointer
     QPixmap pixmap = drag->pixmap();
-    if (pixmap.isNull()) {
-//        pixmap = QPlatformDrag::defaultPixmap();
-    }
+    if (pixmap.isNull())
+        return;
     m_drag_buffer = new QWaylandShmBuffer(m_display,pixmap.size(),QImage::Format_ARGB32_Premultiplied);
-
+    m_drag_buffer->image()->fill(Qt::transparent);
     {
         QPainter p(m_drag_buffer->image());
         p.drawPixmap(0,0,pixmap);
     }
-
-    wl_data_device_start_drag(transfer_device,m_drag_data_source->handle(),m_drag_surface,QWaylandDisplay::currentTimeMillisec());
     wl_data_device_attach(transfer_device,QWaylandDisplay::currentTimeMillisec()
                           ,m_drag_buffer->buffer(),drag->hotSpot().x(),drag->hotSpot().y());
 }
 
 QMimeData *QWaylandDataDeviceManager::dragMime() const
 {
-    if (m_drag_data_offer) {
-        return m_drag_data_offer;
-    } else if (m_drag_data_source){
+    // Dropping on our own window, reading back through the compositor
+    // would block on ourselves
+    if (m_drag_data_source) {
         return m_drag_data_source->mimeData();
+    } else if (m_drag_data_offer){
+        return m_drag_data_offer;
     }
     return 0;
 }
@@ -280,10 +305,21 @@ bool QWaylandDataDeviceManager::canDropDrag() const
     return m_drag_can_drop;
 }
 
+QWaylandDataSource *QWaylandDataDeviceManager::dragSource() const
+{
+    return m_drag_data_source;
+}
+
 void QWaylandDataDeviceManager::cancelDrag()
 {
-    wl_data_source_destroy(m_drag_data_source->handle() );
+    delete m_drag_data_source;
     m_drag_data_source = 0;
+    if (m_drag_surface) {
+        wl_surface_destroy(m_drag_surface);
+        m_drag_surface = 0;
+    }
+    delete m_drag_buffer;
+    m_drag_buffer = 0;
 }
 
 void QWaylandDataDeviceManager::createAndSetSelectionSource(QMimeData *mimeData, QClipboard::Mode mode)
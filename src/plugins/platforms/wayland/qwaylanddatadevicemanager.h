@@ -69,6 +69,7 @@ public:
     void createAndSetDrag(QDrag *drag);
     QMimeData *dragMime() const;
     bool canDropDrag() const;
+    QWaylandDataSource *dragSource() const;
     void cancelDrag();
 
     void createAndSetSelectionSource(QMimeData *mimeData, QClipboard::Mode mode);
@@ -79,6 +80,8 @@ public:
     struct wl_data_device_manager *handle() const;
 
 private:
+    void handleDragMotion();
+
     struct wl_data_device_manager *m_data_device_manager;
     QWaylandDisplay *m_display;
 
@@ -91,6 +94,7 @@ private:
     struct wl_surface *m_drag_surface;
     QWaylandShmBuffer *m_drag_buffer;
     bool m_drag_can_drop;
+    QByteArray m_drag_accepted_type;
     uint32_t m_drag_last_event_time;
     QPoint m_drag_position;
 
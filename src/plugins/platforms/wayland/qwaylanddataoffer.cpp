@@ -46,6 +46,34 @@
 #include <QtGui/QPlatformClipboard>
 
 #include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QSocketNotifier>
+#include <QtCore/private/qcore_unix_p.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+
+static const int readChunkSize = 64 * 1024;
+
+// Reads whatever the pipe holds without blocking. Returns 1 at the end of
+// the data, 0 when more is to come and -1 on errors.
+static int readAvailable(int fd, QByteArray *data)
+{
+    for (;;) {
+        int available = 0;
+        if (ioctl(fd, FIONREAD, &available) == -1 || available <= 0)
+            available = readChunkSize;
+        const int size = data->size();
+        data->resize(size + available);
+        int n = QT_READ(fd, data->data() + size, available);
+        data->resize(size + qMax(n, 0));
+        if (n == 0)
+            return 1;
+        if (n == -1)
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+}
 
 
 void QWaylandDataOffer::offer_sync_callback(void *data,
@@ -88,7 +116,15 @@ const struct wl_data_offer_listener QWaylandDataOffer::data_offer_listener = {
 QWaylandDataOffer::QWaylandDataOffer(QWaylandDisplay *display, struct wl_data_offer *data_offer)
     : m_display(display)
     , m_receiving_offers(false)
+    , m_timeout(3000)
+    , m_prefetch(qgetenv("QT_WAYLAND_CLIPBOARD_PREFETCH").toInt())
+    , m_dead(false)
 {
+    QByteArray timeout = qgetenv("QT_WAYLAND_CLIPBOARD_TIMEOUT");
+    if (!timeout.isEmpty())
+        m_timeout = timeout.toInt();
+    m_prefetchTimer.setSingleShot(true);
+    connect(&m_prefetchTimer, SIGNAL(timeout()), this, SLOT(abortTransfers()));
     m_data_offer = data_offer;
     wl_data_offer_set_user_data(m_data_offer,this);
     wl_data_offer_add_listener(m_data_offer,&data_offer_listener,this);
@@ -96,9 +132,21 @@ QWaylandDataOffer::QWaylandDataOffer(QWaylandDisplay *display, struct wl_data_of
 
 QWaylandDataOffer::~QWaylandDataOffer()
 {
+    abortTransfers();
     wl_data_offer_destroy(m_data_offer);
 }
 
+// Closing the pipes tells the source to stop sending
+void QWaylandDataOffer::abortTransfers() const
+{
+    QHash<int, Transfer>::const_iterator it = m_transfers.constBegin();
+    for (; it != m_transfers.constEnd(); ++it) {
+        delete it->notifier;
+        close(it.key());
+    }
+    m_transfers.clear();
+}
+
 bool QWaylandDataOffer::hasFormat_sys(const QString &mimeType) const
 {
     return m_offered_mime_types.contains(mimeType);
@@ -109,32 +157,129 @@ QStringList QWaylandDataOffer::formats_sys() const
     return m_offered_mime_types;
 }
 
-QVariant QWaylandDataOffer::retrieveData_sys(const QString &mimeType, QVariant::Type type) const
+// Asks the source for \a mimeType and returns the read end of the pipe it
+// writes to, or -1.
+int QWaylandDataOffer::startReceive(const QString &mimeType) const
 {
-    Q_UNUSED(type);
-    if (m_offered_mime_types.isEmpty())
-        return QVariant();
-
     int pipefd[2];
     if (pipe(pipefd) == -1) {
         qWarning("QWaylandMimeData: pipe() failed");
-        return QVariant();
+        return -1;
     }
+    fcntl(pipefd[0], F_SETFL, fcntl(pipefd[0], F_GETFL, 0) | O_NONBLOCK);
 
     QByteArray mimeTypeBa = mimeType.toLatin1();
     wl_data_offer_receive(m_data_offer,mimeTypeBa.constData(),pipefd[1]);
-
-    m_display->forceRoundTrip();
+    // The request only has to reach the compositor, there is no reply to
+    // wait for: the data comes through the pipe.
+    m_display->flushRequests();
     close(pipefd[1]);
+    return pipefd[0];
+}
+
+// Starts transferring the text types right away, so that a paste usually
+// finds the data already there. Only done for the selection and when
+// QT_WAYLAND_CLIPBOARD_PREFETCH is set.
+void QWaylandDataOffer::startPrefetch()
+{
+    if (!m_prefetch)
+        return;
 
+    static const char *prefetchTypes[] = {
+        "text/plain;charset=utf-8",
+        "text/plain",
+        "text/uri-list",
+        "text/html"
+    };
+    for (uint i = 0; i < sizeof(prefetchTypes) / sizeof(prefetchTypes[0]); ++i) {
+        QString mimeType = QString::fromLatin1(prefetchTypes[i]);
+        if (!m_offered_mime_types.contains(mimeType) || m_received.contains(mimeType))
+            continue;
+        int fd = startReceive(mimeType);
+        if (fd == -1)
+            return;
+        Transfer transfer;
+        transfer.mimeType = mimeType.toLatin1();
+        transfer.notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+        connect(transfer.notifier, SIGNAL(activated(int)), SLOT(readPrefetched(int)));
+        m_transfers.insert(fd, transfer);
+    }
+
+    // Prefetches get the same time as a paste, a source still sending
+    // after that is not waited for
+    if (!m_transfers.isEmpty())
+        m_prefetchTimer.start(m_timeout);
+}
+
+void QWaylandDataOffer::readPrefetched(int fd)
+{
+    QHash<int, Transfer>::iterator it = m_transfers.find(fd);
+    if (it == m_transfers.end())
+        return;
+
+    int status = readAvailable(fd, &it->data);
+    if (status == 0)
+        return;
+
+    if (status == 1)
+        m_received.insert(QString::fromLatin1(it->mimeType), it->data);
+    delete it->notifier;
+    m_transfers.erase(it);
+    close(fd);
+    if (m_transfers.isEmpty())
+        m_prefetchTimer.stop();
+}
+
+QVariant QWaylandDataOffer::retrieveData_sys(const QString &mimeType, QVariant::Type type) const
+{
+    Q_UNUSED(type);
+    if (m_offered_mime_types.isEmpty() || m_dead)
+        return QVariant();
+
+    QHash<QString, QByteArray>::const_iterator received = m_received.constFind(mimeType);
+    if (received != m_received.constEnd())
+        return received.value();
+
+    // Continue a prefetch of this type if there is one
+    int fd = -1;
     QByteArray content;
-    char buf[256];
-    int n;
-    while ((n = QT_READ(pipefd[0], &buf, sizeof buf)) > 0) {
-        content.append(buf, n);
+    QHash<int, Transfer>::iterator it = m_transfers.begin();
+    for (; it != m_transfers.end(); ++it) {
+        if (it->mimeType == mimeType.toLatin1()) {
+            fd = it.key();
+            content = it->data;
+            delete it->notifier;
+            m_transfers.erase(it);
+            break;
+        }
     }
+    if (fd == -1)
+        fd = startReceive(mimeType);
+    if (fd == -1)
+        return QVariant();
+
+    // Wait for the data, but not forever: a hung source must not take this
+    // application down with it.
+    QElapsedTimer timer;
+    timer.start();
+    int status;
+    while ((status = readAvailable(fd, &content)) == 0) {
+        int remaining = m_timeout - int(timer.elapsed());
+        if (remaining <= 0) {
+            qWarning("QWaylandMimeData: timed out receiving %s", qPrintable(mimeType));
+            // Other types would most likely time out as well
+            m_dead = true;
+            abortTransfers();
+            break;
+        }
+        pollfd pfd = { fd, POLLIN, 0 };
+        ::poll(&pfd, 1, remaining);
+    }
+    close(fd);
 
-    close(pipefd[0]);
+    if (status != 1)
+        return QVariant();
+    m_received.insert(mimeType, content);
     return content;
 }
 
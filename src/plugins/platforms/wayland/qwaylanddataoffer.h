@@ -44,7 +44,9 @@
 
 #include <QString>
 #include <QByteArray>
+#include <QHash>
 #include <QMimeData>
+#include <QTimer>
 
 #include <QtGui/private/qdnd_p.h>
 #include <QtGui/QClipboard>
@@ -52,9 +54,11 @@
 #include <stdint.h>
 
 class QWaylandDisplay;
+class QSocketNotifier;
 
 class QWaylandDataOffer : public QInternalMimeData
 {
+    Q_OBJECT
 public:
     QWaylandDataOffer(QWaylandDisplay *display, struct wl_data_offer *offer);
     ~QWaylandDataOffer();
@@ -64,12 +68,36 @@ public:
     QVariant retrieveData_sys(const QString &mimeType, QVariant::Type type) const;
 
     struct wl_data_offer *handle() const;
+
+    void startPrefetch();
+
+private slots:
+    void readPrefetched(int fd);
+    void abortTransfers() const;
+
 private:
+    struct Transfer {
+        QByteArray mimeType;
+        QByteArray data;
+        QSocketNotifier *notifier;
+    };
+
+    int startReceive(const QString &mimeType) const;
 
     struct wl_data_offer *m_data_offer;
     QWaylandDisplay *m_display;
     QStringList m_offered_mime_types;
     bool m_receiving_offers;
+    int m_timeout;
+    bool m_prefetch;
+    QTimer m_prefetchTimer;
+    // Set once the source failed to deliver in time, it is not asked again
+    mutable bool m_dead;
+
+    // Data already received, an offer never changes its content
+    mutable QHash<QString, QByteArray> m_received;
+    // Prefetches still in progress, keyed by the read end of their pipe
+    mutable QHash<int, Transfer> m_transfers;
 
     static void offer(void *data, struct wl_data_offer *wl_data_offer, const char *type);
     static const struct wl_data_offer_listener data_offer_listener;
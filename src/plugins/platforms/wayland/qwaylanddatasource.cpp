@@ -52,9 +52,10 @@ void QWaylandDataSource::data_source_target(void *data,
                struct wl_data_source *wl_data_source,
                const char *mime_type)
 {
-    Q_UNUSED(data);
     Q_UNUSED(wl_data_source);
-    Q_UNUSED(mime_type);
+    QWaylandDataSource *self = static_cast<QWaylandDataSource *>(data);
+    self->m_accepted_type = QString::fromLatin1(mime_type);
+    emit self->targetChanged();
 }
 
 void QWaylandDataSource::data_source_send(void *data,
@@ -65,7 +66,24 @@ void QWaylandDataSource::data_source_send(void *data,
     Q_UNUSED(wl_data_source);
     QWaylandDataSource *self = static_cast<QWaylandDataSource *>(data);
     QString mimeType = QString::fromLatin1(mime_type);
-    QByteArray content = QWaylandMimeHelper::getByteArray(self->m_mime_data, mimeType);
+    emit self->sendRequested();
+    // Every receiver after the first gets the bytes encoded for the first
+    QByteArray content;
+    if (self->m_conversions.lookup(mimeType, &content))
+        self->send(fd, content);
+    else
+        self->m_waitingSends.insert(mimeType, fd);
+}
+
+void QWaylandDataSource::converted(const QString &mimeType, const QByteArray &content)
+{
+    foreach (int fd, m_waitingSends.values(mimeType))
+        send(fd, content);
+    m_waitingSends.remove(mimeType);
+}
+
+void QWaylandDataSource::send(int fd, const QByteArray &content)
+{
     if (!content.isEmpty()) {
         QFile f;
         if (f.open(fd, QIODevice::WriteOnly))
@@ -77,8 +95,9 @@ void QWaylandDataSource::data_source_send(void *data,
 void QWaylandDataSource::data_source_cancelled(void *data,
                struct wl_data_source *wl_data_source)
 {
-    Q_UNUSED(data);
     Q_UNUSED(wl_data_source);
+    QWaylandDataSource *self = static_cast<QWaylandDataSource *>(data);
+    emit self->cancelled();
 }
 
 const struct wl_data_source_listener QWaylandDataSource::data_source_listener = {
@@ -90,6 +109,9 @@ const struct wl_data_source_listener QWaylandDataSource::data_source_listener =
 QWaylandDataSource::QWaylandDataSource(QWaylandDataDeviceManager *dndSelectionHandler, QMimeData *mimeData)
     : m_mime_data(mimeData)
 {
+    m_conversions.setMimeData(mimeData);
+    connect(&m_conversions, SIGNAL(converted(QString,QByteArray)), SLOT(converted(QString,QByteArray)));
+
     m_data_source = wl_data_device_manager_create_data_source(dndSelectionHandler->handle());
     wl_data_source_add_listener(m_data_source,&data_source_listener,this);
     QStringList formats = mimeData->formats();
@@ -101,6 +123,8 @@ QWaylandDataSource::QWaylandDataSource(QWaylandDataDeviceManager *dndSelectionHa
 
 QWaylandDataSource::~QWaylandDataSource()
 {
+    foreach (int fd, m_waitingSends)
+        close(fd);
     wl_data_source_destroy(m_data_source);
 }
 
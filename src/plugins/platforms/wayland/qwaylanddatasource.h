@@ -43,11 +43,15 @@
 #define QWAYLANDDATASOURCE_H
 
 #include "qwaylanddatadevicemanager.h"
+#include "qwaylandmimehelper.h"
+
+#include <QtCore/QMultiHash>
 
 #include <wayland-client-protocol.h>
 
-class QWaylandDataSource
+class QWaylandDataSource : public QObject
 {
+    Q_OBJECT
 public:
     QWaylandDataSource(QWaylandDataDeviceManager *dndSelectionHandler, QMimeData *mimeData);
     ~QWaylandDataSource();
@@ -55,10 +59,27 @@ public:
     QMimeData *mimeData() const;
 
     struct wl_data_source *handle() const;
+
+    QString acceptedType() const { return m_accepted_type; }
+
+signals:
+    void cancelled();
+    void sendRequested();
+    void targetChanged();
+
+private slots:
+    void converted(const QString &mimeType, const QByteArray &content);
+
 private:
+    void send(int fd, const QByteArray &content);
+
     struct wl_data_source *m_data_source;
     QWaylandDisplay *m_display;
     QMimeData *m_mime_data;
+    QString m_accepted_type;
+    QWaylandMimeCache m_conversions;
+    // Requests waiting for their type to be converted
+    QMultiHash<QString, int> m_waitingSends;
 
     static void data_source_target(void *data,
                    struct wl_data_source *data_source,
@@ -61,8 +61,10 @@
 #include "qwaylandextendedsurface.h"
 #include "qwaylandsubsurface.h"
 #include "qwaylandtouch.h"
+#include "qwaylandlatencyprobe.h"
 
 #include <QtCore/QAbstractEventDispatcher>
+#include <QtCore/QElapsedTimer>
 #include <QtGui/private/qguiapplication_p.h>
 
 #include <unistd.h>
@@ -82,6 +84,16 @@ struct wl_surface *QWaylandDisplay::createSurface(void *handle)
 #ifdef QT_WAYLAND_GL_SUPPORT
 QWaylandGLIntegration * QWaylandDisplay::eglIntegration()
 {
+    // EGL display setup is expensive and not needed by raster-only
+    // applications, so it is postponed until the first GL window/context.
+    if (!mEglIntegrationInitialized) {
+        QElapsedTimer timer;
+        timer.start();
+        mEglIntegration->initialize();
+        mEglIntegrationInitialized = true;
+        if (mDebugStartup)
+            qDebug() << "QWaylandDisplay: GL integration initialized in" << timer.elapsed() << "ms";
+    }
     return mEglIntegration;
 }
 #endif
@@ -118,16 +130,27 @@ QWaylandDisplay::QWaylandDisplay(void)
     , mSubSurfaceExtension(0)
     , mOutputExtension(0)
     , mTouchExtension(0)
+    , mDebugStartup(!qgetenv("QT_WAYLAND_DEBUG_STARTUP").isEmpty())
+    , mLatencyProbe(qgetenv("QT_WAYLAND_LATENCY_PROBE").isEmpty() ? 0 : new QWaylandLatencyProbe)
+#ifdef QT_WAYLAND_GL_SUPPORT
+    , mEglIntegrationInitialized(false)
+#endif
 {
     display = this;
     qRegisterMetaType<uint32_t>("uint32_t");
 
+    QElapsedTimer timer;
+    timer.start();
+
     mDisplay = wl_display_connect(NULL);
     if (mDisplay == NULL) {
         qErrnoWarning(errno, "Failed to create display");
         qFatal("No wayland connection available.");
     }
 
+    if (mDebugStartup)
+        qDebug() << "QWaylandDisplay: connected in" << timer.restart() << "ms";
+
     wl_display_add_global_listener(mDisplay, QWaylandDisplay::displayHandleGlobal, this);
 
     mFd = wl_display_get_fd(mDisplay, dummyUpdate, 0);
@@ -152,17 +175,22 @@ QWaylandDisplay::QWaylandDisplay(void)
     mWindowManagerIntegration = QWaylandWindowManagerIntegration::createIntegration(this);
 #endif
 
-    blockingReadEvents();
+    // A single roundtrip guarantees that every global announced by the
+    // compositor has been delivered and bound.
+    forceRoundTrip();
 
-#ifdef QT_WAYLAND_GL_SUPPORT
-    mEglIntegration->initialize();
-#endif
+    if (mDebugStartup)
+        qDebug() << "QWaylandDisplay: globals received in" << timer.restart() << "ms";
 
     waitForScreens();
+
+    if (mDebugStartup)
+        qDebug() << "QWaylandDisplay:" << mScreens.size() << "screen(s) ready in" << timer.elapsed() << "ms";
 }
 
 QWaylandDisplay::~QWaylandDisplay(void)
 {
+    delete mLatencyProbe;
 #ifdef QT_WAYLAND_GL_SUPPORT
     delete mEglIntegration;
 #endif
@@ -177,6 +205,8 @@ void QWaylandDisplay::createNewScreen(struct wl_output *output, QRect geometry)
 
 void QWaylandDisplay::flushRequests()
 {
+    if (mWindowExtension)
+        mWindowExtension->flushPendingProperties();
     wl_display_flush(mDisplay);
 }
 
@@ -203,11 +233,20 @@ void QWaylandDisplay::readEvents()
     }
 
     wl_display_iterate(mDisplay, WL_DISPLAY_READABLE);
+    flushPendingMotion();
 }
 
 void QWaylandDisplay::blockingReadEvents()
 {
     wl_display_iterate(mDisplay, WL_DISPLAY_READABLE);
+    flushPendingMotion();
+}
+
+void QWaylandDisplay::flushPendingMotion()
+{
+    // Deliver what is left of the motion compressed during this read
+    for (int i = 0; i < mInputDevices.size(); ++i)
+        mInputDevices.at(i)->flushPendingMotion();
 }
 
 QWaylandScreen *QWaylandDisplay::screenForOutput(struct wl_output *output) const
@@ -233,7 +272,11 @@ void QWaylandDisplay::outputHandleGeometry(void *data,
     Q_UNUSED(model);
     QWaylandDisplay *waylandDisplay = static_cast<QWaylandDisplay *>(data);
     QRect outputRect = QRect(x, y, physicalWidth, physicalHeight);
-    waylandDisplay->createNewScreen(output,outputRect);
+    // The compositor sends the geometry again when an output changes
+    if (QWaylandScreen *screen = waylandDisplay->screenForOutput(output))
+        screen->setGeometry(outputRect);
+    else
+        waylandDisplay->createNewScreen(output,outputRect);
 }
 
 void QWaylandDisplay::mode(void *data,
@@ -243,12 +286,13 @@ void QWaylandDisplay::mode(void *data,
              int height,
              int refresh)
 {
-    Q_UNUSED(data);
-    Q_UNUSED(wl_output);
-    Q_UNUSED(flags);
     Q_UNUSED(width);
     Q_UNUSED(height);
-    Q_UNUSED(refresh);
+    if (!(flags & WL_OUTPUT_MODE_CURRENT))
+        return;
+    QWaylandDisplay *waylandDisplay = static_cast<QWaylandDisplay *>(data);
+    if (QWaylandScreen *screen = waylandDisplay->screenForOutput(wl_output))
+        screen->setRefreshRate(refresh);
 }
 
 const struct wl_output_listener QWaylandDisplay::outputListener = {
@@ -258,6 +302,11 @@ const struct wl_output_listener QWaylandDisplay::outputListener = {
 
 void QWaylandDisplay::waitForScreens()
 {
+    // The output geometry is sent in response to binding wl_output, so
+    // one more roundtrip collects it for all outputs at once.
+    if (mScreens.isEmpty())
+        forceRoundTrip();
+
     flushRequests();
     while (mScreens.isEmpty())
         blockingReadEvents();
@@ -297,7 +346,7 @@ void QWaylandDisplay::displayHandleGlobal(uint32_t id,
     } else if (interface == "wl_output_extension") {
         mOutputExtension = new QWaylandOutputExtension(this,id);
     } else if (interface == "wl_surface_extension") {
-        mWindowExtension = new QWaylandSurfaceExtension(this,id);
+        mWindowExtension = new QWaylandSurfaceExtension(this,id,version);
     } else if (interface == "wl_sub_surface_extension") {
         mSubSurfaceExtension = new QWaylandSubSurfaceExtension(this,id);
     } else if (interface == "wl_touch_extension") {
@@ -318,5 +367,6 @@ uint32_t QWaylandDisplay::currentTimeMillisec()
 void QWaylandDisplay::forceRoundTrip()
 {
     wl_display_roundtrip(mDisplay);
+    flushPendingMotion();
 }
 
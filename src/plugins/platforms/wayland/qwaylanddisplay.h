@@ -63,6 +63,7 @@ class QWaylandSurfaceExtension;
 class QWaylandSubSurfaceExtension;
 class QWaylandOutputExtension;
 class QWaylandTouchExtension;
+class QWaylandLatencyProbe;
 
 class QWaylandDisplay : public QObject {
     Q_OBJECT
@@ -103,6 +104,9 @@ public:
     QWaylandOutputExtension *outputExtension() const { return mOutputExtension; }
     QWaylandTouchExtension *touchExtension() const { return mTouchExtension; }
 
+    bool debugStartup() const { return mDebugStartup; }
+    QWaylandLatencyProbe *latencyProbe() const { return mLatencyProbe; }
+
     struct wl_shm *shm() const { return mShm; }
 
     static uint32_t currentTimeMillisec();
@@ -116,6 +120,7 @@ public slots:
 
 private:
     void waitForScreens();
+    void flushPendingMotion();
     void displayHandleGlobal(uint32_t id,
                              const QByteArray &interface,
                              uint32_t version);
@@ -137,6 +142,8 @@ private:
     int mFd;
     int mWritableNotificationFd;
     bool mScreensInitialized;
+    bool mDebugStartup;
+    QWaylandLatencyProbe *mLatencyProbe;
 
     static const struct wl_output_listener outputListener;
     static void displayHandleGlobal(struct wl_display *display,
@@ -159,6 +166,7 @@ private:
 
 #ifdef QT_WAYLAND_GL_SUPPORT
     QWaylandGLIntegration *mEglIntegration;
+    bool mEglIntegrationInitialized;
 #endif
 
 #ifdef QT_WAYLAND_WINDOWMANAGER_SUPPORT
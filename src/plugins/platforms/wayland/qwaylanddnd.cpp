@@ -42,9 +42,22 @@
 #include "qwaylanddnd.h"
 
 #include "qwaylanddatadevicemanager.h"
+#include "qwaylanddatasource.h"
+
+#include <QtCore/QEventLoop>
+#include <QtCore/QTimer>
+
+// Longer than the compositor's own grace period after a drop, this only
+// catches a compositor that never ends the drag
+static const int dragFinishTimeout = 10000;
+// A drag the compositor never answers at all, e.g. because it was started
+// on a seat that does not have the pointer, is given up after this long
+// without any target change
+static const int dragIdleTimeout = 60000;
 
 QWaylandDrag::QWaylandDrag(QWaylandDisplay *display)
     : m_display(display)
+    , m_executedDropAction(Qt::IgnoreAction)
 {
 
 }
@@ -59,10 +72,40 @@ QMimeData * QWaylandDrag::platformDropData()
     return m_display->dndSelectionHandler()->dragMime();
 }
 
-Qt::DropAction QWaylandDrag::drag(QDrag *m_drag)
+Qt::DropAction QWaylandDrag::drag(QDrag *drag)
 {
-//    m_display->dndSelectionHandler()->createAndSetDrag(drag);
-    return Qt::IgnoreAction;
+    m_executedDropAction = Qt::IgnoreAction;
+    QWaylandDataDeviceManager *handler = m_display->dndSelectionHandler();
+    if (!handler)
+        return m_executedDropAction;
+
+    handler->createAndSetDrag(drag);
+
+    // The mime data belongs to the QDrag, so it has to stay around until
+    // the compositor says the target is done with it
+    QEventLoop loop;
+    QObject::connect(handler->dragSource(), SIGNAL(cancelled()), &loop, SLOT(quit()));
+    QObject::connect(handler->dragSource(), SIGNAL(destroyed()), &loop, SLOT(quit()));
+    // Transfers only start once dropped, so the first one arms the timeout
+    QTimer finishTimer;
+    finishTimer.setSingleShot(true);
+    finishTimer.setInterval(dragFinishTimeout);
+    QObject::connect(handler->dragSource(), SIGNAL(sendRequested()), &finishTimer, SLOT(start()));
+    QObject::connect(&finishTimer, SIGNAL(timeout()), &loop, SLOT(quit()));
+    QTimer idleTimer;
+    idleTimer.setSingleShot(true);
+    idleTimer.setInterval(dragIdleTimeout);
+    QObject::connect(handler->dragSource(), SIGNAL(targetChanged()), &idleTimer, SLOT(start()));
+    QObject::connect(handler->dragSource(), SIGNAL(sendRequested()), &idleTimer, SLOT(stop()));
+    QObject::connect(&idleTimer, SIGNAL(timeout()), &loop, SLOT(quit()));
+    idleTimer.start();
+    loop.exec();
+
+    QWaylandDataSource *source = handler->dragSource();
+    if (source && !source->acceptedType().isEmpty())
+        m_executedDropAction = Qt::CopyAction;
+    handler->cancelDrag();
+    return m_executedDropAction;
 }
 
 void QWaylandDrag::move(const QMouseEvent *me)
@@ -88,5 +131,5 @@ void QWaylandDrag::cancel()
 
 Qt::DropAction QWaylandDrag::executedDropAction() const
 {
-    return Qt::CopyAction;
+    return m_executedDropAction;
 }
@@ -55,7 +55,7 @@ public:
 
     QMimeData *platformDropData();
 
-    Qt::DropAction drag(QDrag *m_drag);
+    Qt::DropAction drag(QDrag *drag);
     void move(const QMouseEvent *me);
     bool canDrop() const;
     void drop(const QMouseEvent *me);
@@ -65,6 +65,7 @@ public:
 
 private:
     QWaylandDisplay *m_display;
+    Qt::DropAction m_executedDropAction;
 };
 
 #endif // QWAYLANDDND_H
@@ -52,8 +52,10 @@
 
 #include <QtGui/QGuiApplication>
 #include <QtGui/QPlatformNativeInterface>
+#include <QtCore/QVector>
 
-QWaylandSurfaceExtension::QWaylandSurfaceExtension(QWaylandDisplay *display, uint32_t id)
+QWaylandSurfaceExtension::QWaylandSurfaceExtension(QWaylandDisplay *display, uint32_t id, uint32_t version)
+    : m_version(qMin<uint32_t>(version, wl_surface_extension_interface.version))
 {
     m_surface_extension = static_cast<struct wl_surface_extension *>(
                 wl_display_bind(display->wl_display(),id, &wl_surface_extension_interface));
@@ -66,20 +68,65 @@ QWaylandExtendedSurface *QWaylandSurfaceExtension::getExtendedWindow(QWaylandWin
     struct wl_extended_surface *extended_surface =
             wl_surface_extension_get_extended_surface(m_surface_extension,surface);
 
-    return new QWaylandExtendedSurface(window,extended_surface);
+    return new QWaylandExtendedSurface(window,this,extended_surface);
 }
 
+// Property changes made while the event loop is busy go out as one batch
+// per window, before the display flushes its requests.
+void QWaylandSurfaceExtension::schedulePropertyFlush(QWaylandExtendedSurface *surface)
+{
+    if (!m_pendingSurfaces.contains(surface))
+        m_pendingSurfaces.append(surface);
+}
 
-QWaylandExtendedSurface::QWaylandExtendedSurface(QWaylandWindow *window, struct wl_extended_surface *extended_surface)
+void QWaylandSurfaceExtension::unschedulePropertyFlush(QWaylandExtendedSurface *surface)
+{
+    m_pendingSurfaces.removeOne(surface);
+}
+
+void QWaylandSurfaceExtension::flushPendingProperties()
+{
+    QList<QWaylandExtendedSurface *> pending = m_pendingSurfaces;
+    m_pendingSurfaces.clear();
+    for (int i = 0; i < pending.size(); ++i)
+        pending.at(i)->flushPendingProperties();
+}
+
+
+QWaylandExtendedSurface::QWaylandExtendedSurface(QWaylandWindow *window, QWaylandSurfaceExtension *extension,
+                                                 struct wl_extended_surface *extended_surface)
     : m_window(window)
+    , m_extension(extension)
     , m_extended_surface(extended_surface)
 {
     wl_extended_surface_add_listener(m_extended_surface,&QWaylandExtendedSurface::extended_surface_listener,this);
 }
 
+QWaylandExtendedSurface::~QWaylandExtendedSurface()
+{
+    m_extension->unschedulePropertyFlush(this);
+}
+
 void QWaylandExtendedSurface::updateGenericProperty(const QString &name, const QVariant &value)
 {
+    QVariantMap::const_iterator it = m_properties.constFind(name);
+    if (it != m_properties.constEnd() && it.value() == value)
+        return;
+
+    if (m_extension->version() >= 2) {
+        if (!m_pendingProperties.contains(name))
+            m_pendingProperties.append(name);
+        m_extension->schedulePropertyFlush(this);
+        propertyChanged(name, value);
+        return;
+    }
 
+    sendGenericProperty(name, value);
+    propertyChanged(name, value);
+}
+
+void QWaylandExtendedSurface::sendGenericProperty(const QString &name, const QVariant &value)
+{
     QByteArray byteValue;
     QDataStream ds(&byteValue, QIODevice::WriteOnly);
     ds << value;
@@ -90,7 +137,45 @@ void QWaylandExtendedSurface::updateGenericProperty(const QString &name, const Q
     data.alloc = 0;
 
     wl_extended_surface_update_generic_property(m_extended_surface,qPrintable(name),&data);
+}
+
+void QWaylandExtendedSurface::flushPendingProperties()
+{
+    if (m_pendingProperties.isEmpty())
+        return;
+    m_extension->unschedulePropertyFlush(this);
+
+    // Properties too large for a batch go out on their own
+    foreach (const QString &name, m_pendingProperties) {
+        const QVariant value = m_properties.value(name);
+        if (!m_propertyEncoder.add(name, value))
+            sendGenericProperty(name, value);
+    }
+    m_pendingProperties.clear();
+
+    foreach (const QByteArray &batch, m_propertyEncoder.takeBatches()) {
+        wl_array data;
+        data.size = batch.size();
+        data.data = (void*)batch.constData();
+        data.alloc = 0;
+        wl_extended_surface_update_generic_properties(m_extended_surface, &data);
+    }
+}
+
+// A change from the compositor that crossed one of ours that did not go out
+// yet is ignored, ours is sent instead unless both are the same.
+void QWaylandExtendedSurface::propertyReceived(const QString &name, const QVariant &value)
+{
+    if (m_pendingProperties.contains(name)) {
+        if (m_properties.value(name) == value)
+            m_pendingProperties.removeOne(name);
+        return;
+    }
+    propertyChanged(name, value);
+}
 
+void QWaylandExtendedSurface::propertyChanged(const QString &name, const QVariant &value)
+{
     m_properties.insert(name,value);
     QWaylandNativeInterface *nativeInterface = static_cast<QWaylandNativeInterface *>(
                 QGuiApplication::platformNativeInterface());
@@ -118,11 +203,6 @@ void QWaylandExtendedSurface::setContentOrientation(Qt::ScreenOrientation orient
     wl_extended_surface_set_content_orientation(m_extended_surface, waylandRotationFromScreenOrientation(orientation));
 }
 
-QVariantMap QWaylandExtendedSurface::properties() const
-{
-    return m_properties;
-}
-
 QVariant QWaylandExtendedSurface::property(const QString &name)
 {
     return m_properties.value(name);
@@ -154,12 +234,21 @@ void QWaylandExtendedSurface::set_generic_property(void *data, wl_extended_surfa
     QDataStream ds(&baValue, QIODevice::ReadOnly);
     ds >> variantValue;
 
-    QString qstring_name = QString::fromLatin1(name);
-    extended_window->m_properties.insert(qstring_name,variantValue);
+    extended_window->propertyReceived(QString::fromLatin1(name), variantValue);
+}
 
-    QWaylandNativeInterface *nativeInterface = static_cast<QWaylandNativeInterface *>(
-                QGuiApplication::platformNativeInterface());
-    nativeInterface->emitWindowPropertyChanged(extended_window->m_window,QString::fromLatin1(name));
+void QWaylandExtendedSurface::set_generic_properties(void *data, wl_extended_surface *wl_extended_surface, wl_array *batch)
+{
+    Q_UNUSED(wl_extended_surface);
+
+    QWaylandExtendedSurface *extended_window = static_cast<QWaylandExtendedSurface *>(data);
+
+    QWaylandPropertyDecoder::PropertyList properties;
+    if (!extended_window->m_propertyDecoder.decode(batch->data, batch->size, &properties))
+        qWarning("QWaylandExtendedSurface: malformed property batch from the compositor");
+
+    for (int i = 0; i < properties.size(); ++i)
+        extended_window->propertyReceived(properties.at(i).first, properties.at(i).second);
 }
 
 Qt::WindowFlags QWaylandExtendedSurface::setWindowFlags(Qt::WindowFlags flags)
@@ -176,7 +265,34 @@ Qt::WindowFlags QWaylandExtendedSurface::setWindowFlags(Qt::WindowFlags flags)
                    );
 }
 
+// Both need version 2 of the extension, older compositors always deliver
+// input to the whole surface
+void QWaylandExtendedSurface::setInputRegion(const QRegion &region)
+{
+    if (m_extension->version() < 2)
+        return;
+
+    QVector<int32_t> rects;
+    foreach (const QRect &rect, region.rects())
+        rects << rect.x() << rect.y() << rect.width() << rect.height();
+
+    wl_array data;
+    data.size = rects.size() * sizeof(int32_t);
+    data.data = (void*)rects.constData();
+    data.alloc = 0;
+
+    wl_extended_surface_set_input_region(m_extended_surface, &data);
+}
+
+void QWaylandExtendedSurface::resetInputRegion()
+{
+    if (m_extension->version() < 2)
+        return;
+    wl_extended_surface_reset_input_region(m_extended_surface);
+}
+
 const struct wl_extended_surface_listener QWaylandExtendedSurface::extended_surface_listener = {
     QWaylandExtendedSurface::onscreen_visibility,
-    QWaylandExtendedSurface::set_generic_property
+    QWaylandExtendedSurface::set_generic_property,
+    QWaylandExtendedSurface::set_generic_properties
 };
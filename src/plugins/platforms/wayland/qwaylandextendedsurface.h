@@ -45,7 +45,11 @@
 #include <wayland-client.h>
 
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 #include <QtCore/QVariant>
+#include <QtGui/QRegion>
+
+#include "qwaylandpropertybatch.h"
 
 class QWaylandDisplay;
 class QWaylandWindow;
@@ -54,33 +58,56 @@ class QWaylandExtendedSurface;
 class QWaylandSurfaceExtension
 {
 public:
-    QWaylandSurfaceExtension(QWaylandDisplay *display, uint32_t id);
+    QWaylandSurfaceExtension(QWaylandDisplay *display, uint32_t id, uint32_t version);
 
     QWaylandExtendedSurface *getExtendedWindow(QWaylandWindow *window);
+
+    uint32_t version() const { return m_version; }
+
+    void schedulePropertyFlush(QWaylandExtendedSurface *surface);
+    void unschedulePropertyFlush(QWaylandExtendedSurface *surface);
+    void flushPendingProperties();
+
 private:
     struct wl_surface_extension *m_surface_extension;
+    uint32_t m_version;
+    QList<QWaylandExtendedSurface *> m_pendingSurfaces;
 };
 
 class QWaylandExtendedSurface
 {
 public:
-    QWaylandExtendedSurface(QWaylandWindow *window, struct wl_extended_surface *extended_surface);
+    QWaylandExtendedSurface(QWaylandWindow *window, QWaylandSurfaceExtension *extension,
+                            struct wl_extended_surface *extended_surface);
+    ~QWaylandExtendedSurface();
 
     void setWindowOrientation(Qt::ScreenOrientation orientation);
     void setContentOrientation(Qt::ScreenOrientation orientation);
 
     void updateGenericProperty(const QString &name, const QVariant &value);
-    QVariantMap properties() const;
+    void flushPendingProperties();
+    const QVariantMap &properties() const { return m_properties; }
     QVariant property(const QString &name);
     QVariant property(const QString &name, const QVariant &defaultValue);
 
     Qt::WindowFlags setWindowFlags(Qt::WindowFlags flags);
 
+    void setInputRegion(const QRegion &region);
+    void resetInputRegion();
+
 private:
     QWaylandWindow *m_window;
+    QWaylandSurfaceExtension *m_extension;
     struct wl_extended_surface *m_extended_surface;
 
     QVariantMap m_properties;
+    QStringList m_pendingProperties;
+    QWaylandPropertyEncoder m_propertyEncoder;
+    QWaylandPropertyDecoder m_propertyDecoder;
+
+    void sendGenericProperty(const QString &name, const QVariant &value);
+    void propertyReceived(const QString &name, const QVariant &value);
+    void propertyChanged(const QString &name, const QVariant &value);
 
     static void onscreen_visibility(void *data,
                                 struct wl_extended_surface *wl_extended_surface,
@@ -91,6 +118,10 @@ private:
                                  const char *name,
                                  struct wl_array *value);
 
+    static void set_generic_properties(void *data,
+                                       struct wl_extended_surface *wl_extended_surface,
+                                       struct wl_array *batch);
+
     static const struct wl_extended_surface_listener extended_surface_listener;
 
 };
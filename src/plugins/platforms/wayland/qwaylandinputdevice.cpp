@@ -46,6 +46,8 @@
 #include "qwaylandbuffer.h"
 #include "qwaylanddatadevicemanager.h"
 #include "qwaylandtouch.h"
+#include "qwaylandkeymap.h"
+#include "qwaylandlatencyprobe.h"
 
 #include <QtGui/private/qpixmap_raster_p.h>
 #include <QtGui/QPlatformWindow>
@@ -56,11 +58,6 @@
 
 #include <QtGui/QGuiApplication>
 
-#ifndef QT_NO_WAYLAND_XKB
-#include <X11/extensions/XKBcommon.h>
-#include <X11/keysym.h>
-#endif
-
 QWaylandInputDevice::QWaylandInputDevice(QWaylandDisplay *display,
 					 uint32_t id)
     : mQDisplay(display)
@@ -70,6 +67,11 @@ QWaylandInputDevice::QWaylandInputDevice(QWaylandDisplay *display,
     , mKeyboardFocus(0)
     , mTouchFocus(0)
     , mButtons(0)
+    , mKeymap(0)
+    , mKeymapLoaded(false)
+    , mModifiers(0)
+    , mCompressMotion(qgetenv("QT_WAYLAND_MOTION_COMPRESSION") != "0")
+    , mPendingMotion(false)
 {
     mInputDevice = static_cast<struct wl_input_device *>
             (wl_display_bind(mDisplay,id,&wl_input_device_interface));
@@ -78,20 +80,6 @@ QWaylandInputDevice::QWaylandInputDevice(QWaylandDisplay *display,
 				 this);
     wl_input_device_set_user_data(mInputDevice, this);
 
-#ifndef QT_NO_WAYLAND_XKB
-    struct xkb_rule_names names;
-    names.rules = "evdev";
-    names.model = "pc105";
-    names.layout = "us";
-    names.variant = "";
-    names.options = "";
-
-    mXkb = xkb_compile_keymap_from_rules(&names);
-
-    if (!mXkb)
-        qWarning() << "xkb_compile_keymap_from_rules failed, no key input";
-#endif
-
     if (mQDisplay->dndSelectionHandler()) {
         mTransferDevice = mQDisplay->dndSelectionHandler()->getDataDevice(this);
     }
@@ -102,10 +90,31 @@ QWaylandInputDevice::QWaylandInputDevice(QWaylandDisplay *display,
     QWindowSystemInterface::registerTouchDevice(mTouchDevice);
 }
 
+bool QWaylandInputDevice::ensureKeymap()
+{
+#ifndef QT_NO_WAYLAND_XKB
+    // Loading the keymap takes a noticeable amount of time, so it is
+    // done on the first keyboard focus/key event rather than at startup.
+    if (!mKeymapLoaded) {
+        mKeymapLoaded = true;
+        mKeymap = QWaylandKeymap::instance();
+    }
+#endif
+    return mKeymap != 0;
+}
+
+void QWaylandInputDevice::inputDelivered(QWaylandWindow *window)
+{
+    if (QWaylandLatencyProbe *probe = mQDisplay->latencyProbe())
+        probe->inputDelivered(window);
+}
+
 void QWaylandInputDevice::handleWindowDestroyed(QWaylandWindow *window)
 {
-    if (window == mPointerFocus)
+    if (window == mPointerFocus) {
         mPointerFocus = 0;
+        mPendingMotion = false;
+    }
     if (window == mKeyboardFocus)
         mKeyboardFocus = 0;
 }
@@ -140,11 +149,36 @@ void QWaylandInputDevice::inputHandleMotion(void *data,
     inputDevice->mSurfacePos = QPoint(surface_x, surface_y);
     inputDevice->mGlobalPos = QPoint(x, y);
     inputDevice->mTime = time;
+
+    // Only the last position of a batch of motion events gets delivered,
+    // see flushPendingMotion()
+    if (inputDevice->mCompressMotion) {
+        inputDevice->mPendingMotion = true;
+        return;
+    }
+
     QWindowSystemInterface::handleMouseEvent(window->window(),
 					     time,
 					     inputDevice->mSurfacePos,
 					     inputDevice->mGlobalPos,
                                              inputDevice->mButtons);
+    inputDevice->inputDelivered(window);
+}
+
+void QWaylandInputDevice::flushPendingMotion()
+{
+    if (!mPendingMotion)
+        return;
+
+    mPendingMotion = false;
+    if (mPointerFocus) {
+        QWindowSystemInterface::handleMouseEvent(mPointerFocus->window(),
+                                                 mTime,
+                                                 mSurfacePos,
+                                                 mGlobalPos,
+                                                 mButtons);
+        inputDelivered(mPointerFocus);
+    }
 }
 
 void QWaylandInputDevice::inputHandleButton(void *data,
@@ -162,6 +196,8 @@ void QWaylandInputDevice::inputHandleButton(void *data,
 	return;
     }
 
+    inputDevice->flushPendingMotion();
+
     // translate from kernel (input.h) 'button' to corresponding Qt:MouseButton.
     // The range of mouse values is 0x110 <= mouse_button < 0x120, the first Joystick button.
     switch (button) {
@@ -195,76 +231,9 @@ void QWaylandInputDevice::inputHandleButton(void *data,
 					     inputDevice->mSurfacePos,
 					     inputDevice->mGlobalPos,
 					     inputDevice->mButtons);
+    inputDevice->inputDelivered(window);
 }
 
-#ifndef QT_NO_WAYLAND_XKB
-static Qt::KeyboardModifiers translateModifiers(int s)
-{
-    const uchar qt_alt_mask = XKB_COMMON_MOD1_MASK;
-    const uchar qt_meta_mask = XKB_COMMON_MOD4_MASK;
-
-    Qt::KeyboardModifiers ret = 0;
-    if (s & XKB_COMMON_SHIFT_MASK)
-	ret |= Qt::ShiftModifier;
-    if (s & XKB_COMMON_CONTROL_MASK)
-	ret |= Qt::ControlModifier;
-    if (s & qt_alt_mask)
-	ret |= Qt::AltModifier;
-    if (s & qt_meta_mask)
-	ret |= Qt::MetaModifier;
-
-    return ret;
-}
-
-static uint32_t translateKey(uint32_t sym, char *string, size_t size)
-{
-    Q_UNUSED(size);
-    string[0] = '\0';
-
-    switch (sym) {
-    case XK_Escape:		return Qt::Key_Escape;
-    case XK_Tab:		return Qt::Key_Tab;
-    case XK_ISO_Left_Tab:	return Qt::Key_Backtab;
-    case XK_BackSpace:		return Qt::Key_Backspace;
-    case XK_Return:		return Qt::Key_Return;
-    case XK_Insert:		return Qt::Key_Insert;
-    case XK_Delete:		return Qt::Key_Delete;
-    case XK_Clear:		return Qt::Key_Delete;
-    case XK_Pause:		return Qt::Key_Pause;
-    case XK_Print:		return Qt::Key_Print;
-
-    case XK_Home:		return Qt::Key_Home;
-    case XK_End:		return Qt::Key_End;
-    case XK_Left:		return Qt::Key_Left;
-    case XK_Up:			return Qt::Key_Up;
-    case XK_Right:		return Qt::Key_Right;
-    case XK_Down:		return Qt::Key_Down;
-    case XK_Prior:		return Qt::Key_PageUp;
-    case XK_Next:		return Qt::Key_PageDown;
-
-    case XK_Shift_L:		return Qt::Key_Shift;
-    case XK_Shift_R:		return Qt::Key_Shift;
-    case XK_Shift_Lock:		return Qt::Key_Shift;
-    case XK_Control_L:		return Qt::Key_Control;
-    case XK_Control_R:		return Qt::Key_Control;
-    case XK_Meta_L:		return Qt::Key_Meta;
-    case XK_Meta_R:		return Qt::Key_Meta;
-    case XK_Alt_L:		return Qt::Key_Alt;
-    case XK_Alt_R:		return Qt::Key_Alt;
-    case XK_Caps_Lock:		return Qt::Key_CapsLock;
-    case XK_Num_Lock:		return Qt::Key_NumLock;
-    case XK_Scroll_Lock:	return Qt::Key_ScrollLock;
-    case XK_Super_L:		return Qt::Key_Super_L;
-    case XK_Super_R:		return Qt::Key_Super_R;
-    case XK_Menu:		return Qt::Key_Menu;
-
-    default:
-	string[0] = sym;
-	string[1] = '\0';
-	return toupper(sym);
-    }
-}
-#endif
 
 void QWaylandInputDevice::inputHandleKey(void *data,
 					 struct wl_input_device *input_device,
@@ -273,28 +242,19 @@ void QWaylandInputDevice::inputHandleKey(void *data,
     Q_UNUSED(input_device);
     QWaylandInputDevice *inputDevice = (QWaylandInputDevice *) data;
     QWaylandWindow *window = inputDevice->mKeyboardFocus;
+    inputDevice->flushPendingMotion();
 #ifndef QT_NO_WAYLAND_XKB
-    uint32_t code, sym, level;
-    Qt::KeyboardModifiers modifiers;
     QEvent::Type type;
-    char s[2];
 
-    if (window == NULL || !inputDevice->mXkb) {
+    if (window == NULL || !inputDevice->ensureKeymap()) {
 	/* We destroyed the keyboard focus surface, but the server
 	 * didn't get the message yet. */
 	return;
     }
 
-    code = key + inputDevice->mXkb->min_key_code;
-
-    level = 0;
-    if (inputDevice->mModifiers & Qt::ShiftModifier &&
-	XkbKeyGroupWidth(inputDevice->mXkb, code, 0) > 1)
-	level = 1;
-
-    sym = XkbKeySymEntry(inputDevice->mXkb, code, level, 0);
-
-    modifiers = translateModifiers(inputDevice->mXkb->map->modmap[code]);
+    const QWaylandKeymap::Key &entry = inputDevice->mKeymap->key(key);
+    const int level = inputDevice->mModifiers & Qt::ShiftModifier ? 1 : 0;
+    const Qt::KeyboardModifiers modifiers(entry.modifiers);
 
     if (state) {
 	inputDevice->mModifiers |= modifiers;
@@ -304,14 +264,11 @@ void QWaylandInputDevice::inputHandleKey(void *data,
 	type = QEvent::KeyRelease;
     }
 
-    sym = translateKey(sym, s, sizeof s);
-
-    if (window) {
-        QWindowSystemInterface::handleKeyEvent(window->window(),
-                                               time, type, sym,
-                                               inputDevice->mModifiers,
-                                               QString::fromLatin1(s));
-    }
+    QWindowSystemInterface::handleKeyEvent(window->window(),
+                                           time, type, entry.qtKey[level],
+                                           inputDevice->mModifiers,
+                                           inputDevice->mKeymap->text(entry, level));
+    inputDevice->inputDelivered(window);
 #else
     // Generic fallback for single hard keys: Assume 'key' is a Qt key code.
     if (window) {
@@ -336,6 +293,8 @@ void QWaylandInputDevice::inputHandlePointerFocus(void *data,
     QWaylandInputDevice *inputDevice = (QWaylandInputDevice *) data;
     QWaylandWindow *window;
 
+    inputDevice->flushPendingMotion();
+
     if (inputDevice->mPointerFocus) {
 	window = inputDevice->mPointerFocus;
 	QWindowSystemInterface::handleLeaveEvent(window->window());
@@ -362,18 +321,18 @@ void QWaylandInputDevice::inputHandleKeyboardFocus(void *data,
     QWaylandInputDevice *inputDevice = (QWaylandInputDevice *) data;
     QWaylandWindow *window;
 
+    inputDevice->flushPendingMotion();
     inputDevice->mModifiers = 0;
 
 #ifndef QT_NO_WAYLAND_XKB
     uint32_t *k, *end;
-    uint32_t code;
+
+    if (surface)
+        inputDevice->ensureKeymap();
 
     end = (uint32_t *) ((char *) keys->data + keys->size);
-    for (k = (uint32_t *) keys->data; k < end; k++) {
-	code = *k + inputDevice->mXkb->min_key_code;
-	inputDevice->mModifiers |=
-	    translateModifiers(inputDevice->mXkb->map->modmap[code]);
-    }
+    for (k = (uint32_t *) keys->data; inputDevice->mKeymap && k < end; k++)
+	inputDevice->mModifiers |= Qt::KeyboardModifiers(inputDevice->mKeymap->key(*k).modifiers);
 #else
     Q_UNUSED(keys);
 #endif
@@ -432,6 +391,8 @@ void QWaylandInputDevice::inputHandleTouchMotion(void *data,
 
 void QWaylandInputDevice::handleTouchPoint(int id, int x, int y, Qt::TouchPointState state)
 {
+    flushPendingMotion();
+
     QWindowSystemInterface::TouchPoint tp;
 
     // Find out the coordinates for Released events.
@@ -500,6 +461,7 @@ void QWaylandInputDevice::handleTouchFrame()
     }
 
     QWindowSystemInterface::handleTouchEvent(0, mTouchDevice, mTouchPoints);
+    inputDelivered(mTouchFocus);
 
     bool allReleased = true;
     for (int i = 0; i < mTouchPoints.count(); ++i)
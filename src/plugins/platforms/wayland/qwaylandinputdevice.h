@@ -56,6 +56,7 @@ QT_BEGIN_NAMESPACE
 
 class QWaylandWindow;
 class QWaylandDisplay;
+class QWaylandKeymap;
 
 class QWaylandInputDevice {
 public:
@@ -64,11 +65,17 @@ public:
     void handleWindowDestroyed(QWaylandWindow *window);
     struct wl_input_device *wl_input_device() const { return mInputDevice; }
     QWaylandWindow *pointerFocus() const { return mPointerFocus; }
+    uint32_t lastEventTime() const { return mTime; }
+
+    void flushPendingMotion();
 
     void setTransferDevice(struct wl_data_device *device);
     struct wl_data_device *transferDevice() const;
 
 private:
+    bool ensureKeymap();
+    void inputDelivered(QWaylandWindow *window);
+
     QWaylandDisplay *mQDisplay;
     struct wl_display *mDisplay;
     struct wl_input_device *mInputDevice;
@@ -80,9 +87,12 @@ private:
     Qt::MouseButtons mButtons;
     QPoint mSurfacePos;
     QPoint mGlobalPos;
-    struct xkb_desc *mXkb;
+    const QWaylandKeymap *mKeymap;
+    bool mKeymapLoaded;
     Qt::KeyboardModifiers mModifiers;
     uint32_t mTime;
+    bool mCompressMotion;
+    bool mPendingMotion;
 
     static void inputHandleMotion(void *data,
 				  struct wl_input_device *input_device,
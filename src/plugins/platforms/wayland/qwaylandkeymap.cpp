@@ -0,0 +1,282 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the plugins of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.LGPL included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights. These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU General
+** Public License version 3.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of this
+** file. Please review the following information to ensure the GNU General
+** Public License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** Other Usage
+** Alternatively, this file may be used in accordance with the terms and
+** conditions contained in a signed written agreement between you and Nokia.
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qwaylandkeymap.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QGlobalStatic>
+#include <QDebug>
+
+#include <ctype.h>
+#include <string.h>
+
+#ifndef QT_NO_WAYLAND_XKB
+#include <X11/extensions/XKBcommon.h>
+#include <X11/keysym.h>
+#endif
+
+static const quint32 cacheMagic = 0x514b4d50; // "QKMP"
+static const quint32 cacheVersion = 1;
+
+static const char *ruleNames[] = {
+    "evdev",    // rules
+    "pc105",    // model
+    "us",       // layout
+    "",         // variant
+    ""          // options
+};
+
+Q_GLOBAL_STATIC(QWaylandKeymap, sharedKeymap)
+
+const QWaylandKeymap *QWaylandKeymap::instance()
+{
+    const QWaylandKeymap *keymap = sharedKeymap();
+    return keymap && keymap->isValid() ? keymap : 0;
+}
+
+QWaylandKeymap::QWaylandKeymap()
+    : mMinKeyCode(0)
+    , mValid(false)
+{
+    memset(mKeys, 0, sizeof(mKeys));
+    memset(&mNoKey, 0, sizeof(mNoKey));
+
+    for (uint i = 0; i < sizeof(ruleNames) / sizeof(ruleNames[0]); ++i)
+        mNames += QByteArray(ruleNames[i]) + ',';
+
+    const bool useCache = qgetenv("QT_WAYLAND_KEYMAP_CACHE") != "0";
+    const bool debug = !qgetenv("QT_WAYLAND_DEBUG_STARTUP").isEmpty();
+    const QString fileName = cacheFileName(mNames);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (useCache && load(fileName)) {
+        mValid = true;
+        if (debug)
+            qDebug() << "QWaylandKeymap: loaded" << fileName << "in" << timer.elapsed() << "ms";
+        return;
+    }
+
+    mValid = compile();
+    if (!mValid) {
+        qWarning() << "xkb_compile_keymap_from_rules failed, no key input";
+        return;
+    }
+    if (debug)
+        qDebug() << "QWaylandKeymap: keymap compiled in" << timer.elapsed() << "ms";
+    if (useCache)
+        save(fileName);
+}
+
+QString QWaylandKeymap::cacheFileName(const QByteArray &names)
+{
+    QString dir = QFile::decodeName(qgetenv("XDG_CACHE_HOME"));
+    if (dir.isEmpty())
+        dir = QDir::homePath() + QLatin1String("/.cache");
+    const QByteArray hash = QCryptographicHash::hash(names, QCryptographicHash::Md5).toHex();
+    return dir + QLatin1String("/qtwayland/keymap-") + QLatin1String(hash);
+}
+
+bool QWaylandKeymap::load(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    quint32 magic, version, minKeyCode;
+    QByteArray names;
+    stream >> magic >> version >> names >> minKeyCode;
+    if (stream.status() != QDataStream::Ok || magic != cacheMagic
+            || version != cacheVersion || names != mNames)
+        return false;
+
+    for (int i = 0; i < KeyCount; ++i) {
+        Key &key = mKeys[i];
+        qint8 text0, text1;
+        stream >> key.qtKey[0] >> key.qtKey[1] >> text0 >> text1 >> key.modifiers;
+        key.text[0] = text0;
+        key.text[1] = text1;
+    }
+    if (stream.status() != QDataStream::Ok) {
+        memset(mKeys, 0, sizeof(mKeys));
+        return false;
+    }
+
+    mMinKeyCode = minKeyCode;
+    return true;
+}
+
+void QWaylandKeymap::save(const QString &fileName) const
+{
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+    // Write a temporary file first so that concurrently starting
+    // applications never see a partial table
+    const QString tmpName = fileName + QLatin1Char('.') + QString::number(QCoreApplication::applicationPid());
+    QFile file(tmpName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+
+    QDataStream stream(&file);
+    stream << cacheMagic << cacheVersion << mNames << quint32(mMinKeyCode);
+    for (int i = 0; i < KeyCount; ++i) {
+        const Key &key = mKeys[i];
+        stream << key.qtKey[0] << key.qtKey[1]
+               << qint8(key.text[0]) << qint8(key.text[1]) << key.modifiers;
+    }
+    file.close();
+
+    if (stream.status() != QDataStream::Ok || file.error() != QFile::NoError
+            || (QFile::exists(fileName) && !QFile::remove(fileName))
+            || !QFile::rename(tmpName, fileName))
+        QFile::remove(tmpName);
+}
+
+#ifndef QT_NO_WAYLAND_XKB
+static Qt::KeyboardModifiers translateModifiers(int s)
+{
+    const uchar qt_alt_mask = XKB_COMMON_MOD1_MASK;
+    const uchar qt_meta_mask = XKB_COMMON_MOD4_MASK;
+
+    Qt::KeyboardModifiers ret = 0;
+    if (s & XKB_COMMON_SHIFT_MASK)
+	ret |= Qt::ShiftModifier;
+    if (s & XKB_COMMON_CONTROL_MASK)
+	ret |= Qt::ControlModifier;
+    if (s & qt_alt_mask)
+	ret |= Qt::AltModifier;
+    if (s & qt_meta_mask)
+	ret |= Qt::MetaModifier;
+
+    return ret;
+}
+
+static uint32_t translateKey(uint32_t sym, char *string, size_t size)
+{
+    Q_UNUSED(size);
+    string[0] = '\0';
+
+    switch (sym) {
+    case XK_Escape:		return Qt::Key_Escape;
+    case XK_Tab:		return Qt::Key_Tab;
+    case XK_ISO_Left_Tab:	return Qt::Key_Backtab;
+    case XK_BackSpace:		return Qt::Key_Backspace;
+    case XK_Return:		return Qt::Key_Return;
+    case XK_Insert:		return Qt::Key_Insert;
+    case XK_Delete:		return Qt::Key_Delete;
+    case XK_Clear:		return Qt::Key_Delete;
+    case XK_Pause:		return Qt::Key_Pause;
+    case XK_Print:		return Qt::Key_Print;
+
+    case XK_Home:		return Qt::Key_Home;
+    case XK_End:		return Qt::Key_End;
+    case XK_Left:		return Qt::Key_Left;
+    case XK_Up:			return Qt::Key_Up;
+    case XK_Right:		return Qt::Key_Right;
+    case XK_Down:		return Qt::Key_Down;
+    case XK_Prior:		return Qt::Key_PageUp;
+    case XK_Next:		return Qt::Key_PageDown;
+
+    case XK_Shift_L:		return Qt::Key_Shift;
+    case XK_Shift_R:		return Qt::Key_Shift;
+    case XK_Shift_Lock:		return Qt::Key_Shift;
+    case XK_Control_L:		return Qt::Key_Control;
+    case XK_Control_R:		return Qt::Key_Control;
+    case XK_Meta_L:		return Qt::Key_Meta;
+    case XK_Meta_R:		return Qt::Key_Meta;
+    case XK_Alt_L:		return Qt::Key_Alt;
+    case XK_Alt_R:		return Qt::Key_Alt;
+    case XK_Caps_Lock:		return Qt::Key_CapsLock;
+    case XK_Num_Lock:		return Qt::Key_NumLock;
+    case XK_Scroll_Lock:	return Qt::Key_ScrollLock;
+    case XK_Super_L:		return Qt::Key_Super_L;
+    case XK_Super_R:		return Qt::Key_Super_R;
+    case XK_Menu:		return Qt::Key_Menu;
+
+    default:
+	string[0] = sym;
+	string[1] = '\0';
+	return toupper(sym);
+    }
+}
+#endif
+
+bool QWaylandKeymap::compile()
+{
+#ifndef QT_NO_WAYLAND_XKB
+    struct xkb_rule_names names;
+    names.rules = ruleNames[0];
+    names.model = ruleNames[1];
+    names.layout = ruleNames[2];
+    names.variant = ruleNames[3];
+    names.options = ruleNames[4];
+
+    struct xkb_desc *xkb = xkb_compile_keymap_from_rules(&names);
+    if (!xkb)
+        return false;
+
+    mMinKeyCode = xkb->min_key_code;
+    for (uint32_t code = xkb->min_key_code; code <= xkb->max_key_code && code < KeyCount; ++code) {
+        Key &key = mKeys[code];
+        const int levels = XkbKeyGroupWidth(xkb, code, 0) > 1 ? 2 : 1;
+        for (int level = 0; level < 2; ++level) {
+            char s[2];
+            const uint32_t sym = XkbKeySymEntry(xkb, code, level < levels ? level : 0, 0);
+            key.qtKey[level] = translateKey(sym, s, sizeof s);
+            key.text[level] = s[0];
+        }
+        key.modifiers = translateModifiers(xkb->map->modmap[code]);
+    }
+
+    xkb_free_keymap(xkb);
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,98 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the plugins of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.LGPL included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights. These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU General
+** Public License version 3.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of this
+** file. Please review the following information to ensure the GNU General
+** Public License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** Other Usage
+** Alternatively, this file may be used in accordance with the terms and
+** conditions contained in a signed written agreement between you and Nokia.
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QWAYLANDKEYMAP_H
+#define QWAYLANDKEYMAP_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+
+#include <stdint.h>
+
+// Flat keycode to Qt key table built from the XKB keymap. The keymap is
+// compiled once per process and shared by all input devices. The table
+// is also cached on disk, keyed by the rules, model, layout, variant and
+// options names, so later application launches skip keymap compilation.
+// Set QT_WAYLAND_KEYMAP_CACHE=0 to bypass the cache, e.g. after changing
+// the XKB data files.
+class QWaylandKeymap
+{
+public:
+    struct Key {
+        uint32_t qtKey[2]; // indexed by shift level
+        char text[2];
+        uint32_t modifiers;
+    };
+
+    // Returns 0 if no keymap could be compiled
+    static const QWaylandKeymap *instance();
+
+    const Key &key(uint32_t key) const
+    {
+        const uint32_t code = key + mMinKeyCode;
+        return code < KeyCount ? mKeys[code] : mNoKey;
+    }
+
+    QString text(const Key &key, int level) const
+    {
+        return key.text[level] ? QString(QLatin1Char(key.text[level])) : QString();
+    }
+
+    bool isValid() const { return mValid; }
+
+    QWaylandKeymap();
+
+private:
+    enum { KeyCount = 256 };
+
+    bool compile();
+    bool load(const QString &fileName);
+    void save(const QString &fileName) const;
+    static QString cacheFileName(const QByteArray &names);
+
+    QByteArray mNames;
+    uint32_t mMinKeyCode;
+    Key mKeys[KeyCount];
+    Key mNoKey;
+    bool mValid;
+};
+
+#endif // QWAYLANDKEYMAP_H
@@ -0,0 +1,73 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the plugins of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.LGPL included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights. These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU General
+** Public License version 3.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of this
+** file. Please review the following information to ensure the GNU General
+** Public License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** Other Usage
+** Alternatively, this file may be used in accordance with the terms and
+** conditions contained in a signed written agreement between you and Nokia.
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QWAYLANDLATENCYPROBE_H
+#define QWAYLANDLATENCYPROBE_H
+
+#include "qwaylandlatencyhistogram.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+
+class QWaylandWindow;
+
+// Client side counterpart of the compositor's latency probe: measures
+// the time from an input event reaching a window until the window
+// commits its next frame. Enabled by setting QT_WAYLAND_LATENCY_PROBE,
+// the histogram is written to the debug output every 1000 frames and
+// on exit.
+class QWaylandLatencyProbe
+{
+public:
+    QWaylandLatencyProbe();
+    ~QWaylandLatencyProbe();
+
+    void inputDelivered(QWaylandWindow *window);
+    void frameCommitted(QWaylandWindow *window);
+    void windowDestroyed(QWaylandWindow *window);
+
+private:
+    QElapsedTimer mClock;
+    QHash<QWaylandWindow *, qint64> mPendingInput;
+    QWaylandLatencyHistogram mInputToCommit;
+};
+
+#endif // QWAYLANDLATENCYPROBE_H
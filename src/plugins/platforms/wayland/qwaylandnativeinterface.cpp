@@ -43,6 +43,8 @@
 #include "qwaylanddisplay.h"
 #include "qwaylandwindow.h"
 #include "qwaylandextendedsurface.h"
+#include "qwaylandshellsurface.h"
+#include "qwaylandinputdevice.h"
 #include <QtGui/private/qguiapplication_p.h>
 #include <QtGui/QScreen>
 
@@ -111,3 +113,61 @@ void QWaylandNativeInterface::emitWindowPropertyChanged(QPlatformWindow *window,
 {
     emit windowPropertyChanged(window,name);
 }
+
+// Delivers a QEvent::UpdateRequest to the window once the compositor has
+// presented the previous frame. Invoke through QMetaObject::invokeMethod()
+// on QGuiApplication::platformNativeInterface().
+void QWaylandNativeInterface::requestUpdate(QWindow *window)
+{
+    if (QWaylandWindow *waylandWindow = static_cast<QWaylandWindow *>(window->handle()))
+        waylandWindow->requestUpdate();
+}
+
+// Limits the part of the window receiving input, an empty region lets all
+// input through. Needs version 2 of the surface extension on the compositor
+// side.
+void QWaylandNativeInterface::setInputRegion(QWindow *window, const QRegion &region)
+{
+    QWaylandWindow *waylandWindow = static_cast<QWaylandWindow *>(window->handle());
+    if (waylandWindow && waylandWindow->extendedWindow())
+        waylandWindow->extendedWindow()->setInputRegion(region);
+}
+
+void QWaylandNativeInterface::resetInputRegion(QWindow *window)
+{
+    QWaylandWindow *waylandWindow = static_cast<QWaylandWindow *>(window->handle());
+    if (waylandWindow && waylandWindow->extendedWindow())
+        waylandWindow->extendedWindow()->resetInputRegion();
+}
+
+QWaylandInputDevice *QWaylandNativeInterface::pointerDeviceForWindow(QWaylandWindow *window)
+{
+    QWaylandDisplay *display = qPlatformScreenForWindow(window->window())->display();
+    foreach (QWaylandInputDevice *inputDevice, display->inputDevices()) {
+        if (inputDevice->pointerFocus() == window)
+            return inputDevice;
+    }
+    return 0;
+}
+
+// Lets the compositor move the window while the pointer button that is
+// currently pressed on it stays down
+void QWaylandNativeInterface::startMove(QWindow *window)
+{
+    QWaylandWindow *waylandWindow = static_cast<QWaylandWindow *>(window->handle());
+    if (!waylandWindow || !waylandWindow->shellSurface())
+        return;
+    if (QWaylandInputDevice *inputDevice = pointerDeviceForWindow(waylandWindow))
+        waylandWindow->shellSurface()->move(inputDevice);
+}
+
+// Same as startMove() for resizing, edges takes the wl_shell_surface
+// resize values
+void QWaylandNativeInterface::startResize(QWindow *window, int edges)
+{
+    QWaylandWindow *waylandWindow = static_cast<QWaylandWindow *>(window->handle());
+    if (!waylandWindow || !waylandWindow->shellSurface())
+        return;
+    if (QWaylandInputDevice *inputDevice = pointerDeviceForWindow(waylandWindow))
+        waylandWindow->shellSurface()->resize(inputDevice, edges);
+}
@@ -46,8 +46,12 @@
 #include <QVariantMap>
 #include <QtGui/QPlatformNativeInterface>
 
+class QWaylandWindow;
+class QWaylandInputDevice;
+
 class QWaylandNativeInterface : public QPlatformNativeInterface
 {
+    Q_OBJECT
 public:
     void *nativeResourceForWindow(const QByteArray &resourceString,
 				  QWindow *window);
@@ -58,8 +62,15 @@ public:
     void setWindowProperty(QPlatformWindow *window, const QString &name, const QVariant &value);
 
     void emitWindowPropertyChanged(QPlatformWindow *window, const QString &name);
+
+    Q_INVOKABLE void requestUpdate(QWindow *window);
+    Q_INVOKABLE void setInputRegion(QWindow *window, const QRegion &region);
+    Q_INVOKABLE void resetInputRegion(QWindow *window);
+    Q_INVOKABLE void startMove(QWindow *window);
+    Q_INVOKABLE void startResize(QWindow *window, int edges);
 private:
     static QWaylandScreen *qPlatformScreenForWindow(QWindow *window);
+    static QWaylandInputDevice *pointerDeviceForWindow(QWaylandWindow *window);
 
 private:
     QHash<QPlatformWindow*, QVariantMap> m_windowProperties;
@@ -53,6 +53,7 @@ QWaylandScreen::QWaylandScreen(QWaylandDisplay *waylandDisplay, struct wl_output
     , mOutput(output)
     , mExtendedOutput(0)
     , mGeometry(geometry)
+    , mRefreshRate(60000)
     , mDepth(32)
     , mFormat(QImage::Format_ARGB32_Premultiplied)
     , mWaylandCursor(new QWaylandCursor(this))
@@ -78,6 +79,15 @@ QRect QWaylandScreen::geometry() const
     return mGeometry;
 }
 
+void QWaylandScreen::setGeometry(const QRect &geometry)
+{
+    if (geometry == mGeometry)
+        return;
+    mGeometry = geometry;
+    if (screen())
+        QWindowSystemInterface::handleScreenGeometryChange(screen(), geometry);
+}
+
 int QWaylandScreen::depth() const
 {
     return mDepth;
@@ -88,6 +98,18 @@ QImage::Format QWaylandScreen::format() const
     return mFormat;
 }
 
+qreal QWaylandScreen::refreshRate() const
+{
+    return mRefreshRate / qreal(1000);
+}
+
+// In mHz, as sent with the current mode of the output
+void QWaylandScreen::setRefreshRate(int refreshRate)
+{
+    if (refreshRate > 0)
+        mRefreshRate = refreshRate;
+}
+
 Qt::ScreenOrientation QWaylandScreen::orientation() const
 {
     if (mExtendedOutput)
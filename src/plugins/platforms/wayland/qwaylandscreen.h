@@ -57,9 +57,13 @@ public:
     QWaylandDisplay *display() const;
 
     QRect geometry() const;
+    void setGeometry(const QRect &geometry);
     int depth() const;
     QImage::Format format() const;
 
+    qreal refreshRate() const;
+    void setRefreshRate(int refreshRate);
+
     Qt::ScreenOrientation orientation() const;
 
     QPlatformCursor *cursor() const;
@@ -76,6 +80,7 @@ private:
     struct wl_output *mOutput;
     QWaylandExtendedOutput *mExtendedOutput;
     QRect mGeometry;
+    int mRefreshRate;
     int mDepth;
     QImage::Format mFormat;
     QSize mPhysicalSize;
@@ -43,6 +43,7 @@
 
 #include "qwaylanddisplay.h"
 #include "qwaylandwindow.h"
+#include "qwaylandinputdevice.h"
 
 QWaylandShellSurface::QWaylandShellSurface(struct wl_shell_surface *shell_surface, QWaylandWindow *window)
     : m_shell_surface(shell_surface)
@@ -51,6 +52,25 @@ QWaylandShellSurface::QWaylandShellSurface(struct wl_shell_surface *shell_surfac
     wl_shell_surface_add_listener(m_shell_surface,&m_shell_surface_listener,this);
 }
 
+// The compositor moves the window with the pointer until the button is
+// released, without any further involvement of the client
+void QWaylandShellSurface::move(QWaylandInputDevice *inputDevice)
+{
+    wl_shell_surface_move(m_shell_surface,
+                          inputDevice->wl_input_device(),
+                          inputDevice->lastEventTime());
+}
+
+// edges is a combination of the wl_shell_surface resize values, the
+// compositor sends throttled configure events until the button is released
+void QWaylandShellSurface::resize(QWaylandInputDevice *inputDevice, uint32_t edges)
+{
+    wl_shell_surface_resize(m_shell_surface,
+                            inputDevice->wl_input_device(),
+                            inputDevice->lastEventTime(),
+                            edges);
+}
+
 
 void QWaylandShellSurface::configure(void *data,
                                      wl_shell_surface *wl_shell_surface,
@@ -45,6 +45,7 @@
 #include <inttypes.h>
 
 class QWaylandWindow;
+class QWaylandInputDevice;
 
 class QWaylandShellSurface
 {
@@ -53,6 +54,9 @@ public:
 
     struct wl_shell_surface *handle() const { return m_shell_surface; }
 
+    void move(QWaylandInputDevice *inputDevice);
+    void resize(QWaylandInputDevice *inputDevice, uint32_t edges);
+
 private:
     struct wl_shell_surface *m_shell_surface;
     QWaylandWindow *m_window;
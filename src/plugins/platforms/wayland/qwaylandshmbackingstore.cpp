@@ -113,18 +113,68 @@ void QWaylandShmBackingStore::beginPaint(const QRegion &)
     waylandWindow->waitForFrameSync();
 }
 
+static int envInt(const char *name, int defaultValue)
+{
+    bool ok;
+    int value = qgetenv(name).toInt(&ok);
+    return ok ? value : defaultValue;
+}
+
+static inline int area(const QRect &rect)
+{
+    return rect.width() * rect.height();
+}
+
+// Every damage rect costs two requests on the wire. Neighbouring rects are
+// merged into their bounding rect as long as the extra pixels this makes
+// the compositor repaint are cheaper than sending the rect separately, and
+// in any case until no more than maxRects remain. QRegion returns its rects
+// in y-x banded order, so neighbours in the vector are close on screen.
+static QVector<QRect> simplifyDamage(const QRegion &region, int maxRects, int messageCost)
+{
+    QVector<QRect> rects = region.rects();
+
+    while (rects.size() > 1) {
+        int best = -1;
+        int bestWaste = 0;
+        for (int i = 0; i < rects.size() - 1; ++i) {
+            const QRect &a = rects.at(i);
+            const QRect &b = rects.at(i + 1);
+            int waste = area(a | b) - area(a) - area(b);
+            if (best < 0 || waste < bestWaste) {
+                best = i;
+                bestWaste = waste;
+            }
+        }
+
+        if (rects.size() <= maxRects && bestWaste > messageCost)
+            break;
+
+        rects[best] |= rects.at(best + 1);
+        rects.remove(best + 1);
+    }
+
+    return rects;
+}
+
 void QWaylandShmBackingStore::flush(QWindow *window, const QRegion &region, const QPoint &offset)
 {
-    Q_UNUSED(window);
     Q_UNUSED(offset);
     QWaylandShmWindow *waylandWindow = static_cast<QWaylandShmWindow *>(window->handle());
     Q_ASSERT(waylandWindow->windowType() == QWaylandWindow::Shm);
-    QVector<QRect> rects = region.rects();
+
+    static int maxRects = qMax(1, envInt("QT_WAYLAND_MAX_DAMAGE_RECTS", 8));
+    static int messageCost = envInt("QT_WAYLAND_DAMAGE_MESSAGE_COST", 4096);
+
+    QVector<QRect> rects = simplifyDamage(region, maxRects, messageCost);
     for (int i = 0; i < rects.size(); i++) {
         const QRect rect = rects.at(i);
         wl_buffer_damage(mBuffer->buffer(),rect.x(),rect.y(),rect.width(),rect.height());
-        waylandWindow->damage(rect);
     }
+    waylandWindow->damage(rects);
+
+    // Send the whole frame in one go instead of waiting for the event loop
+    mDisplay->flushRequests();
 }
 
 void QWaylandShmBackingStore::resize(const QSize &size, const QRegion &)
@@ -71,19 +71,12 @@ static inline qreal fromFixed(int f)
     return f / qreal(10000);
 }
 
-void QWaylandTouchExtension::handle_touch(void *data, wl_touch_extension *ext, uint32_t time,
-                                          uint32_t id, uint32_t state, int32_t x, int32_t y,
-                                          int32_t normalized_x, int32_t normalized_y,
-                                          int32_t width, int32_t height, uint32_t pressure,
-                                          int32_t velocity_x, int32_t velocity_y,
-                                          uint32_t flags, wl_array *rawdata)
+bool QWaylandTouchExtension::updateTargetWindow()
 {
-    Q_UNUSED(ext);
-    QWaylandTouchExtension *self = static_cast<QWaylandTouchExtension *>(data);
-    QList<QWaylandInputDevice *> inputDevices = self->mDisplay->inputDevices();
+    QList<QWaylandInputDevice *> inputDevices = mDisplay->inputDevices();
     if (inputDevices.isEmpty()) {
         qWarning("wl_touch_extension: handle_touch: No input device");
-        return;
+        return false;
     }
     QWaylandInputDevice *dev = inputDevices.first();
     QWaylandWindow *win = dev->mTouchFocus;
@@ -93,25 +86,28 @@ void QWaylandTouchExtension::handle_touch(void *data, wl_touch_extension *ext, u
         win = dev->mKeyboardFocus;
     if (!win || !win->window()) {
         qWarning("wl_touch_extension: handle_touch: No pointer focus");
-        return;
+        return false;
     }
-    self->mTargetWindow = win->window();
+    mTargetWindow = win->window();
+    return true;
+}
 
+void QWaylandTouchExtension::appendTouchPoint(uint32_t id, uint32_t state, int32_t x, int32_t y,
+                                              int32_t normalized_x, int32_t normalized_y,
+                                              int32_t width, int32_t height, uint32_t pressure,
+                                              int32_t velocity_x, int32_t velocity_y, uint32_t flags,
+                                              const float *rawPositions, int rawPosCount)
+{
     QWindowSystemInterface::TouchPoint tp;
     tp.id = id;
     tp.state = Qt::TouchPointState(int(state & 0xFFFF));
-    int sentPointCount = state >> 16;
-    if (!self->mPointsLeft) {
-        Q_ASSERT(sentPointCount > 0);
-        self->mPointsLeft = sentPointCount;
-    }
     tp.flags = QTouchEvent::TouchPoint::InfoFlags(int(flags));
 
     tp.area = QRectF(0, 0, fromFixed(width), fromFixed(height));
     // Got surface-relative coords but need a (virtual) screen position.
     QPointF relPos = QPointF(fromFixed(x), fromFixed(y));
     QPointF delta = relPos - relPos.toPoint();
-    tp.area.moveCenter(self->mTargetWindow->mapToGlobal(relPos.toPoint()) + delta);
+    tp.area.moveCenter(mTargetWindow->mapToGlobal(relPos.toPoint()) + delta);
 
     tp.normalPosition.setX(fromFixed(normalized_x));
     tp.normalPosition.setY(fromFixed(normalized_y));
@@ -119,23 +115,72 @@ void QWaylandTouchExtension::handle_touch(void *data, wl_touch_extension *ext, u
     tp.velocity.setX(fromFixed(velocity_x));
     tp.velocity.setY(fromFixed(velocity_y));
 
-    if (rawdata) {
-        const int rawPosCount = rawdata->size / sizeof(float) / 2;
-        float *p = static_cast<float *>(rawdata->data);
-        for (int i = 0; i < rawPosCount; ++i) {
-            float x = *p++;
-            float y = *p++;
-            tp.rawPositions.append(QPointF(x, y));
-        }
+    for (int i = 0; i < rawPosCount; ++i) {
+        float x = *rawPositions++;
+        float y = *rawPositions++;
+        tp.rawPositions.append(QPointF(x, y));
     }
 
-    self->mTouchPoints.append(tp);
+    mTouchPoints.append(tp);
+}
+
+void QWaylandTouchExtension::handle_touch(void *data, wl_touch_extension *ext, uint32_t time,
+                                          uint32_t id, uint32_t state, int32_t x, int32_t y,
+                                          int32_t normalized_x, int32_t normalized_y,
+                                          int32_t width, int32_t height, uint32_t pressure,
+                                          int32_t velocity_x, int32_t velocity_y,
+                                          uint32_t flags, wl_array *rawdata)
+{
+    Q_UNUSED(ext);
+    QWaylandTouchExtension *self = static_cast<QWaylandTouchExtension *>(data);
+    if (!self->updateTargetWindow())
+        return;
+
+    int sentPointCount = state >> 16;
+    if (!self->mPointsLeft) {
+        Q_ASSERT(sentPointCount > 0);
+        self->mPointsLeft = sentPointCount;
+    }
+
+    const float *raw = rawdata ? static_cast<const float *>(rawdata->data) : 0;
+    const int rawPosCount = rawdata ? rawdata->size / sizeof(float) / 2 : 0;
+    self->appendTouchPoint(id, state, x, y, normalized_x, normalized_y, width, height,
+                           pressure, velocity_x, velocity_y, flags, raw, rawPosCount);
     self->mTimestamp = time;
 
     if (!--self->mPointsLeft)
         self->sendTouchEvent();
 }
 
+// All points of a touch event in one message, see touch-extension.xml
+void QWaylandTouchExtension::handle_touch_frame(void *data, wl_touch_extension *ext,
+                                                uint32_t time, wl_array *points)
+{
+    Q_UNUSED(ext);
+    QWaylandTouchExtension *self = static_cast<QWaylandTouchExtension *>(data);
+    if (!self->updateTargetWindow())
+        return;
+
+    // A large touch event is split over several frames, it is complete once
+    // the point count carried in the state has arrived
+    const int32_t *p = static_cast<const int32_t *>(points->data);
+    const int32_t *end = p + points->size / sizeof(int32_t);
+    self->mTimestamp = time;
+    while (end - p >= 13) {
+        const int rawPosCount = p[12];
+        if (rawPosCount < 0 || end - p < 13 + rawPosCount * 2)
+            break;
+        if (!self->mPointsLeft)
+            self->mPointsLeft = qMax(1, int(uint32_t(p[1]) >> 16));
+        self->appendTouchPoint(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7],
+                               p[8], p[9], p[10], p[11],
+                               reinterpret_cast<const float *>(p + 13), rawPosCount);
+        p += 13 + rawPosCount * 2;
+        if (!--self->mPointsLeft)
+            self->sendTouchEvent();
+    }
+}
+
 void QWaylandTouchExtension::sendTouchEvent()
 {
     // Copy all points, that are in the previous but not in the current list, as stationary.
@@ -197,6 +242,7 @@ void QWaylandTouchExtension::touchCanceled()
 {
     mTouchPoints.clear();
     mPrevTouchPoints.clear();
+    mPointsLeft = 0;
     if (mMouseSourceId != -1)
         QWindowSystemInterface::handleMouseEvent(mTargetWindow, mTimestamp, mLastMouseLocal, mLastMouseGlobal, Qt::NoButton);
 }
@@ -210,5 +256,6 @@ void QWaylandTouchExtension::handle_configure(void *data, wl_touch_extension *ex
 
 const struct wl_touch_extension_listener QWaylandTouchExtension::touch_listener = {
     QWaylandTouchExtension::handle_touch,
-    QWaylandTouchExtension::handle_configure
+    QWaylandTouchExtension::handle_configure,
+    QWaylandTouchExtension::handle_touch_frame
 };
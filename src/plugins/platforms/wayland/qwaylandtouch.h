@@ -78,6 +78,17 @@ private:
     static void handle_configure(void *data,
                                  struct wl_touch_extension *ext,
                                  uint32_t flags);
+    static void handle_touch_frame(void *data,
+                                   struct wl_touch_extension *ext,
+                                   uint32_t time,
+                                   struct wl_array *points);
+
+    bool updateTargetWindow();
+    void appendTouchPoint(uint32_t id, uint32_t state, int32_t x, int32_t y,
+                          int32_t normalized_x, int32_t normalized_y,
+                          int32_t width, int32_t height, uint32_t pressure,
+                          int32_t velocity_x, int32_t velocity_y, uint32_t flags,
+                          const float *rawPositions, int rawPosCount);
 
     void sendTouchEvent();
 
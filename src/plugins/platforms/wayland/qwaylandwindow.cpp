@@ -47,6 +47,7 @@
 #include "qwaylandscreen.h"
 #include "qwaylandshell.h"
 #include "qwaylandshellsurface.h"
+#include "qwaylandlatencyprobe.h"
 
 #include <QtGui/QWindow>
 
@@ -70,6 +71,7 @@ QWaylandWindow::QWaylandWindow(QWindow *window)
     , mBuffer(0)
     , mWaitingForFrameSync(false)
     , mFrameCallback(0)
+    , mUpdateRequested(false)
 {
     static WId id = 1;
     mWindowId = id++;
@@ -102,6 +104,9 @@ QWaylandWindow::~QWaylandWindow()
     QList<QWaylandInputDevice *> inputDevices = mDisplay->inputDevices();
     for (int i = 0; i < inputDevices.size(); ++i)
         inputDevices.at(i)->handleWindowDestroyed(this);
+
+    if (QWaylandLatencyProbe *probe = mDisplay->latencyProbe())
+        probe->windowDestroyed(this);
 }
 
 WId QWaylandWindow::winId() const
@@ -122,6 +127,7 @@ void QWaylandWindow::setVisible(bool visible)
 
     if (visible) {
         if (mBuffer) {
+            flushPendingProperties();
             wl_surface_attach(mSurface, mBuffer->buffer(),0,0);
             QWindowSystemInterface::handleSynchronousExposeEvent(window(), QRect(QPoint(), geometry().size()));
         }
@@ -148,6 +154,7 @@ void QWaylandWindow::attach(QWaylandBuffer *buffer)
     mBuffer = buffer;
 
     if (window()->isVisible()) {
+        flushPendingProperties();
         wl_surface_attach(mSurface, mBuffer->buffer(),0,0);
         if (buffer)
             QWindowSystemInterface::handleSynchronousExposeEvent(window(), QRect(QPoint(), geometry().size()));
@@ -155,17 +162,56 @@ void QWaylandWindow::attach(QWaylandBuffer *buffer)
 }
 
 void QWaylandWindow::damage(const QRect &rect)
+{
+    damage(QVector<QRect>() << rect);
+}
+
+// All the damage of one frame, so that the frame is only accounted for once
+void QWaylandWindow::damage(const QVector<QRect> &rects)
 {
     //We have to do sync stuff before calling damage, or we might
     //get a frame callback before we get the timestamp
+    requestFrameCallback();
+
+    foreach (const QRect &rect, rects)
+        wl_surface_damage(mSurface,
+                          rect.x(), rect.y(), rect.width(), rect.height());
+}
+
+// Properties set before a frame have to reach the compositor before the
+// frame does, not only when the event loop next goes idle
+void QWaylandWindow::flushPendingProperties()
+{
+    if (mExtendedWindow)
+        mExtendedWindow->flushPendingProperties();
+}
+
+void QWaylandWindow::requestFrameCallback()
+{
+    // Called for every new frame, just before it is committed
+    flushPendingProperties();
+
+    if (QWaylandLatencyProbe *probe = mDisplay->latencyProbe())
+        probe->frameCommitted(this);
+
     if (!mWaitingForFrameSync) {
         mFrameCallback = wl_surface_frame(mSurface);
         wl_callback_add_listener(mFrameCallback,&QWaylandWindow::callbackListener,this);
         mWaitingForFrameSync = true;
     }
+}
+
+void QWaylandWindow::requestUpdate()
+{
+    // Without a frame in flight there is nothing to pace against,
+    // so the window may render right away.
+    if (!mWaitingForFrameSync) {
+        mUpdateRequested = false;
+        QCoreApplication::postEvent(window(), new QEvent(QEvent::UpdateRequest));
+        return;
+    }
 
-    wl_surface_damage(mSurface,
-                      rect.x(), rect.y(), rect.width(), rect.height());
+    mUpdateRequested = true;
 }
 
 const wl_callback_listener QWaylandWindow::callbackListener = {
@@ -182,6 +228,10 @@ void QWaylandWindow::frameCallback(void *data, struct wl_callback *wl_callback,
         wl_callback_destroy(self->mFrameCallback);
         self->mFrameCallback = 0;
     }
+    if (self->mUpdateRequested) {
+        self->mUpdateRequested = false;
+        QCoreApplication::postEvent(self->window(), new QEvent(QEvent::UpdateRequest));
+    }
 }
 
 void QWaylandWindow::waitForFrameSync()
@@ -76,9 +76,13 @@ public:
 
     void attach(QWaylandBuffer *buffer);
     void damage(const QRect &rect);
+    void damage(const QVector<QRect> &rects);
 
+    void requestFrameCallback();
     void waitForFrameSync();
 
+    void requestUpdate();
+
     struct wl_surface *wl_surface() const { return mSurface; }
 
     QWaylandShellSurface *shellSurface() const;
@@ -103,8 +107,11 @@ protected:
     bool mWaitingForFrameSync;
     struct wl_callback *mFrameCallback;
     QWaitCondition mFrameSyncWait;
+    bool mUpdateRequested;
 
 private:
+    void flushPendingProperties();
+
     static const wl_callback_listener callbackListener;
     static void frameCallback(void *data, struct wl_callback *wl_callback, uint32_t time);
 
@@ -13,6 +13,8 @@ SOURCES =   main.cpp \
             qwaylandnativeinterface.cpp \
             qwaylandshmbackingstore.cpp \
             qwaylandinputdevice.cpp \
+            qwaylandkeymap.cpp \
+            qwaylandlatencyprobe.cpp \
             qwaylandcursor.cpp \
             qwaylanddisplay.cpp \
             qwaylandwindow.cpp \
@@ -29,7 +31,9 @@ SOURCES =   main.cpp \
             qwaylandextendedsurface.cpp \
             qwaylandsubsurface.cpp \
             qwaylandtouch.cpp \
-            $$PWD/../../../shared/qwaylandmimehelper.cpp
+            $$PWD/../../../shared/qwaylandmimehelper.cpp \
+            $$PWD/../../../shared/qwaylandlatencyhistogram.cpp \
+            $$PWD/../../../shared/qwaylandpropertybatch.cpp
 
 HEADERS =   qwaylandintegration.h \
             qwaylandnativeinterface.h \
@@ -51,7 +55,11 @@ HEADERS =   qwaylandintegration.h \
             qwaylandextendedsurface.h \
             qwaylandsubsurface.h \
             qwaylandtouch.h \
-            $$PWD/../../../shared/qwaylandmimehelper.h
+            qwaylandkeymap.h \
+            qwaylandlatencyprobe.h \
+            $$PWD/../../../shared/qwaylandmimehelper.h \
+            $$PWD/../../../shared/qwaylandlatencyhistogram.h \
+            $$PWD/../../../shared/qwaylandpropertybatch.h
 
 DEFINES += Q_PLATFORM_WAYLAND
 
@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the plugins of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.LGPL included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights. These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU General
+** Public License version 3.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of this
+** file. Please review the following information to ensure the GNU General
+** Public License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** Other Usage
+** Alternatively, this file may be used in accordance with the terms and
+** conditions contained in a signed written agreement between you and Nokia.
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qwaylandlatencyhistogram.h"
+
+QWaylandLatencyHistogram::QWaylandLatencyHistogram()
+    : m_buckets(BucketCount + 1)
+    , m_count(0)
+    , m_max(0)
+{
+}
+
+void QWaylandLatencyHistogram::add(qint64 usecs)
+{
+    if (usecs < 0)
+        usecs = 0;
+    ++m_buckets[qMin<qint64>(usecs / BucketSize, BucketCount)];
+    ++m_count;
+    m_max = qMax(m_max, usecs);
+}
+
+void QWaylandLatencyHistogram::clear()
+{
+    m_buckets.fill(0);
+    m_count = 0;
+    m_max = 0;
+}
+
+// Upper bound of the bucket holding the given percentile, in microseconds
+qint64 QWaylandLatencyHistogram::percentile(int percent) const
+{
+    if (!m_count)
+        return 0;
+    const qint64 rank = (qint64(m_count) * percent + 99) / 100;
+    qint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += m_buckets.at(i);
+        if (seen >= rank)
+            return qMin<qint64>(qint64(i + 1) * BucketSize, m_max);
+    }
+    return m_max;
+}
+
+QString QWaylandLatencyHistogram::summary() const
+{
+    return QString::fromLatin1("n=%1 p50=%2ms p90=%3ms p99=%4ms max=%5ms")
+            .arg(m_count)
+            .arg(percentile(50) / 1000.0, 0, 'f', 2)
+            .arg(percentile(90) / 1000.0, 0, 'f', 2)
+            .arg(percentile(99) / 1000.0, 0, 'f', 2)
+            .arg(m_max / 1000.0, 0, 'f', 2);
+}
@@ -0,0 +1,73 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the plugins of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.LGPL included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights. These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU General
+** Public License version 3.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of this
+** file. Please review the following information to ensure the GNU General
+** Public License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** Other Usage
+** Alternatively, this file may be used in accordance with the terms and
+** conditions contained in a signed written agreement between you and Nokia.
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QWAYLANDLATENCYHISTOGRAM_H
+#define QWAYLANDLATENCYHISTOGRAM_H
+
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+// Fixed size histogram of latencies in microseconds, with 250us buckets
+// up to 100ms. Used by the input latency probes of the compositor and
+// the client plugin.
+class QWaylandLatencyHistogram
+{
+public:
+    QWaylandLatencyHistogram();
+
+    void add(qint64 usecs);
+    void clear();
+
+    int count() const { return m_count; }
+    qint64 maximum() const { return m_max; }
+    qint64 percentile(int percent) const;
+
+    QString summary() const;
+
+private:
+    enum { BucketSize = 250, BucketCount = 400 };
+
+    QVector<int> m_buckets; // the last one collects everything above 100ms
+    int m_count;
+    qint64 m_max;
+};
+
+#endif
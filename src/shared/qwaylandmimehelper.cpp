@@ -45,39 +45,163 @@
 #include <QUrl>
 #include <QBuffer>
 #include <QImageWriter>
+#include <QRunnable>
 
-QByteArray QWaylandMimeHelper::getByteArray(QMimeData *mimeData, const QString &mimeType)
+// What getByteArray() needs from the mime data for one type. The mime data
+// belongs to the application and may hold a QPixmap, so it is only read on
+// the thread calling getByteArray() or QWaylandMimeCache::lookup().
+struct QWaylandMimeSnapshot
+{
+    QWaylandMimeSnapshot(QMimeData *mimeData, const QString &mimeType);
+    QByteArray encode() const;
+
+    QString mimeType;
+    QString text;
+    QList<QUrl> urls;
+    QImage image;
+    QColor color;
+    QByteArray data;
+};
+
+QWaylandMimeSnapshot::QWaylandMimeSnapshot(QMimeData *mimeData, const QString &type)
+    : mimeType(type)
+{
+    if (mimeType == QLatin1String("text/plain")) {
+        text = mimeData->text();
+    } else if (mimeType == QLatin1String("application/x-qt-image")
+               || mimeType.startsWith(QLatin1String("image/"))) {
+        if (mimeData->hasImage())
+            image = qvariant_cast<QImage>(mimeData->imageData());
+        else
+            data = mimeData->data(mimeType);
+    } else if (mimeType == QLatin1String("application/x-color")) {
+        color = qvariant_cast<QColor>(mimeData->colorData());
+    } else if (mimeType == QLatin1String("text/uri-list")) {
+        urls = mimeData->urls();
+    } else {
+        data = mimeData->data(mimeType);
+    }
+}
+
+QByteArray QWaylandMimeSnapshot::encode() const
 {
     QByteArray content;
     if (mimeType == QLatin1String("text/plain")) {
-        content = mimeData->text().toUtf8();
-    } else if (mimeData->hasImage()
-               && (mimeType == QLatin1String("application/x-qt-image")
-                   || mimeType.startsWith(QLatin1String("image/")))) {
-        QImage image = qvariant_cast<QImage>(mimeData->imageData());
-        if (!image.isNull()) {
-            QBuffer buf;
-            buf.open(QIODevice::ReadWrite);
-            QByteArray fmt = "BMP";
-            if (mimeType.startsWith(QLatin1String("image/"))) {
-                QByteArray imgFmt = mimeType.mid(6).toUpper().toLatin1();
-                if (QImageWriter::supportedImageFormats().contains(imgFmt))
-                    fmt = imgFmt;
-            }
-            QImageWriter wr(&buf, fmt);
-            wr.write(image);
-            content = buf.buffer();
+        content = text.toUtf8();
+    } else if (!image.isNull()) {
+        QBuffer buf;
+        buf.open(QIODevice::ReadWrite);
+        QByteArray fmt = "BMP";
+        if (mimeType.startsWith(QLatin1String("image/"))) {
+            QByteArray imgFmt = mimeType.mid(6).toUpper().toLatin1();
+            if (QImageWriter::supportedImageFormats().contains(imgFmt))
+                fmt = imgFmt;
         }
+        QImageWriter wr(&buf, fmt);
+        wr.write(image);
+        content = buf.buffer();
     } else if (mimeType == QLatin1String("application/x-color")) {
-        content = qvariant_cast<QColor>(mimeData->colorData()).name().toLatin1();
+        content = color.name().toLatin1();
     } else if (mimeType == QLatin1String("text/uri-list")) {
-        QList<QUrl> urls = mimeData->urls();
         for (int i = 0; i < urls.count(); ++i) {
             content.append(urls.at(i).toEncoded());
             content.append('\n');
         }
     } else {
-        content = mimeData->data(mimeType);
+        content = data;
     }
     return content;
 }
+
+QByteArray QWaylandMimeHelper::getByteArray(QMimeData *mimeData, const QString &mimeType)
+{
+    return QWaylandMimeSnapshot(mimeData, mimeType).encode();
+}
+
+// Types getByteArray() converts instead of returning the data as is
+bool QWaylandMimeHelper::isConverted(const QString &mimeType)
+{
+    return mimeType == QLatin1String("text/plain")
+            || mimeType == QLatin1String("text/uri-list")
+            || mimeType == QLatin1String("application/x-color")
+            || mimeType == QLatin1String("application/x-qt-image")
+            || mimeType.startsWith(QLatin1String("image/"));
+}
+
+class QWaylandMimeConversion : public QRunnable
+{
+public:
+    QWaylandMimeConversion(QWaylandMimeCache *cache, uint generation, QMimeData *mimeData, const QString &mimeType)
+        : m_cache(cache), m_generation(generation), m_snapshot(mimeData, mimeType)
+    {
+    }
+
+    void run()
+    {
+        QByteArray content = m_snapshot.encode();
+        QMetaObject::invokeMethod(m_cache, "conversionFinished", Qt::QueuedConnection,
+                                  Q_ARG(uint, m_generation), Q_ARG(QString, m_snapshot.mimeType),
+                                  Q_ARG(QByteArray, content));
+    }
+
+private:
+    QWaylandMimeCache *m_cache;
+    uint m_generation;
+    QWaylandMimeSnapshot m_snapshot;
+};
+
+QWaylandMimeCache::QWaylandMimeCache(QObject *parent)
+    : QObject(parent)
+    , m_mimeData(0)
+    , m_generation(0)
+{
+}
+
+QWaylandMimeCache::~QWaylandMimeCache()
+{
+    m_pool.waitForDone();
+}
+
+// Conversions still running work on their own copy of the data, their
+// results are dropped as they belong to an older generation.
+void QWaylandMimeCache::setMimeData(QMimeData *mimeData)
+{
+    m_mimeData = mimeData;
+    ++m_generation;
+    m_converted.clear();
+    m_running.clear();
+}
+
+bool QWaylandMimeCache::lookup(const QString &mimeType, QByteArray *content)
+{
+    if (!m_mimeData) {
+        *content = QByteArray();
+        return true;
+    }
+    if (!QWaylandMimeHelper::isConverted(mimeType)) {
+        *content = m_mimeData->data(mimeType);
+        return true;
+    }
+
+    QHash<QString, QByteArray>::const_iterator it = m_converted.constFind(mimeType);
+    if (it != m_converted.constEnd()) {
+        *content = it.value();
+        return true;
+    }
+
+    // Requests arriving while the type is being converted share the result
+    if (!m_running.contains(mimeType)) {
+        m_running.insert(mimeType);
+        m_pool.start(new QWaylandMimeConversion(this, m_generation, m_mimeData, mimeType));
+    }
+    return false;
+}
+
+void QWaylandMimeCache::conversionFinished(uint generation, const QString &mimeType, const QByteArray &content)
+{
+    if (generation != m_generation)
+        return;
+    m_running.remove(mimeType);
+    m_converted.insert(mimeType, content);
+    emit converted(mimeType, content);
+}
@@ -44,12 +44,47 @@
 
 #include <QString>
 #include <QByteArray>
+#include <QHash>
 #include <QMimeData>
+#include <QSet>
+#include <QThreadPool>
 
 class QWaylandMimeHelper
 {
 public:
     static QByteArray getByteArray(QMimeData *mimeData, const QString &mimeType);
+    static bool isConverted(const QString &mimeType);
+};
+
+// Remembers what getByteArray() returned for one QMimeData, so that every
+// receiver of a selection after the first gets the same bytes without
+// encoding them again. lookup() copies what it needs from the mime data and
+// encodes it on a worker thread; it either returns the data right away or
+// converted() is emitted once it is ready.
+class QWaylandMimeCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QWaylandMimeCache(QObject *parent = 0);
+    ~QWaylandMimeCache();
+
+    void setMimeData(QMimeData *mimeData);
+    QMimeData *mimeData() const { return m_mimeData; }
+
+    bool lookup(const QString &mimeType, QByteArray *content);
+
+signals:
+    void converted(const QString &mimeType, const QByteArray &content);
+
+private slots:
+    void conversionFinished(uint generation, const QString &mimeType, const QByteArray &content);
+
+private:
+    QMimeData *m_mimeData;
+    uint m_generation;
+    QHash<QString, QByteArray> m_converted;
+    QSet<QString> m_running;
+    QThreadPool m_pool;
 };
 
 #endif
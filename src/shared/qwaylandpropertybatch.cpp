@@ -0,0 +1,315 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the plugins of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.LGPL included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights. These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU General
+** Public License version 3.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of this
+** file. Please review the following information to ensure the GNU General
+** Public License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** Other Usage
+** Alternatively, this file may be used in accordance with the terms and
+** conditions contained in a signed written agreement between you and Nokia.
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qwaylandpropertybatch.h"
+
+#include <QtCore/QDataStream>
+
+#include <string.h>
+
+namespace {
+
+enum {
+    TypeInvalid = 0,
+    TypeBool = 1,
+    TypeInt = 2,
+    TypeUInt = 3,
+    TypeLongLong = 4,
+    TypeDouble = 5,
+    TypeString = 6,
+    TypeByteArray = 7,
+    TypeVariant = 8,
+
+    TypeMask = 0x7f,
+    NameFollows = 0x80
+};
+
+// Names after the first 65535 are sent inline every time
+const quint16 NoNameId = 0xffff;
+
+template <typename T>
+void append(QByteArray *batch, T value)
+{
+    batch->append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void appendData(QByteArray *batch, const QByteArray &data)
+{
+    append<quint32>(batch, data.size());
+    batch->append(data);
+}
+
+class BatchReader
+{
+public:
+    BatchReader(const void *data, int size)
+        : m_data(static_cast<const char *>(data)), m_size(size), m_pos(0) { }
+
+    bool atEnd() const { return m_pos >= m_size; }
+
+    template <typename T>
+    bool read(T *value)
+    {
+        if (m_size - m_pos < int(sizeof(T)))
+            return false;
+        memcpy(value, m_data + m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return true;
+    }
+
+    bool readData(int length, QByteArray *data)
+    {
+        if (length < 0 || m_size - m_pos < length)
+            return false;
+        *data = QByteArray(m_data + m_pos, length);
+        m_pos += length;
+        return true;
+    }
+
+    bool readData(QByteArray *data)
+    {
+        quint32 length;
+        return read(&length) && length <= quint32(m_size) && readData(int(length), data);
+    }
+
+private:
+    const char *m_data;
+    int m_size;
+    int m_pos;
+};
+
+bool readValue(BatchReader *reader, int type, QVariant *value)
+{
+    switch (type) {
+    case TypeInvalid:
+        *value = QVariant();
+        return true;
+    case TypeBool: {
+        quint8 v;
+        if (!reader->read(&v))
+            return false;
+        *value = QVariant(v != 0);
+        return true;
+    }
+    case TypeInt: {
+        qint32 v;
+        if (!reader->read(&v))
+            return false;
+        *value = QVariant(int(v));
+        return true;
+    }
+    case TypeUInt: {
+        quint32 v;
+        if (!reader->read(&v))
+            return false;
+        *value = QVariant(uint(v));
+        return true;
+    }
+    case TypeLongLong: {
+        qint64 v;
+        if (!reader->read(&v))
+            return false;
+        *value = QVariant(qlonglong(v));
+        return true;
+    }
+    case TypeDouble: {
+        double v;
+        if (!reader->read(&v))
+            return false;
+        *value = QVariant(v);
+        return true;
+    }
+    case TypeString: {
+        QByteArray utf8;
+        if (!reader->readData(&utf8))
+            return false;
+        *value = QVariant(QString::fromUtf8(utf8.constData(), utf8.size()));
+        return true;
+    }
+    case TypeByteArray: {
+        QByteArray data;
+        if (!reader->readData(&data))
+            return false;
+        *value = QVariant(data);
+        return true;
+    }
+    case TypeVariant: {
+        QByteArray data;
+        if (!reader->readData(&data))
+            return false;
+        QDataStream ds(&data, QIODevice::ReadOnly);
+        ds >> *value;
+        return ds.status() == QDataStream::Ok;
+    }
+    default:
+        return false;
+    }
+}
+
+}
+
+bool QWaylandPropertyEncoder::add(const QString &name, const QVariant &value)
+{
+    quint8 type;
+    switch (value.type()) {
+    case QVariant::Invalid: type = TypeInvalid; break;
+    case QVariant::Bool: type = TypeBool; break;
+    case QVariant::Int: type = TypeInt; break;
+    case QVariant::UInt: type = TypeUInt; break;
+    case QVariant::LongLong: type = TypeLongLong; break;
+    case QVariant::Double: type = TypeDouble; break;
+    case QVariant::String: type = TypeString; break;
+    case QVariant::ByteArray: type = TypeByteArray; break;
+    default: type = TypeVariant; break;
+    }
+
+    // The name is only interned once the entry is known to fit, the peer
+    // numbers names in the order it sees them
+    QByteArray entry;
+    bool intern = false;
+    QHash<QString, quint16>::const_iterator it = m_names.constFind(name);
+    if (it != m_names.constEnd()) {
+        append<quint16>(&entry, it.value());
+        append<quint8>(&entry, type);
+    } else {
+        quint16 id = NoNameId;
+        if (m_names.size() < NoNameId) {
+            id = m_names.size();
+            intern = true;
+        }
+        QByteArray utf8 = name.toUtf8();
+        append<quint16>(&entry, id);
+        append<quint8>(&entry, type | NameFollows);
+        append<quint16>(&entry, utf8.size());
+        entry.append(utf8);
+    }
+
+    switch (type) {
+    case TypeInvalid:
+        break;
+    case TypeBool:
+        append<quint8>(&entry, value.toBool());
+        break;
+    case TypeInt:
+        append<qint32>(&entry, value.toInt());
+        break;
+    case TypeUInt:
+        append<quint32>(&entry, value.toUInt());
+        break;
+    case TypeLongLong:
+        append<qint64>(&entry, value.toLongLong());
+        break;
+    case TypeDouble:
+        append<double>(&entry, value.toDouble());
+        break;
+    case TypeString:
+        appendData(&entry, value.toString().toUtf8());
+        break;
+    case TypeByteArray:
+        appendData(&entry, value.toByteArray());
+        break;
+    default: {
+        QByteArray data;
+        QDataStream ds(&data, QIODevice::WriteOnly);
+        ds << value;
+        appendData(&entry, data);
+        break;
+    }
+    }
+
+    if (entry.size() > MaxBatchSize)
+        return false;
+    if (intern)
+        m_names.insert(name, m_names.size());
+
+    if (!m_batch.isEmpty() && m_batch.size() + entry.size() > MaxBatchSize) {
+        m_batches.append(m_batch);
+        m_batch.clear();
+    }
+    m_batch.append(entry);
+    return true;
+}
+
+QList<QByteArray> QWaylandPropertyEncoder::takeBatches()
+{
+    QList<QByteArray> batches = m_batches;
+    if (!m_batch.isEmpty())
+        batches.append(m_batch);
+    m_batches.clear();
+    m_batch.clear();
+    return batches;
+}
+
+bool QWaylandPropertyDecoder::decode(const void *data, int size, PropertyList *properties)
+{
+    BatchReader reader(data, size);
+    while (!reader.atEnd()) {
+        quint16 id;
+        quint8 type;
+        if (!reader.read(&id) || !reader.read(&type))
+            return false;
+
+        QString name;
+        if (type & NameFollows) {
+            quint16 length;
+            QByteArray utf8;
+            if (!reader.read(&length) || !reader.readData(length, &utf8))
+                return false;
+            name = QString::fromUtf8(utf8.constData(), utf8.size());
+            if (id != NoNameId) {
+                // Names are numbered in the order they are first sent
+                if (id != m_names.size())
+                    return false;
+                m_names.append(name);
+            }
+        } else {
+            if (id >= m_names.size())
+                return false;
+            name = m_names.at(id);
+        }
+
+        QVariant value;
+        if (!readValue(&reader, type & TypeMask, &value))
+            return false;
+        properties->append(qMakePair(name, value));
+    }
+    return true;
+}
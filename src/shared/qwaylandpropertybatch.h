@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/
+**
+** This file is part of the plugins of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.LGPL included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights. These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU General
+** Public License version 3.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of this
+** file. Please review the following information to ensure the GNU General
+** Public License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** Other Usage
+** Alternatively, this file may be used in accordance with the terms and
+** conditions contained in a signed written agreement between you and Nokia.
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QWAYLANDPROPERTYBATCH_H
+#define QWAYLANDPROPERTYBATCH_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QPair>
+#include <QtCore/QString>
+#include <QtCore/QVariant>
+#include <QtCore/QVector>
+
+// Encoding of the window property batches of wl_extended_surface version 2,
+// the format is described in surface-extension.xml. Each end keeps one
+// encoder and one decoder per extended surface, because the names are
+// interned for the lifetime of the wl_extended_surface object.
+class QWaylandPropertyEncoder
+{
+public:
+    // Older libwayland versions marshal each message into a small fixed
+    // buffer, so changes are split into batches of at most this many bytes.
+    // A single property larger than that is not added, add() returns false
+    // and the caller has to send it on its own.
+    enum { MaxBatchSize = 768 };
+
+    bool add(const QString &name, const QVariant &value);
+
+    bool isEmpty() const { return m_batch.isEmpty() && m_batches.isEmpty(); }
+    QList<QByteArray> takeBatches();
+
+private:
+    QHash<QString, quint16> m_names;
+    QByteArray m_batch;
+    QList<QByteArray> m_batches;
+};
+
+class QWaylandPropertyDecoder
+{
+public:
+    typedef QList<QPair<QString, QVariant> > PropertyList;
+
+    // Returns false if the batch is malformed, properties then holds the
+    // entries that were decoded before the error.
+    bool decode(const void *data, int size, PropertyList *properties);
+
+private:
+    QVector<QString> m_names;
+};
+
+#endif